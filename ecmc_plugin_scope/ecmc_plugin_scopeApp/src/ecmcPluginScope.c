@@ -21,6 +21,8 @@ extern "C" {
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <math.h>
 
 #include "ecmcPluginDefs.h"
 #include "ecmcScopeDefs.h"
@@ -29,6 +31,17 @@ extern "C" {
 static int    lastEcmcError   = 0;
 static char*  lastConfStr         = NULL;
 
+/** Plc arguments are doubles, converted to int only if in range
+ *  (0..INT_MAX, NaN is out of range). Returns 0 if out of range.
+ **/
+static int plcArgToInt(double arg, int *value) {
+  if(!(arg >= 0 && arg <= INT_MAX)) {
+    return 0;
+  }
+  *value = (int)arg;
+  return 1;
+}
+
 /** Optional. 
  *  Will be called once after successfull load into ecmc.
  *  Return value other than 0 will be considered error.
@@ -63,7 +76,7 @@ void scopeDestruct(void)
 int scopeRealtime(int ecmcError)
 { 
   lastEcmcError = ecmcError;  
-  return executeScopes();
+  return executeScopes(ecmcError);
 }
 
 /** Link to data source here since all sources should be availabe at this stage
@@ -88,13 +101,88 @@ int scopeExitRT(void){
 
 // Plc function for enable
 double scope_enable(double index, double enable) {
-  return (double)enableScope((int)index, (int)enable);
+  int i = 0, e = 0;
+  if(!plcArgToInt(index, &i) || !plcArgToInt(enable, &e)) {
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }
+  return (double)enableScope(i, e);
 }
 
-// // Plc function for trigg new measurement (will clear buffers)
-// double scope_trigg(double index) {
-//   return (double)triggScope((int)index);
-// }
+// Plc function for software trigger (start of current ethercat cycle)
+double scope_trigg(double index) {
+  int i = 0;
+  if(!plcArgToInt(index, &i)) {
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }
+  return (double)triggScope(i);
+}
+
+// Plc function for arm (single shot or continuous)
+double scope_arm(double index, double singleShot) {
+  int i = 0, s = 0;
+  if(!plcArgToInt(index, &i) || !plcArgToInt(singleShot, &s)) {
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }
+  return (double)armScope(i, s);
+}
+
+// Plc function for acquisition mode
+double scope_set_mode(double index, double mode) {
+  int i = 0, m = 0;
+  if(!plcArgToInt(index, &i) || !plcArgToInt(mode, &m)) {
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }
+  return (double)setScopeMode(i, m);
+}
+
+// Plc function for status (-1 on error)
+double scope_get_status(double index) {
+  int i = 0, status = 0;
+  if(!plcArgToInt(index, &i) || getScopeStatus(i, &status)) {
+    return ECMC_PLUGIN_SCOPE_PLC_ERROR_VALUE;
+  }
+  return (double)status;
+}
+
+// Plc function for trigger (capture) counter (-1 on error)
+double scope_get_count(double index) {
+  int i = 0, count = 0;
+  if(!plcArgToInt(index, &i) || getScopeTriggerCount(i, &count)) {
+    return ECMC_PLUGIN_SCOPE_PLC_ERROR_VALUE;
+  }
+  return (double)count;
+}
+
+// Plc function for statistics of last capture (NaN on error)
+double scope_get_stat(double index, double stat) {
+  int i = 0, s = 0;
+  double value = 0;
+  if(!plcArgToInt(index, &i) || !plcArgToInt(stat, &s) ||
+     getScopeStatistic(i, s, &value)) {
+    return NAN;
+  }
+  return value;
+}
+
+// Plc function for element of last capture (NaN on error)
+double scope_get_value(double index, double element) {
+  int i = 0, e = 0;
+  double value = 0;
+  if(!plcArgToInt(index, &i) || !plcArgToInt(element, &e) ||
+     getScopeResultElement(i, e, &value)) {
+    return NAN;
+  }
+  return value;
+}
+
+// Plc function for freeze of flight recorder
+double scope_freeze(double index) {
+  int i = 0;
+  if(!plcArgToInt(index, &i)) {
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }
+  return (double)freezeScope(i);
+}
 
 // Register data for plugin so ecmc know what to use
 struct ecmcPluginData pluginDataDef = {
@@ -106,11 +194,45 @@ struct ecmcPluginData pluginDataDef = {
   .desc = "Scope plugin for use with ecmc.",
   // Option description
   .optionDesc = "\n    "ECMC_PLUGIN_DBG_PRINT_OPTION_CMD"<1/0>    : Enables/disables printouts from plugin, default = disabled.\n"
-                "    "ECMC_PLUGIN_SOURCE_OPTION_CMD"<source>    : Ec source variable (example: ec0.s1.mm.CH1_ARRAY).\n"
+                "    "ECMC_PLUGIN_SOURCE_OPTION_CMD"<source>    : Ec source variable (example: ec0.s1.mm.CH1_ARRAY). Several bit sources separated by ',' (logic analyzer).\n"
                 "    "ECMC_PLUGIN_RESULT_ELEMENTS_OPTION_CMD"<Result buffer size>        : Data points to collect, default = 4096.\n"
                 "    "ECMC_PLUGIN_SOURCE_NEXTTIME_OPTION_CMD"<nexttime>   : Ec next sync time for source (example: ec0.s1.NEXTTIME)\n"
-                "    "ECMC_PLUGIN_TRIGG_OPTION_CMD"<trigger>   : Ec trigg time (example: ec0.s2.LATCH_POS).\n"
+                "    "ECMC_PLUGIN_TRIGG_OPTION_CMD"<trigger>   : Ec trigg time (example: ec0.s2.LATCH_POS). Several sources separated by ','.\n"
+                "    "ECMC_PLUGIN_TRIGG_LOGIC_OPTION_CMD"<OR/AND/SEQ>   : Combination of trigger sources, default = OR.\n"
+                "    "ECMC_PLUGIN_TRIGG_WINDOW_OPTION_CMD"<ns>   : AND: max time between source events, default = ecmc sample time.\n"
+                "    "ECMC_PLUGIN_TRIGG_TIMEOUT_OPTION_CMD"<ns>   : SEQ: max time between source events, default = 1s.\n"
+                "    "ECMC_PLUGIN_TRIGG_HOLDOFF_OPTION_CMD"<ns>   : Triggers within holdoff time are disregarded, default = 0.\n"
+                "    "ECMC_PLUGIN_TRIGG_PRESCALE_OPTION_CMD"<n>   : Use every n:th trigger, default = 1.\n"
+                "    "ECMC_PLUGIN_TRIGG_DELAY_OPTION_CMD"<n>[NS/SAMPLES]   : Capture starts at trigger + delay, default = 0.\n"
+                "    "ECMC_PLUGIN_TRIGG_TYPE_OPTION_CMD"<LATCH/CHANGE/RISING/FALLING/CROSS>   : Trigger on timestamp or on value of any data item, default = LATCH.\n"
+                "    "ECMC_PLUGIN_TRIGG_LEVEL_OPTION_CMD"<value>   : RISING/FALLING/CROSS: level, default = 0.\n"
                 "    "ECMC_PLUGIN_ENABLE_OPTION_CMD"<1/0>   : Enable data acq, defaults to enabled.\n"
+                "    "ECMC_PLUGIN_COMPRESS_OPTION_CMD"<0/1/2>   : Compressed result output (0=off, 1=delta, 2=second order delta), default = off.\n"
+                "    "ECMC_PLUGIN_MODE_OPTION_CMD"<NORMAL/SINGLE/AUTO/ROLL>   : Acquisition mode, default = NORMAL.\n"
+                "    "ECMC_PLUGIN_AUTO_TIMEOUT_OPTION_CMD"<ms>   : AUTO mode: free run capture if no trigger within timeout, default = 1000.\n"
+                "    "ECMC_PLUGIN_ROLL_CYCLES_OPTION_CMD"<cycles>   : ROLL mode: publish sliding window every n:th cycle, default = 100.\n"
+                "    "ECMC_PLUGIN_GAP_POLICY_OPTION_CMD"<FLAG/FILL/ABORT>   : Lost or repeated frames during capture, default = FLAG.\n"
+                "    "ECMC_PLUGIN_GAP_FILL_VALUE_OPTION_CMD"<value>   : FILL: value of lost samples, default = 0.\n"
+                "    "ECMC_PLUGIN_ETS_FACTOR_OPTION_CMD"<n>   : Equivalent time sampling grid factor (0=off), default = off.\n"
+                "    "ECMC_PLUGIN_ETS_CAPTURES_OPTION_CMD"<n>   : Captures folded per equivalent time sampling result, default = 100.\n"
+                "    "ECMC_PLUGIN_EXEC_CYCLES_OPTION_CMD"<cycles>   : Process recorded scans every n:th cycle (sub rate), default = 1.\n"
+                "    "ECMC_PLUGIN_PERSIST_BINS_OPTION_CMD"<n>   : Persistence image amplitude bins (0=off), default = off.\n"
+                "    "ECMC_PLUGIN_PERSIST_MIN_OPTION_CMD"<value>   : Persistence image amplitude of first bin.\n"
+                "    "ECMC_PLUGIN_PERSIST_MAX_OPTION_CMD"<value>   : Persistence image amplitude end of last bin.\n"
+                "    "ECMC_PLUGIN_PERSIST_DECAY_OPTION_CMD"<0..1>   : Persistence decay per published image, default = 1 (no decay).\n"
+                "    "ECMC_PLUGIN_PERSIST_PUBLISH_OPTION_CMD"<ms>   : Persistence image publish period, default = 1000.\n"
+                "    "ECMC_PLUGIN_RECORDER_CAPTURES_OPTION_CMD"<n>   : Flight recorder: last captures kept (0=off), default = off.\n"
+                "    "ECMC_PLUGIN_RECORDER_HISTORY_OPTION_CMD"<cycles>   : Flight recorder: continuous history of source scans, default = 0.\n"
+                "    "ECMC_PLUGIN_RECORDER_FREEZE_ERROR_OPTION_CMD"<1/0>   : Flight recorder: freeze on ecmc error, default = enabled.\n"
+                "    "ECMC_PLUGIN_VIEW_POINTS_OPTION_CMD"<n>   : Windowed readout: max points (0=off), default = off.\n"
+                "    "ECMC_PLUGIN_CONTEXT_OPTION_CMD"<items>   : Ecmc data items snapshot at trigger and published with capture (separated by ',').\n"
+                "    "ECMC_PLUGIN_CHUNK_ELEMENTS_OPTION_CMD"<n>   : Large capture mode: publish capture in chunks while collecting (0=off), default = off.\n"
+                "    "ECMC_PLUGIN_CONFIG_FILE_OPTION_CMD"<file>   : Create one scope per line of file (other options of load are shared defaults).\n"
+                "    "ECMC_PLUGIN_REPLAY_FILE_OPTION_CMD"<file>   : Offline replay: process recorded cycles of file (replaces SOURCE, TRIGG and SOURCE_NEXTTIME).\n"
+                "    "ECMC_PLUGIN_REPLAY_OUTPUT_OPTION_CMD"<file>   : Offline replay: captures written to file (structured captures).\n"
+                "    "ECMC_PLUGIN_MASK_OPTION_CMD"<1/0>   : Mask test of each capture against upper and lower envelope, default = disabled.\n"
+                "    "ECMC_PLUGIN_MASK_FREEZE_OPTION_CMD"<1/0>   : Mask test: freeze flight recorder on failed test, default = disabled.\n"
+                "    "ECMC_PLUGIN_STATS_OPTION_CMD"<1/0>   : Statistics of each capture (scope_get_stat()), default = disabled.\n"
                 , 
   // Plugin version
   .version = ECMC_EXAMPLE_PLUGIN_VERSION,
@@ -126,7 +248,7 @@ struct ecmcPluginData pluginDataDef = {
   .realtimeExitFnc = scopeExitRT,
   // PLC funcs
   .funcs[0] =
-      { /*----fft_clear----*/
+      { /*----scope_enable----*/
         // Function name (this is the name you use in ecmc plc-code)
         .funcName = "scope_enable",
         // Function description
@@ -148,6 +270,190 @@ struct ecmcPluginData pluginDataDef = {
         .funcArg10 = NULL,
         .funcGenericObj = NULL,
       },
+  .funcs[1] =
+      { /*----scope_trigg----*/
+        // Function name (this is the name you use in ecmc plc-code)
+        .funcName = "scope_trigg",
+        // Function description
+        .funcDesc = "scope_trigg(index) : Software trigger of scope[index].",
+        /**
+        * 12 different prototypes allowed (only doubles since reg in plc).
+        * Only funcArg${argCount} func shall be assigned the rest set to NULL.
+        **/
+        .funcArg0 = NULL,
+        .funcArg1 = scope_trigg,
+        .funcArg2 = NULL,
+        .funcArg3 = NULL,
+        .funcArg4 = NULL,
+        .funcArg5 = NULL,
+        .funcArg6 = NULL,
+        .funcArg7 = NULL,
+        .funcArg8 = NULL,
+        .funcArg9 = NULL,
+        .funcArg10 = NULL,
+        .funcGenericObj = NULL,
+      },
+  .funcs[2] =
+      { /*----scope_arm----*/
+        // Function name (this is the name you use in ecmc plc-code)
+        .funcName = "scope_arm",
+        // Function description
+        .funcDesc = "scope_arm(index,single) : Arm scope[index] (single=1: one capture then wait for re-arm).",
+        /**
+        * 12 different prototypes allowed (only doubles since reg in plc).
+        * Only funcArg${argCount} func shall be assigned the rest set to NULL.
+        **/
+        .funcArg0 = NULL,
+        .funcArg1 = NULL,
+        .funcArg2 = scope_arm,
+        .funcArg3 = NULL,
+        .funcArg4 = NULL,
+        .funcArg5 = NULL,
+        .funcArg6 = NULL,
+        .funcArg7 = NULL,
+        .funcArg8 = NULL,
+        .funcArg9 = NULL,
+        .funcArg10 = NULL,
+        .funcGenericObj = NULL,
+      },
+  .funcs[3] =
+      { /*----scope_set_mode----*/
+        // Function name (this is the name you use in ecmc plc-code)
+        .funcName = "scope_set_mode",
+        // Function description
+        .funcDesc = "scope_set_mode(index,mode) : Set acquisition mode of scope[index] (0=normal, 1=single, 2=auto, 3=roll).",
+        /**
+        * 12 different prototypes allowed (only doubles since reg in plc).
+        * Only funcArg${argCount} func shall be assigned the rest set to NULL.
+        **/
+        .funcArg0 = NULL,
+        .funcArg1 = NULL,
+        .funcArg2 = scope_set_mode,
+        .funcArg3 = NULL,
+        .funcArg4 = NULL,
+        .funcArg5 = NULL,
+        .funcArg6 = NULL,
+        .funcArg7 = NULL,
+        .funcArg8 = NULL,
+        .funcArg9 = NULL,
+        .funcArg10 = NULL,
+        .funcGenericObj = NULL,
+      },
+  .funcs[4] =
+      { /*----scope_get_status----*/
+        // Function name (this is the name you use in ecmc plc-code)
+        .funcName = "scope_get_status",
+        // Function description
+        .funcDesc = "scope_get_status(index) : Status of scope[index] (0=disabled, 1=wait trigg, 2=collect, 3=single shot done, -1=error).",
+        /**
+        * 12 different prototypes allowed (only doubles since reg in plc).
+        * Only funcArg${argCount} func shall be assigned the rest set to NULL.
+        **/
+        .funcArg0 = NULL,
+        .funcArg1 = scope_get_status,
+        .funcArg2 = NULL,
+        .funcArg3 = NULL,
+        .funcArg4 = NULL,
+        .funcArg5 = NULL,
+        .funcArg6 = NULL,
+        .funcArg7 = NULL,
+        .funcArg8 = NULL,
+        .funcArg9 = NULL,
+        .funcArg10 = NULL,
+        .funcGenericObj = NULL,
+      },
+  .funcs[5] =
+      { /*----scope_get_count----*/
+        // Function name (this is the name you use in ecmc plc-code)
+        .funcName = "scope_get_count",
+        // Function description
+        .funcDesc = "scope_get_count(index) : Capture counter of scope[index] (-1=error).",
+        /**
+        * 12 different prototypes allowed (only doubles since reg in plc).
+        * Only funcArg${argCount} func shall be assigned the rest set to NULL.
+        **/
+        .funcArg0 = NULL,
+        .funcArg1 = scope_get_count,
+        .funcArg2 = NULL,
+        .funcArg3 = NULL,
+        .funcArg4 = NULL,
+        .funcArg5 = NULL,
+        .funcArg6 = NULL,
+        .funcArg7 = NULL,
+        .funcArg8 = NULL,
+        .funcArg9 = NULL,
+        .funcArg10 = NULL,
+        .funcGenericObj = NULL,
+      },
+  .funcs[6] =
+      { /*----scope_get_stat----*/
+        // Function name (this is the name you use in ecmc plc-code)
+        .funcName = "scope_get_stat",
+        // Function description
+        .funcDesc = "scope_get_stat(index,stat) : Statistic of last capture of scope[index] (0=min, 1=max, 2=mean, 3=rms), NaN on error.",
+        /**
+        * 12 different prototypes allowed (only doubles since reg in plc).
+        * Only funcArg${argCount} func shall be assigned the rest set to NULL.
+        **/
+        .funcArg0 = NULL,
+        .funcArg1 = NULL,
+        .funcArg2 = scope_get_stat,
+        .funcArg3 = NULL,
+        .funcArg4 = NULL,
+        .funcArg5 = NULL,
+        .funcArg6 = NULL,
+        .funcArg7 = NULL,
+        .funcArg8 = NULL,
+        .funcArg9 = NULL,
+        .funcArg10 = NULL,
+        .funcGenericObj = NULL,
+      },
+  .funcs[7] =
+      { /*----scope_get_value----*/
+        // Function name (this is the name you use in ecmc plc-code)
+        .funcName = "scope_get_value",
+        // Function description
+        .funcDesc = "scope_get_value(index,element) : Element of last capture of scope[index], NaN on error.",
+        /**
+        * 12 different prototypes allowed (only doubles since reg in plc).
+        * Only funcArg${argCount} func shall be assigned the rest set to NULL.
+        **/
+        .funcArg0 = NULL,
+        .funcArg1 = NULL,
+        .funcArg2 = scope_get_value,
+        .funcArg3 = NULL,
+        .funcArg4 = NULL,
+        .funcArg5 = NULL,
+        .funcArg6 = NULL,
+        .funcArg7 = NULL,
+        .funcArg8 = NULL,
+        .funcArg9 = NULL,
+        .funcArg10 = NULL,
+        .funcGenericObj = NULL,
+      },
+  .funcs[8] =
+      { /*----scope_freeze----*/
+        // Function name (this is the name you use in ecmc plc-code)
+        .funcName = "scope_freeze",
+        // Function description
+        .funcDesc = "scope_freeze(index) : Freeze flight recorder of scope[index] (unfreeze by arm).",
+        /**
+        * 12 different prototypes allowed (only doubles since reg in plc).
+        * Only funcArg${argCount} func shall be assigned the rest set to NULL.
+        **/
+        .funcArg0 = NULL,
+        .funcArg1 = scope_freeze,
+        .funcArg2 = NULL,
+        .funcArg3 = NULL,
+        .funcArg4 = NULL,
+        .funcArg5 = NULL,
+        .funcArg6 = NULL,
+        .funcArg7 = NULL,
+        .funcArg8 = NULL,
+        .funcArg9 = NULL,
+        .funcArg10 = NULL,
+        .funcGenericObj = NULL,
+      },
   .consts[0] = {0}, // last element set all to zero..
 };
 
@@ -23,6 +23,41 @@
 #define ECMC_PLUGIN_ASYN_MISSED                "missed"
 #define ECMC_PLUGIN_ASYN_TRIGG_COUNT           "count"
 #define ECMC_PLUGIN_ASYN_SCAN_TO_TRIGG_OFFSET  "scantotrigg"
+#define ECMC_PLUGIN_ASYN_RESULT_COMPRESSED     "resultcompressed"
+#define ECMC_PLUGIN_ASYN_MODE                  "mode"
+#define ECMC_PLUGIN_ASYN_ARM                   "arm"
+#define ECMC_PLUGIN_ASYN_TRIGG_OUTCOMES        "outcomes"
+#define ECMC_PLUGIN_ASYN_TRIGG_LOG             "trigglog"
+#define ECMC_PLUGIN_ASYN_SAMPLE_PERIOD         "sampleperiod"
+#define ECMC_PLUGIN_ASYN_CAPTURE_VALID         "valid"
+#define ECMC_PLUGIN_ASYN_CAPTURE_GAPS          "gaps"
+#define ECMC_PLUGIN_ASYN_RESULT_ETS            "resultets"
+#define ECMC_PLUGIN_ASYN_RESULT_TRANSITIONS    "resulttransitions"
+#define ECMC_PLUGIN_ASYN_FRAME                 "frame"
+#define ECMC_PLUGIN_ASYN_RESULT_PERSIST        "resultpersist"
+#define ECMC_PLUGIN_ASYN_RECORDER_FROZEN       "recorderfrozen"
+#define ECMC_PLUGIN_ASYN_RECORDER_ERROR        "recordererror"
+#define ECMC_PLUGIN_ASYN_RECORDER_COUNT        "recordercount"
+#define ECMC_PLUGIN_ASYN_RECORDER_FREEZE       "recorderfreeze"
+#define ECMC_PLUGIN_ASYN_RECORDER_INDEX        "recorderindex"
+#define ECMC_PLUGIN_ASYN_RECORDER_FRAME        "recorderframe"
+#define ECMC_PLUGIN_ASYN_RECORDER_HISTORY      "recorderhistory"
+#define ECMC_PLUGIN_ASYN_VIEW_START            "viewstart"
+#define ECMC_PLUGIN_ASYN_VIEW_LENGTH           "viewlength"
+#define ECMC_PLUGIN_ASYN_VIEW_POINTS           "viewpoints"
+#define ECMC_PLUGIN_ASYN_VIEW_MODE             "viewmode"
+#define ECMC_PLUGIN_ASYN_RESULT_VIEW           "resultview"
+#define ECMC_PLUGIN_ASYN_CHUNK                 "chunk"
+#define ECMC_PLUGIN_ASYN_CONTEXT               "context"
+#define ECMC_PLUGIN_ASYN_REPLAY_CYCLES         "replaycycles"
+#define ECMC_PLUGIN_ASYN_MASK_UPPER            "maskupper"
+#define ECMC_PLUGIN_ASYN_MASK_LOWER            "masklower"
+#define ECMC_PLUGIN_ASYN_MASK_PASS             "maskpass"
+#define ECMC_PLUGIN_ASYN_MASK_FAIL             "maskfail"
+#define ECMC_PLUGIN_ASYN_MASK_FIRST            "maskfirst"
+#define ECMC_PLUGIN_ASYN_MASK_VIOLATIONS       "maskviolations"
+#define ECMC_PLUGIN_ASYN_MASK_RESET            "maskreset"
+#define ECMC_PLUGIN_ASYN_MASK_APPLY            "maskapply"
 
 
 #define SCOPE_DBG_PRINT(str)  \
@@ -30,12 +65,12 @@ if(cfgDbgMode_) {             \
     printf(str);              \
 }                             \
 
-#define ECMC_MAX_32BIT 0xFFFFFFFF
-
 #include <sstream>
 #include "ecmcScope.h"
 #include "ecmcPluginClient.h"
 #include <limits>
+#include <cmath>
+#include "epicsTime.h"
 
 /** ecmc Scope class
  * This object can throw: 
@@ -49,24 +84,71 @@ ecmcScope::ecmcScope(int   scopeIndex,       // index of this object (if several
   cfgDataSourceStr_         = NULL;
   cfgDataNexttimeStr_       = NULL;
   cfgTriggStr_              = NULL;
+  cfgContextStr_            = NULL;
+  cfgReplayFileStr_         = NULL;
+  cfgReplayOutputStr_       = NULL;
+  captureBuffer_            = NULL;
+  captureBufferBytes_       = 0;
+  captureBufferMapped_      = 0;
+  frameHeader_              = NULL;
   resultDataBuffer_         = NULL;  
+  contextValues_            = NULL;
+  contextCount_             = 0;
+  memset(contextItems_,0,sizeof(contextItems_));
+  memset(contextItemInfos_,0,sizeof(contextItemInfos_));
   lastScanSourceDataBuffer_ = NULL;
   missedTriggs_             = 0;
   triggerCounter_           = 0;
   objectId_                 = scopeIndex;  
   triggOnce_                = 0;
+  armCmd_                   = 0;
+  activeMode_               = ECMC_SCOPE_MODE_NORMAL;
+  autoCycleCounter_         = 0;
+  autoTimeoutCycles_        = 0;
+  rollCycleCounter_         = 0;
+  rollDataBuffer_           = NULL;
+  rollWritePos_             = 0;
   dataSourceLinked_         = 0;
   resultDataBufferBytes_    = 0;
   bytesInResultBuffer_      = 0;
-  oldTriggTime_             = 0;
+  compressedDataBuffer_     = NULL;
+  compressedDataBufferBytes_= 0;
+  bytesInCompressedBuffer_  = 0;
   triggTime_                = 0;
   sourceNexttime_           = 0;
-  sourceSampleRateNS_       = 0;
   sourceElementsPerSample_  = 0;
-  firstTrigg_               = 1; // Avoid first trigger (0 timestamp..)
+  newTrigg_                 = 0;
   scopeState_               = ECMC_SCOPE_STATE_INVALID;
-  ecmcSmapleTimeNS_         = (uint64_t)getEcmcSampleTimeMS()*1E6;
+  ecmcSmapleTimeNS_         = (uint64_t)(getEcmcSampleTimeMS()*1E6);
   samplesSinceLastTrigg_    = 0;
+  samplePeriodNs_           = 0;
+  triggPhase_               = -1;
+  captureTriggTime_         = 0;
+  captureFlags_             = 0;
+  captureDelayNs_           = 0;
+  startSamples_             = 0;
+  memset(resultStats_,0,sizeof(resultStats_));
+  memset(triggOutcomes_,0,sizeof(triggOutcomes_));
+  memset(triggLog_,0,sizeof(triggLog_));
+  memset(triggLogPublish_,0,sizeof(triggLogPublish_));
+  triggLogPos_              = 0;
+  triggLogDirty_            = 0;
+  lastScanNexttime_         = 0;
+  lastScanValid_            = 0;
+  memset(gapFillElement_,0,sizeof(gapFillElement_));
+  captureValid_             = 1;
+  captureGaps_              = 0;
+  cmdQueue_                 = NULL;
+  enableReq_                = 0;
+  enableSeen_               = 0;
+  modeReq_                  = 0;
+  modeSeen_                 = 0;
+  armReq_                   = 0;
+  recorderFreezeReq_        = 0;
+  recorderIndexReq_         = 0;
+  recorderIndexSeen_        = 0;
+  maskResetReq_             = 0;
+  maskApplyReq_             = 0;
 
   // Asyn
   sourceStrParam_           = NULL;
@@ -77,47 +159,385 @@ ecmcScope::ecmcScope(int   scopeIndex,       // index of this object (if several
   asynMissedTriggs_         = NULL;
   asynTriggerCounter_       = NULL;
   asynTimeTrigg2Sample_     = NULL;
+  asynCompressed_           = NULL;
+  asynMode_                 = NULL;
+  asynArm_                  = NULL;
+  asynTriggOutcomes_        = NULL;
+  asynTriggLog_             = NULL;
+  asynSamplePeriod_         = NULL;
+  asynCaptureValid_         = NULL;
+  asynCaptureGaps_          = NULL;
+  asynEts_                  = NULL;
+  asynLogicTrans_           = NULL;
+  asynFrame_                = NULL;
+  asynPersist_              = NULL;
+  asynRecorderFrozen_       = NULL;
+  asynRecorderError_        = NULL;
+  asynRecorderCount_        = NULL;
+  asynRecorderFreeze_       = NULL;
+  asynRecorderIndex_        = NULL;
+  asynRecorderFrame_        = NULL;
+  asynRecorderHistory_      = NULL;
+  asynViewStart_            = NULL;
+  asynViewLength_           = NULL;
+  asynViewPoints_           = NULL;
+  asynViewMode_             = NULL;
+  asynView_                 = NULL;
+  asynChunk_                = NULL;
+  asynContext_              = NULL;
+  asynReplayCycles_         = NULL;
+  asynMaskUpper_            = NULL;
+  asynMaskLower_            = NULL;
+  asynMaskPass_             = NULL;
+  asynMaskFail_             = NULL;
+  asynMaskFirst_            = NULL;
+  asynMaskViolations_       = NULL;
+  asynMaskReset_            = NULL;
+  asynMaskApply_            = NULL;
 
   // ecmcDataItems
   sourceDataItem_           = NULL;
   sourceDataNexttimeItem_   = NULL;
-  sourceTriggItem_          = NULL;
+  trigg_                    = NULL;
+  timebase_                 = NULL;
+  ets_                      = NULL;
+  etsDataBuffer_            = NULL;
+  etsDataBufferBytes_       = 0;
+  logic_                    = NULL;
+  logicChannelBuffer_       = NULL;
+  logicChannelBufferBytes_  = 0;
+  logicTransBuffer_         = NULL;
+  logicTransBufferBytes_    = 0;
+  persist_                  = NULL;
+  historyDataBuffer_        = NULL;
+  historyNexttime_          = NULL;
+  historyTriggValues_       = NULL;
+  historySlots_             = 0;
+  historyStart_             = 0;
+  historyCount_             = 0;
+  historyBatch_             = 0;
+  historyLast_              = NULL;
+  replayData_               = NULL;
+  source_                   = NULL;
+  sources_                  = NULL;
+  hotWake_                  = NULL;
+  historyUser_              = 0;
+  sharedHistory_            = 0;
+  recorder_                 = NULL;
+  view_                     = NULL;
+  replay_                   = NULL;
+  replayOut_                = NULL;
+  replayExitEvent_          = NULL;
+  replayStop_               = 0;
+  replayDone_               = 0;
+  replayPublished_          = 0;
+  replayCycles_             = 0;
+  replayCyclesPublish_      = 0;
+  mask_                     = NULL;
+  maskPass_                 = 0;
+  maskFail_                 = 0;
+  maskFirst_                = -1;
+  maskViolations_           = 0;
+  chunkBuffer_              = NULL;
+  chunkBufferBytes_         = 0;
+  chunkHeader_              = NULL;
+  chunkPublishedBytes_      = 0;
+  chunkEndBytes_            = 0;
+  chunkSequence_            = 0;
+  chunkIndex_               = 0;
+  chunkCapture_             = 0;
+  chunkDrain_               = 0;
+  chunkThisCycle_           = 0;
+  statsMin_                 = 0;
+  statsMax_                 = 0;
+  statsSum_                 = 0;
+  statsSumSqr_              = 0;
+  recorderFrozen_           = 0;
+  recorderError_            = 0;
+  recorderCount_            = 0;
+  recorderPublish_          = 0;
+  recorderUnfreeze_         = 0;
+  lastEcmcError_            = 0;
 
   sourceDataItemInfo_       = NULL;
   sourceDataNexttimeItemInfo_ = NULL;
-  sourceTriggItemInfo_      = NULL;
   
   // Config defaults
   cfgDbgMode_               = 0;
   cfgBufferElementCount_    = ECMC_PLUGIN_DEFAULT_BUFFER_SIZE;
   cfgEnable_                = 1;   // start enabled (enable over asyn)
+  cfgCompress_              = ECMC_SCOPE_CODEC_RAW;  // no compressed output
+  cfgMode_                  = ECMC_SCOPE_MODE_NORMAL;
+  cfgAutoTimeoutMs_         = ECMC_PLUGIN_DEFAULT_AUTO_TIMEOUT_MS;
+  cfgRollCycles_            = ECMC_PLUGIN_DEFAULT_ROLL_CYCLES;
+  cfgTriggLogic_            = ECMC_SCOPE_TRIGG_LOGIC_OR;
+  cfgTriggType_             = ECMC_SCOPE_TRIGG_TYPE_LATCH;
+  cfgTriggLevel_            = 0;
+  cfgTriggWindowNs_         = ecmcSmapleTimeNS_;
+  cfgTriggSeqTimeoutNs_     = ECMC_PLUGIN_DEFAULT_TRIGG_SEQ_TIMEOUT_NS;
+  cfgTriggHoldoffNs_        = 0;
+  cfgTriggPrescale_         = 1;
+  cfgTriggDelay_            = 0;
+  cfgTriggDelaySamples_     = 0;
+  cfgGapPolicy_             = ECMC_SCOPE_GAP_FLAG;
+  cfgGapFillValue_          = 0;
+  cfgEtsFactor_             = 0;
+  cfgEtsCaptures_           = ECMC_PLUGIN_DEFAULT_ETS_CAPTURES;
+  cfgExecCycles_            = 1;
+  cfgPersistBins_           = 0;
+  cfgPersistMin_            = 0;
+  cfgPersistMax_            = 0;
+  cfgPersistDecay_          = ECMC_PLUGIN_DEFAULT_PERSIST_DECAY;
+  cfgPersistPublishMs_      = ECMC_PLUGIN_DEFAULT_PERSIST_PUBLISH_MS;
+  cfgRecorderCaptures_      = 0;
+  cfgRecorderHistoryCycles_ = 0;
+  cfgRecorderFreezeOnError_ = 1;
+  cfgViewPoints_            = 0;
+  cfgChunkElements_         = 0;
+  cfgMask_                  = 0;
+  cfgMaskFreeze_            = 0;
+  cfgStats_                 = 0;
   
   parseConfigStr(configStr); // Assigns all configs
   
+  // Timebase, trigger window and timeouts are derived from the sample time
+  if(ecmcSmapleTimeNS_ == 0) {
+    SCOPE_DBG_PRINT("ERROR: Ecmc sample time must be > 0ns.");
+    throw std::out_of_range("ERROR: Ecmc sample time must be > 0ns.");
+  }
+
   // Check valid buffer size
   if(cfgBufferElementCount_ <= 0) {
     SCOPE_DBG_PRINT("ERROR: Configuration buffer size must be > 0.");
     throw std::out_of_range("ERROR: Configuration Buffer Size must be > 0.");
   }
 
+  // Check valid codec
+  if(cfgCompress_ < ECMC_SCOPE_CODEC_RAW || cfgCompress_ > ECMC_SCOPE_CODEC_DELTA2) {
+    SCOPE_DBG_PRINT("ERROR: Configuration compress codec out of range.");
+    throw std::out_of_range("ERROR: Configuration compress codec out of range (0..2).");
+  }
+
+  // Check mode settings
+  if(cfgAutoTimeoutMs_ <= 0 || cfgRollCycles_ <= 0) {
+    SCOPE_DBG_PRINT("ERROR: Configuration auto timeout and roll cycles must be > 0.");
+    throw std::out_of_range("ERROR: Configuration auto timeout and roll cycles must be > 0.");
+  }
+  // Check persistence settings
+  if(cfgPersistBins_ < 0 || (cfgPersistBins_ && cfgPersistMax_ <= cfgPersistMin_)) {
+    SCOPE_DBG_PRINT("ERROR: Configuration persistence bins must be >= 0 and max > min.");
+    throw std::out_of_range("ERROR: Configuration persistence bins must be >= 0 and max > min.");
+  }
+  if(cfgPersistDecay_ <= 0 || cfgPersistDecay_ > 1 || cfgPersistPublishMs_ <= 0) {
+    SCOPE_DBG_PRINT("ERROR: Configuration persistence decay must be 0..1 and publish period > 0.");
+    throw std::out_of_range("ERROR: Configuration persistence decay must be 0..1 and publish period > 0.");
+  }
+
+  // Check flight recorder settings
+  if(cfgRecorderCaptures_ < 0 || cfgRecorderHistoryCycles_ < 0) {
+    SCOPE_DBG_PRINT("ERROR: Configuration recorder captures and history cycles must be >= 0.");
+    throw std::out_of_range("ERROR: Configuration recorder captures and history cycles must be >= 0.");
+  }
+
+  // Check mask test (failing capture is frozen in flight recorder)
+  if(cfgMaskFreeze_ && (!cfgMask_ || !cfgRecorderCaptures_)) {
+    SCOPE_DBG_PRINT("ERROR: Configuration mask freeze needs mask test and recorder captures.");
+    throw std::invalid_argument("ERROR: Configuration mask freeze needs mask test and recorder captures.");
+  }
+
+  // Check windowed readout
+  if(cfgViewPoints_ < 0) {
+    SCOPE_DBG_PRINT("ERROR: Configuration view points must be >= 0.");
+    throw std::out_of_range("ERROR: Configuration view points must be >= 0.");
+  }
+
+  // Check large capture mode (whole capture never copied or published at once)
+  if(cfgChunkElements_ < 0) {
+    SCOPE_DBG_PRINT("ERROR: Configuration chunk elements must be >= 0.");
+    throw std::out_of_range("ERROR: Configuration chunk elements must be >= 0.");
+  }
+  if(cfgChunkElements_ && (cfgCompress_ || cfgEtsFactor_ || cfgPersistBins_ || cfgViewPoints_ ||
+                           cfgRecorderCaptures_ || cfgMask_ || cfgMode_ == ECMC_SCOPE_MODE_ROLL)) {
+    SCOPE_DBG_PRINT("ERROR: Configuration chunk elements not supported with compress, ets, persist, view, recorder, mask or roll mode.");
+    throw std::invalid_argument("ERROR: Configuration chunk elements not supported with compress, ets, persist, view, recorder, mask or roll mode.");
+  }
+
+  // Check sub rate execution
+  if(cfgExecCycles_ < 1) {
+    SCOPE_DBG_PRINT("ERROR: Configuration exec cycles must be > 0.");
+    throw std::out_of_range("ERROR: Configuration exec cycles must be > 0.");
+  }
+  // Context items are read live, not recorded with the scans
+  if(cfgExecCycles_ > 1 && cfgContextStr_) {
+    SCOPE_DBG_PRINT("ERROR: Configuration context not supported with exec cycles > 1.");
+    throw std::invalid_argument("ERROR: Configuration context not supported with exec cycles > 1.");
+  }
+
+  // Check trigger delay
+  if(cfgTriggDelay_ < 0) {
+    SCOPE_DBG_PRINT("ERROR: Configuration trigger delay must be >= 0.");
+    throw std::out_of_range("ERROR: Configuration trigger delay must be >= 0.");
+  }
+
+  // Check equivalent time sampling settings
+  if(cfgEtsFactor_ < 0 || cfgEtsCaptures_ <= 0) {
+    SCOPE_DBG_PRINT("ERROR: Configuration ets factor must be >= 0 and ets captures > 0.");
+    throw std::out_of_range("ERROR: Configuration ets factor must be >= 0 and ets captures > 0.");
+  }
+
+  // Check offline replay (only features that do not need live items or asyn per capture)
+  if(cfgReplayFileStr_) {
+    if(!cfgReplayOutputStr_) {
+      SCOPE_DBG_PRINT("ERROR: Configuration replay output not defined.");
+      throw std::invalid_argument("ERROR: Configuration replay output not defined.");
+    }
+    if(cfgContextStr_ || cfgChunkElements_ || cfgRecorderCaptures_ || cfgPersistBins_ ||
+       cfgViewPoints_ || cfgEtsFactor_ || cfgCompress_ || cfgExecCycles_ > 1 ||
+       cfgMode_ == ECMC_SCOPE_MODE_ROLL) {
+      SCOPE_DBG_PRINT("ERROR: Configuration replay not supported with context, chunk, recorder, persist, view, ets, compress, exec cycles or roll mode.");
+      throw std::invalid_argument("ERROR: Configuration replay not supported with context, chunk, recorder, persist, view, ets, compress, exec cycles or roll mode.");
+    }
+    replay_    = new ecmcScopeReplay(cfgReplayFileStr_);
+    replayOut_ = fopen(cfgReplayOutputStr_, "wb");
+    if(!replayOut_) {
+      delete replay_;
+      replay_ = NULL;
+      SCOPE_DBG_PRINT("ERROR: Failed open replay output file.");
+      throw std::runtime_error("ERROR: Failed open replay output file.");
+    }
+  }
+
+  autoTimeoutCycles_ = (int)(cfgAutoTimeoutMs_ * 1E6 / ecmcSmapleTimeNS_);
+  activeMode_        = cfgMode_;
+
+  // Control requests start from configured state
+  cmdQueue_          = new ecmcScopeCmdQueue();
+  enableReq_         = cfgEnable_;
+  enableSeen_        = cfgEnable_;
+  modeReq_           = cfgMode_;
+  modeSeen_          = cfgMode_;
+
   // Allocate buffers first at enter RT (since datatype is unknown here)
   resultDataBuffer_         = NULL;
   resultDataBufferBytes_    = 0;
 }
 
 ecmcScope::~ecmcScope() {
+
+  // Stop replay worker (finishes current record)
+  if(replayExitEvent_) {
+    __atomic_store_n(&replayStop_, 1, __ATOMIC_RELEASE);
+    epicsEventWait(replayExitEvent_);
+    epicsEventDestroy(replayExitEvent_);
+  }
+
+  if(replay_) {
+    delete replay_;
+  }
+
+  if(replayOut_) {
+    fclose(replayOut_);
+  }
   
-  if(resultDataBuffer_) {
-    delete[] resultDataBuffer_;
+  if(captureBufferMapped_) {
+    ecmcScopeMemFree(captureBuffer_, captureBufferMapped_);
+  }
+  else if(captureBuffer_) {
+    delete[] captureBuffer_;
+  }
+
+  if(chunkBuffer_) {
+    delete[] chunkBuffer_;
   }
 
   if(lastScanSourceDataBuffer_) {
     delete[] lastScanSourceDataBuffer_;
   }
 
+  if(compressedDataBuffer_) {
+    delete[] compressedDataBuffer_;
+  }
+
+  if(rollDataBuffer_) {
+    delete[] rollDataBuffer_;
+  }
+
+  if(trigg_) {
+    delete trigg_;
+  }
+
+  if(timebase_) {
+    delete timebase_;
+  }
+
+  if(ets_) {
+    delete ets_;
+  }
+
+  if(etsDataBuffer_) {
+    delete[] etsDataBuffer_;
+  }
+
+  if(logic_) {
+    delete logic_;
+  }
+
+  // Stops worker thread
+  if(persist_) {
+    delete persist_;
+  }
+
+  if(historyDataBuffer_) {
+    delete[] historyDataBuffer_;
+  }
+
+  if(historyNexttime_) {
+    delete[] historyNexttime_;
+  }
+
+  if(historyTriggValues_) {
+    delete[] historyTriggValues_;
+  }
+
+  if(recorder_) {
+    delete recorder_;
+  }
+
+  if(mask_) {
+    delete mask_;
+  }
+
+  // Stops worker thread
+  if(view_) {
+    delete view_;
+  }
+
+
+
+  if(cmdQueue_) {
+    delete cmdQueue_;
+  }
+
+  if(logicChannelBuffer_) {
+    delete[] logicChannelBuffer_;
+  }
+
+  if(logicTransBuffer_) {
+    delete[] logicTransBuffer_;
+  }
+
   if(cfgDataSourceStr_) {
     free(cfgDataSourceStr_);
   }
+  if(cfgContextStr_) {
+    free(cfgContextStr_);
+  }
+  if(cfgReplayFileStr_) {
+    free(cfgReplayFileStr_);
+  }
+  if(cfgReplayOutputStr_) {
+    free(cfgReplayOutputStr_);
+  }
   if(cfgTriggStr_) {
     free(cfgTriggStr_);
   }
@@ -151,6 +571,7 @@ void ecmcScope::parseConfigStr(char *configStr) {
       // ECMC_PLUGIN_SOURCE_OPTION_CMD (Source string)
       else if (!strncmp(pThisOption, ECMC_PLUGIN_SOURCE_OPTION_CMD, strlen(ECMC_PLUGIN_SOURCE_OPTION_CMD))) {
         pThisOption += strlen(ECMC_PLUGIN_SOURCE_OPTION_CMD);
+        free(cfgDataSourceStr_);  // Later option overrides (shared defaults)
         cfgDataSourceStr_=strdup(pThisOption);
       }
 
@@ -166,35 +587,307 @@ void ecmcScope::parseConfigStr(char *configStr) {
         cfgEnable_ = atoi(pThisOption);
       }
 
+      // ECMC_PLUGIN_COMPRESS_OPTION_CMD (0/1/2)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_COMPRESS_OPTION_CMD, strlen(ECMC_PLUGIN_COMPRESS_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_COMPRESS_OPTION_CMD);
+        cfgCompress_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_MODE_OPTION_CMD NORMAL/SINGLE/AUTO/ROLL
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_MODE_OPTION_CMD, strlen(ECMC_PLUGIN_MODE_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_MODE_OPTION_CMD);
+        if(!strncmp(pThisOption, ECMC_PLUGIN_MODE_NORMAL_OPTION,strlen(ECMC_PLUGIN_MODE_NORMAL_OPTION))){
+          cfgMode_ = ECMC_SCOPE_MODE_NORMAL;
+        }
+        else if(!strncmp(pThisOption, ECMC_PLUGIN_MODE_SINGLE_OPTION,strlen(ECMC_PLUGIN_MODE_SINGLE_OPTION))){
+          cfgMode_ = ECMC_SCOPE_MODE_SINGLE;
+        }
+        else if(!strncmp(pThisOption, ECMC_PLUGIN_MODE_AUTO_OPTION,strlen(ECMC_PLUGIN_MODE_AUTO_OPTION))){
+          cfgMode_ = ECMC_SCOPE_MODE_AUTO;
+        }
+        else if(!strncmp(pThisOption, ECMC_PLUGIN_MODE_ROLL_OPTION,strlen(ECMC_PLUGIN_MODE_ROLL_OPTION))){
+          cfgMode_ = ECMC_SCOPE_MODE_ROLL;
+        }
+        else {
+          SCOPE_DBG_PRINT("ERROR: Configuration mode invalid.\n");
+          throw std::invalid_argument( "ERROR: Configuration mode invalid (NORMAL/SINGLE/AUTO/ROLL).");
+        }
+      }
+
+      // ECMC_PLUGIN_AUTO_TIMEOUT_OPTION_CMD (ms)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_AUTO_TIMEOUT_OPTION_CMD, strlen(ECMC_PLUGIN_AUTO_TIMEOUT_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_AUTO_TIMEOUT_OPTION_CMD);
+        cfgAutoTimeoutMs_ = atof(pThisOption);
+      }
+
+      // ECMC_PLUGIN_TRIGG_LOGIC_OPTION_CMD OR/AND/SEQ
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_LOGIC_OPTION_CMD, strlen(ECMC_PLUGIN_TRIGG_LOGIC_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_TRIGG_LOGIC_OPTION_CMD);
+        if(!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_LOGIC_OR_OPTION,strlen(ECMC_PLUGIN_TRIGG_LOGIC_OR_OPTION))){
+          cfgTriggLogic_ = ECMC_SCOPE_TRIGG_LOGIC_OR;
+        }
+        else if(!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_LOGIC_AND_OPTION,strlen(ECMC_PLUGIN_TRIGG_LOGIC_AND_OPTION))){
+          cfgTriggLogic_ = ECMC_SCOPE_TRIGG_LOGIC_AND;
+        }
+        else if(!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_LOGIC_SEQ_OPTION,strlen(ECMC_PLUGIN_TRIGG_LOGIC_SEQ_OPTION))){
+          cfgTriggLogic_ = ECMC_SCOPE_TRIGG_LOGIC_SEQ;
+        }
+        else {
+          SCOPE_DBG_PRINT("ERROR: Configuration trigger logic invalid.\n");
+          throw std::invalid_argument( "ERROR: Configuration trigger logic invalid (OR/AND/SEQ).");
+        }
+      }
+
+      // ECMC_PLUGIN_TRIGG_TYPE_OPTION_CMD LATCH/CHANGE/RISING/FALLING/CROSS
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_TYPE_OPTION_CMD, strlen(ECMC_PLUGIN_TRIGG_TYPE_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_TRIGG_TYPE_OPTION_CMD);
+        if(!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_TYPE_LATCH_OPTION,strlen(ECMC_PLUGIN_TRIGG_TYPE_LATCH_OPTION))){
+          cfgTriggType_ = ECMC_SCOPE_TRIGG_TYPE_LATCH;
+        }
+        else if(!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_TYPE_CHANGE_OPTION,strlen(ECMC_PLUGIN_TRIGG_TYPE_CHANGE_OPTION))){
+          cfgTriggType_ = ECMC_SCOPE_TRIGG_TYPE_CHANGE;
+        }
+        else if(!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_TYPE_RISING_OPTION,strlen(ECMC_PLUGIN_TRIGG_TYPE_RISING_OPTION))){
+          cfgTriggType_ = ECMC_SCOPE_TRIGG_TYPE_RISING;
+        }
+        else if(!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_TYPE_FALLING_OPTION,strlen(ECMC_PLUGIN_TRIGG_TYPE_FALLING_OPTION))){
+          cfgTriggType_ = ECMC_SCOPE_TRIGG_TYPE_FALLING;
+        }
+        else if(!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_TYPE_CROSS_OPTION,strlen(ECMC_PLUGIN_TRIGG_TYPE_CROSS_OPTION))){
+          cfgTriggType_ = ECMC_SCOPE_TRIGG_TYPE_CROSS;
+        }
+        else {
+          SCOPE_DBG_PRINT("ERROR: Configuration trigger type invalid.\n");
+          throw std::invalid_argument( "ERROR: Configuration trigger type invalid (LATCH/CHANGE/RISING/FALLING/CROSS).");
+        }
+      }
+
+      // ECMC_PLUGIN_TRIGG_LEVEL_OPTION_CMD (value)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_LEVEL_OPTION_CMD, strlen(ECMC_PLUGIN_TRIGG_LEVEL_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_TRIGG_LEVEL_OPTION_CMD);
+        cfgTriggLevel_ = atof(pThisOption);
+      }
+
+      // ECMC_PLUGIN_TRIGG_WINDOW_OPTION_CMD (ns)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_WINDOW_OPTION_CMD, strlen(ECMC_PLUGIN_TRIGG_WINDOW_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_TRIGG_WINDOW_OPTION_CMD);
+        cfgTriggWindowNs_ = strtoll(pThisOption, NULL, 10);
+      }
+
+      // ECMC_PLUGIN_TRIGG_TIMEOUT_OPTION_CMD (ns)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_TIMEOUT_OPTION_CMD, strlen(ECMC_PLUGIN_TRIGG_TIMEOUT_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_TRIGG_TIMEOUT_OPTION_CMD);
+        cfgTriggSeqTimeoutNs_ = strtoll(pThisOption, NULL, 10);
+      }
+
+      // ECMC_PLUGIN_TRIGG_HOLDOFF_OPTION_CMD (ns)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_HOLDOFF_OPTION_CMD, strlen(ECMC_PLUGIN_TRIGG_HOLDOFF_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_TRIGG_HOLDOFF_OPTION_CMD);
+        cfgTriggHoldoffNs_ = strtoll(pThisOption, NULL, 10);
+      }
+
+      // ECMC_PLUGIN_TRIGG_DELAY_OPTION_CMD (ns or samples)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_DELAY_OPTION_CMD, strlen(ECMC_PLUGIN_TRIGG_DELAY_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_TRIGG_DELAY_OPTION_CMD);
+        char *pUnit = NULL;
+        cfgTriggDelay_ = strtoll(pThisOption, &pUnit, 10);
+        if(!pUnit[0] || !strcmp(pUnit, ECMC_PLUGIN_TRIGG_DELAY_NS_OPTION)) {
+          cfgTriggDelaySamples_ = 0;
+        }
+        else if(!strcmp(pUnit, ECMC_PLUGIN_TRIGG_DELAY_SAMPLES_OPTION)) {
+          cfgTriggDelaySamples_ = 1;
+        }
+        else {
+          SCOPE_DBG_PRINT("ERROR: Configuration trigger delay unit invalid.\n");
+          throw std::invalid_argument( "ERROR: Configuration trigger delay unit invalid (NS/SAMPLES).");
+        }
+      }
+
+      // ECMC_PLUGIN_TRIGG_PRESCALE_OPTION_CMD (n)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_PRESCALE_OPTION_CMD, strlen(ECMC_PLUGIN_TRIGG_PRESCALE_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_TRIGG_PRESCALE_OPTION_CMD);
+        cfgTriggPrescale_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_GAP_POLICY_OPTION_CMD FLAG/FILL/ABORT
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_GAP_POLICY_OPTION_CMD, strlen(ECMC_PLUGIN_GAP_POLICY_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_GAP_POLICY_OPTION_CMD);
+        if(!strncmp(pThisOption, ECMC_PLUGIN_GAP_POLICY_FLAG_OPTION,strlen(ECMC_PLUGIN_GAP_POLICY_FLAG_OPTION))){
+          cfgGapPolicy_ = ECMC_SCOPE_GAP_FLAG;
+        }
+        else if(!strncmp(pThisOption, ECMC_PLUGIN_GAP_POLICY_FILL_OPTION,strlen(ECMC_PLUGIN_GAP_POLICY_FILL_OPTION))){
+          cfgGapPolicy_ = ECMC_SCOPE_GAP_FILL;
+        }
+        else if(!strncmp(pThisOption, ECMC_PLUGIN_GAP_POLICY_ABORT_OPTION,strlen(ECMC_PLUGIN_GAP_POLICY_ABORT_OPTION))){
+          cfgGapPolicy_ = ECMC_SCOPE_GAP_ABORT;
+        }
+        else {
+          SCOPE_DBG_PRINT("ERROR: Configuration gap policy invalid.\n");
+          throw std::invalid_argument( "ERROR: Configuration gap policy invalid (FLAG/FILL/ABORT).");
+        }
+      }
+
+      // ECMC_PLUGIN_GAP_FILL_VALUE_OPTION_CMD (value)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_GAP_FILL_VALUE_OPTION_CMD, strlen(ECMC_PLUGIN_GAP_FILL_VALUE_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_GAP_FILL_VALUE_OPTION_CMD);
+        cfgGapFillValue_ = atof(pThisOption);
+      }
+
+      // ECMC_PLUGIN_ETS_FACTOR_OPTION_CMD (n)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_ETS_FACTOR_OPTION_CMD, strlen(ECMC_PLUGIN_ETS_FACTOR_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_ETS_FACTOR_OPTION_CMD);
+        cfgEtsFactor_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_ETS_CAPTURES_OPTION_CMD (n)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_ETS_CAPTURES_OPTION_CMD, strlen(ECMC_PLUGIN_ETS_CAPTURES_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_ETS_CAPTURES_OPTION_CMD);
+        cfgEtsCaptures_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_EXEC_CYCLES_OPTION_CMD (cycles)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_EXEC_CYCLES_OPTION_CMD, strlen(ECMC_PLUGIN_EXEC_CYCLES_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_EXEC_CYCLES_OPTION_CMD);
+        cfgExecCycles_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_PERSIST_BINS_OPTION_CMD (n)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_PERSIST_BINS_OPTION_CMD, strlen(ECMC_PLUGIN_PERSIST_BINS_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_PERSIST_BINS_OPTION_CMD);
+        cfgPersistBins_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_PERSIST_MIN_OPTION_CMD (value)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_PERSIST_MIN_OPTION_CMD, strlen(ECMC_PLUGIN_PERSIST_MIN_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_PERSIST_MIN_OPTION_CMD);
+        cfgPersistMin_ = atof(pThisOption);
+      }
+
+      // ECMC_PLUGIN_PERSIST_MAX_OPTION_CMD (value)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_PERSIST_MAX_OPTION_CMD, strlen(ECMC_PLUGIN_PERSIST_MAX_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_PERSIST_MAX_OPTION_CMD);
+        cfgPersistMax_ = atof(pThisOption);
+      }
+
+      // ECMC_PLUGIN_PERSIST_DECAY_OPTION_CMD (0..1)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_PERSIST_DECAY_OPTION_CMD, strlen(ECMC_PLUGIN_PERSIST_DECAY_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_PERSIST_DECAY_OPTION_CMD);
+        cfgPersistDecay_ = atof(pThisOption);
+      }
+
+      // ECMC_PLUGIN_PERSIST_PUBLISH_OPTION_CMD (ms)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_PERSIST_PUBLISH_OPTION_CMD, strlen(ECMC_PLUGIN_PERSIST_PUBLISH_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_PERSIST_PUBLISH_OPTION_CMD);
+        cfgPersistPublishMs_ = atof(pThisOption);
+      }
+
+      // ECMC_PLUGIN_RECORDER_CAPTURES_OPTION_CMD (captures)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_RECORDER_CAPTURES_OPTION_CMD, strlen(ECMC_PLUGIN_RECORDER_CAPTURES_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_RECORDER_CAPTURES_OPTION_CMD);
+        cfgRecorderCaptures_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_RECORDER_HISTORY_OPTION_CMD (cycles)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_RECORDER_HISTORY_OPTION_CMD, strlen(ECMC_PLUGIN_RECORDER_HISTORY_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_RECORDER_HISTORY_OPTION_CMD);
+        cfgRecorderHistoryCycles_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_RECORDER_FREEZE_ERROR_OPTION_CMD (1/0)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_RECORDER_FREEZE_ERROR_OPTION_CMD, strlen(ECMC_PLUGIN_RECORDER_FREEZE_ERROR_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_RECORDER_FREEZE_ERROR_OPTION_CMD);
+        cfgRecorderFreezeOnError_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_VIEW_POINTS_OPTION_CMD (points)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_VIEW_POINTS_OPTION_CMD, strlen(ECMC_PLUGIN_VIEW_POINTS_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_VIEW_POINTS_OPTION_CMD);
+        cfgViewPoints_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_MASK_OPTION_CMD (1/0)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_MASK_OPTION_CMD, strlen(ECMC_PLUGIN_MASK_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_MASK_OPTION_CMD);
+        cfgMask_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_MASK_FREEZE_OPTION_CMD (1/0)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_MASK_FREEZE_OPTION_CMD, strlen(ECMC_PLUGIN_MASK_FREEZE_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_MASK_FREEZE_OPTION_CMD);
+        cfgMaskFreeze_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_STATS_OPTION_CMD (1/0)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_STATS_OPTION_CMD, strlen(ECMC_PLUGIN_STATS_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_STATS_OPTION_CMD);
+        cfgStats_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_CHUNK_ELEMENTS_OPTION_CMD (elements)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_CHUNK_ELEMENTS_OPTION_CMD, strlen(ECMC_PLUGIN_CHUNK_ELEMENTS_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_CHUNK_ELEMENTS_OPTION_CMD);
+        cfgChunkElements_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_ROLL_CYCLES_OPTION_CMD (cycles)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_ROLL_CYCLES_OPTION_CMD, strlen(ECMC_PLUGIN_ROLL_CYCLES_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_ROLL_CYCLES_OPTION_CMD);
+        cfgRollCycles_ = atoi(pThisOption);
+      }
+
       // ECMC_PLUGIN_TRIGG_OPTION_CMD (string)     
       else if (!strncmp(pThisOption, ECMC_PLUGIN_TRIGG_OPTION_CMD, strlen(ECMC_PLUGIN_TRIGG_OPTION_CMD))) {
         pThisOption += strlen(ECMC_PLUGIN_TRIGG_OPTION_CMD);
+        free(cfgTriggStr_);
         cfgTriggStr_ = strdup(pThisOption);
       }
 
+      // ECMC_PLUGIN_CONTEXT_OPTION_CMD (string)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_CONTEXT_OPTION_CMD, strlen(ECMC_PLUGIN_CONTEXT_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_CONTEXT_OPTION_CMD);
+        free(cfgContextStr_);
+        cfgContextStr_ = strdup(pThisOption);
+      }
+
       // ECMC_PLUGIN_SOURCE_NEXTTIME_OPTION_CMD (string)
       else if (!strncmp(pThisOption, ECMC_PLUGIN_SOURCE_NEXTTIME_OPTION_CMD, strlen(ECMC_PLUGIN_SOURCE_NEXTTIME_OPTION_CMD))) {
         pThisOption += strlen(ECMC_PLUGIN_SOURCE_NEXTTIME_OPTION_CMD);
+        free(cfgDataNexttimeStr_);
         cfgDataNexttimeStr_ = strdup(pThisOption);
       }
 
+      // ECMC_PLUGIN_REPLAY_FILE_OPTION_CMD (string)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_REPLAY_FILE_OPTION_CMD, strlen(ECMC_PLUGIN_REPLAY_FILE_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_REPLAY_FILE_OPTION_CMD);
+        free(cfgReplayFileStr_);
+        cfgReplayFileStr_ = strdup(pThisOption);
+      }
+
+      // ECMC_PLUGIN_REPLAY_OUTPUT_OPTION_CMD (string)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_REPLAY_OUTPUT_OPTION_CMD, strlen(ECMC_PLUGIN_REPLAY_OUTPUT_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_REPLAY_OUTPUT_OPTION_CMD);
+        free(cfgReplayOutputStr_);
+        cfgReplayOutputStr_ = strdup(pThisOption);
+      }
 
-    //   ECMC_PLUGIN_MODE_OPTION_CMD CONT/TRIGG
-    //   else if (!strncmp(pThisOption, ECMC_PLUGIN_MODE_OPTION_CMD, strlen(ECMC_PLUGIN_MODE_OPTION_CMD))) {
-    //     pThisOption += strlen(ECMC_PLUGIN_MODE_OPTION_CMD);
-    //     if(!strncmp(pThisOption, ECMC_PLUGIN_MODE_CONT_OPTION,strlen(ECMC_PLUGIN_MODE_CONT_OPTION))){
-    //       cfgMode_ = CONT;
-    //     }
-    //     if(!strncmp(pThisOption, ECMC_PLUGIN_MODE_TRIGG_OPTION,strlen(ECMC_PLUGIN_MODE_TRIGG_OPTION))){
-    //       cfgMode_ = TRIGG;
-    //     }
-    //   }
 
       pThisOption = pNextOption;
     }    
     free(pOptions);
   }
 
+  // Replay: source, trigger and nexttime are taken from the replay file
+  // (the published source strings refer to the file)
+  if(cfgReplayFileStr_) {
+    free(cfgDataSourceStr_);
+    cfgDataSourceStr_ = strdup(cfgReplayFileStr_);
+    free(cfgTriggStr_);
+    cfgTriggStr_ = strdup(cfgReplayFileStr_);
+    free(cfgDataNexttimeStr_);
+    cfgDataNexttimeStr_ = strdup(cfgReplayFileStr_);
+    return;
+  }
+
   // Data source must be defined...
   if(!cfgDataSourceStr_) { 
     SCOPE_DBG_PRINT("ERROR: Configuration Data source not defined.\n");
@@ -210,69 +903,278 @@ void ecmcScope::parseConfigStr(char *configStr) {
   }
 }
 
-void ecmcScope::connectToDataSources() {
+void ecmcScope::connectToDataSources(ecmcScopeSourceRegistry *sources) {
   SCOPE_DBG_PRINT("ecmcScope::connectToDataSources()");
   /* Check if already linked (one call to connectToDataSources (enterRT) per loaded Scope lib (Scope object))
       But link should only happen once!!*/
   if( dataSourceLinked_ ) {
     return;
   }
+  sources_ = sources;
+
+  if(replay_) {
+    // Replay: recorded source and cycle time (no data item)
+    ecmcSmapleTimeNS_   = replay_->getCycleNs();
+    autoTimeoutCycles_  = (int)(cfgAutoTimeoutMs_ * 1E6 / ecmcSmapleTimeNS_);
+    sourceDataItemInfo_ = replay_->getSourceInfo();
+    if(isEcDataTypeBit(sourceDataItemInfo_->dataType)) {
+      SCOPE_DBG_PRINT("ERROR: Replay not supported in logic analyzer mode.\n");
+      throw std::invalid_argument( "ERROR: Replay not supported in logic analyzer mode.");
+    }
+  }
+  // Several sources: logic analyzer mode
+  else if(strchr(cfgDataSourceStr_, ECMC_PLUGIN_SOURCE_SEPARATOR)) {
+    connectLogicSources();
+  }
+  else {
+    // Get source dataItem
+    sourceDataItem_        = findDataItem(cfgDataSourceStr_);
+    if(!sourceDataItem_) {
+      SCOPE_DBG_PRINT("ERROR: Source dataitem NULL.\n");
+      throw std::runtime_error( "ERROR: Source dataitem NULL." );
+    }
+    sourceDataItemInfo_ = sourceDataItem_->getDataItemInfo();
+
+    if(!sourceDataItemInfo_) {
+      SCOPE_DBG_PRINT("ERROR: Source dataitem info NULL.\n");
+      throw std::runtime_error( "ERROR: Source dataitem info NULL." );
+    }
 
-  // Get source dataItem
-  sourceDataItem_        = (ecmcDataItem*) getEcmcDataItem(cfgDataSourceStr_);
-  if(!sourceDataItem_) {
-    SCOPE_DBG_PRINT("ERROR: Source dataitem NULL.\n");
-    throw std::runtime_error( "ERROR: Source dataitem NULL." );
+    // Bit source: logic analyzer mode
+    if(isEcDataTypeBit(sourceDataItemInfo_->dataType)) {
+      connectLogicSources();
+    }
   }
-  sourceDataItemInfo_ = sourceDataItem_->getDataItemInfo();
 
-  if(!sourceDataItemInfo_) {
-    SCOPE_DBG_PRINT("ERROR: Source dataitem info NULL.\n");
-    throw std::runtime_error( "ERROR: Source dataitem info NULL." );
+  // Context items (resolved once, snapshot at trigger)
+  if(cfgContextStr_) {
+    connectContextItems();
   }
 
-  // Allocate buffer for result
-  resultDataBuffer_      = new uint8_t[cfgBufferElementCount_ * sourceDataItemInfo_->dataElementSize];
-  memset(&resultDataBuffer_[0],0,cfgBufferElementCount_ * sourceDataItemInfo_->dataElementSize);
+  // Allocate buffer for result (frame header in front of data and context after, see ecmcScopeFrame.h)
   resultDataBufferBytes_ = cfgBufferElementCount_ * sourceDataItemInfo_->dataElementSize;
-  // Data for last scan cycle
-  lastScanSourceDataBuffer_      = new uint8_t[sourceDataItemInfo_->dataSize];
-  memset(&lastScanSourceDataBuffer_[0],0,sourceDataItemInfo_->dataSize);
+  size_t contextOffset   = (sizeof(ecmcScopeFrameHeader) + resultDataBufferBytes_ + 7) & ~(size_t)7;
+  captureBufferBytes_    = contextOffset + contextCount_ * sizeof(double);
+  if(cfgChunkElements_) {
+    // Large capture mode: huge pages if available (prefaulted and zeroed)
+    int hugePages = 0;
+    captureBuffer_ = ecmcScopeMemAlloc(captureBufferBytes_, &captureBufferMapped_, &hugePages);
+    if(!hugePages) {
+      SCOPE_DBG_PRINT("WARNING: Huge pages not available for capture buffer (normal pages used).\n");
+    }
+  }
+  else {
+    captureBuffer_       = new uint8_t[captureBufferBytes_];
+    memset(&captureBuffer_[0],0,captureBufferBytes_);
+  }
+  frameHeader_           = (ecmcScopeFrameHeader*)captureBuffer_;
+  resultDataBuffer_      = captureBuffer_ + sizeof(ecmcScopeFrameHeader);
+  contextValues_         = (double*)(captureBuffer_ + contextOffset);
+  frameHeader_->magic       = ECMC_SCOPE_FRAME_MAGIC;
+  frameHeader_->version     = ECMC_SCOPE_FRAME_VERSION;
+  frameHeader_->headerBytes = sizeof(ecmcScopeFrameHeader);
+  frameHeader_->elements    = (uint32_t)cfgBufferElementCount_;
+  frameHeader_->dataType    = (uint8_t)sourceDataItemInfo_->dataType;
+  frameHeader_->elementSize = (uint8_t)sourceDataItemInfo_->dataElementSize;
+  frameHeader_->contextCount = (uint8_t)contextCount_;
+  // Data for last scan cycle (shared between scopes on same source if possible)
+  if(!logic_ && !replay_ && sources) {
+    source_ = sources->get(sourceDataItem_);
+  }
+  sharedHistory_ = source_ && cfgExecCycles_ <= 1;
+  if(!sharedHistory_) {
+    lastScanSourceDataBuffer_      = new uint8_t[sourceDataItemInfo_->dataSize];
+    memset(&lastScanSourceDataBuffer_[0],0,sourceDataItemInfo_->dataSize);
+  }
   sourceElementsPerSample_ = sourceDataItemInfo_->dataSize / sourceDataItemInfo_->dataElementSize;
-  sourceSampleRateNS_    = ecmcSmapleTimeNS_ / sourceElementsPerSample_;
-  
-  // Get source nexttime dataItem
-  sourceDataNexttimeItem_        = (ecmcDataItem*) getEcmcDataItem(cfgDataNexttimeStr_);
-  if(!sourceDataNexttimeItem_) {
-    SCOPE_DBG_PRINT("ERROR: Source nexttime dataitem NULL.\n");
-    throw std::runtime_error( "ERROR: Source nexttime dataitem NULL." );
+  setEcDataFromDouble(gapFillElement_, sourceDataItemInfo_->dataType, cfgGapFillValue_);
+
+  // History of scans for sub rate execution (one extra slot keeps the
+  // previous scan of the oldest scan in a batch). The first batch is
+  // shortened by the object id so scopes process their batches in
+  // different cycles.
+  if(cfgExecCycles_ > 1) {
+    historySlots_      = (size_t)cfgExecCycles_ + 1;
+    historyDataBuffer_ = new uint8_t[sourceDataItemInfo_->dataSize * historySlots_];
+    memset(&historyDataBuffer_[0],0,sourceDataItemInfo_->dataSize * historySlots_);
+    historyNexttime_   = new uint64_t[historySlots_];
+    memset(&historyNexttime_[0],0,sizeof(uint64_t) * historySlots_);
+    historyTriggValues_ = new uint64_t[ECMC_SCOPE_TRIGG_MAX_SOURCES * historySlots_];
+    memset(&historyTriggValues_[0],0,sizeof(uint64_t) * ECMC_SCOPE_TRIGG_MAX_SOURCES * historySlots_);
+    historyBatch_      = (size_t)(cfgExecCycles_ - objectId_ % cfgExecCycles_);
   }
-  sourceDataNexttimeItemInfo_ = sourceDataNexttimeItem_->getDataItemInfo();
-  
-  if(!sourceDataNexttimeItemInfo_) {
-    SCOPE_DBG_PRINT("ERROR: Source nexttime dataitem info NULL.\n");
-    throw std::runtime_error( "ERROR: Source nexttime dataitem info NULL." );
+
+  // Sliding window for roll mode (allocated also if mode is changed at runtime, not in large capture mode)
+  if(!cfgChunkElements_) {
+    rollDataBuffer_ = new uint8_t[resultDataBufferBytes_];
+    memset(&rollDataBuffer_[0],0,resultDataBufferBytes_);
+  }
+
+  // Chunks for large capture mode (header + data)
+  if(cfgChunkElements_ && logic_) {
+    SCOPE_DBG_PRINT("ERROR: Large capture mode not supported in logic analyzer mode.\n");
+    throw std::invalid_argument( "ERROR: Large capture mode not supported in logic analyzer mode.");
+  }
+  if(cfgChunkElements_) {
+    if((size_t)cfgChunkElements_ > cfgBufferElementCount_) {
+      cfgChunkElements_ = (int)cfgBufferElementCount_;
+    }
+    chunkBufferBytes_ = sizeof(ecmcScopeChunkHeader) + cfgChunkElements_ * sourceDataItemInfo_->dataElementSize;
+    chunkBuffer_      = new uint8_t[chunkBufferBytes_];
+    memset(&chunkBuffer_[0],0,chunkBufferBytes_);
+    chunkHeader_              = (ecmcScopeChunkHeader*)chunkBuffer_;
+    chunkHeader_->magic       = ECMC_SCOPE_CHUNK_MAGIC;
+    chunkHeader_->version     = ECMC_SCOPE_CHUNK_VERSION;
+    chunkHeader_->headerBytes = sizeof(ecmcScopeChunkHeader);
+    chunkHeader_->dataType    = (uint8_t)sourceDataItemInfo_->dataType;
+    chunkHeader_->elementSize = (uint8_t)sourceDataItemInfo_->dataElementSize;
+  }
+
+  // Buffer for compressed result (header + worst case raw)
+  if(cfgCompress_) {
+    compressedDataBufferBytes_ = ecmcScopeCodecMaxBytes(cfgBufferElementCount_,
+                                                        sourceDataItemInfo_->dataElementSize);
+    compressedDataBuffer_      = new uint8_t[compressedDataBufferBytes_];
+    memset(&compressedDataBuffer_[0],0,compressedDataBufferBytes_);
+  }
+
+  // Unpacked result and transition list for logic analyzer mode
+  if(logic_) {
+    logicChannelBufferBytes_ = cfgBufferElementCount_ * logic_->getChannelCount();
+    logicChannelBuffer_      = new uint8_t[logicChannelBufferBytes_];
+    memset(&logicChannelBuffer_[0],0,logicChannelBufferBytes_);
+    logicTransBufferBytes_   = cfgBufferElementCount_ * ECMC_SCOPE_LOGIC_TRANS_WORDS * sizeof(int32_t);
+    logicTransBuffer_        = new int32_t[cfgBufferElementCount_ * ECMC_SCOPE_LOGIC_TRANS_WORDS];
+    memset(&logicTransBuffer_[0],0,logicTransBufferBytes_);
+  }
+
+  // Equivalent time sampling accumulator and result (factor times finer grid)
+  if(cfgEtsFactor_ && logic_) {
+    SCOPE_DBG_PRINT("ERROR: Equivalent time sampling not supported in logic analyzer mode.\n");
+    throw std::invalid_argument( "ERROR: Equivalent time sampling not supported in logic analyzer mode.");
+  }
+  if(cfgEtsFactor_) {
+    ets_                = new ecmcScopeEts(cfgBufferElementCount_, cfgEtsFactor_, sourceDataItemInfo_->dataType);
+    etsDataBufferBytes_ = cfgBufferElementCount_ * cfgEtsFactor_ * sizeof(double);
+    etsDataBuffer_      = new double[cfgBufferElementCount_ * cfgEtsFactor_];
+    memset(&etsDataBuffer_[0],0,etsDataBufferBytes_);
+  }
+
+  // Statistics of each capture (one pass over the capture in rt)
+  if(cfgStats_ && logic_) {
+    SCOPE_DBG_PRINT("ERROR: Statistics not supported in logic analyzer mode.\n");
+    throw std::invalid_argument( "ERROR: Statistics not supported in logic analyzer mode.");
+  }
+
+  // Mask test of each capture
+  if(cfgMask_ && logic_) {
+    SCOPE_DBG_PRINT("ERROR: Mask test not supported in logic analyzer mode.\n");
+    throw std::invalid_argument( "ERROR: Mask test not supported in logic analyzer mode.");
+  }
+  if(cfgMask_) {
+    mask_ = new ecmcScopeMask(cfgBufferElementCount_, sourceDataItemInfo_->dataType, objectId_);
+  }
+
+  // Persistence image (built in worker thread)
+  if(cfgPersistBins_ && logic_) {
+    SCOPE_DBG_PRINT("ERROR: Persistence not supported in logic analyzer mode.\n");
+    throw std::invalid_argument( "ERROR: Persistence not supported in logic analyzer mode.");
+  }
+  if(cfgPersistBins_) {
+    persist_ = new ecmcScopePersist(cfgBufferElementCount_,
+                                    cfgPersistBins_,
+                                    cfgPersistMin_,
+                                    cfgPersistMax_,
+                                    cfgPersistDecay_,
+                                    cfgPersistPublishMs_ / 1000,
+                                    sourceDataItemInfo_->dataType,
+                                    objectId_);
+  }
+
+  // Windowed readout (built in worker thread)
+  if(cfgViewPoints_ && logic_) {
+    SCOPE_DBG_PRINT("ERROR: Windowed readout not supported in logic analyzer mode.\n");
+    throw std::invalid_argument( "ERROR: Windowed readout not supported in logic analyzer mode.");
+  }
+  if(cfgViewPoints_) {
+    view_ = new ecmcScopeView(cfgBufferElementCount_,
+                              cfgViewPoints_,
+                              sourceDataItemInfo_->dataType,
+                              objectId_);
   }
 
-  // Get trigg dataItem
-  sourceTriggItem_        = (ecmcDataItem*) getEcmcDataItem(cfgTriggStr_);
-  if(!sourceTriggItem_) {
-    SCOPE_DBG_PRINT("ERROR: Trigg dataitem NULL.\n");
-    throw std::runtime_error( "ERROR: Trigg dataitem NULL." );
+  // Flight recorder (history entry: unwrapped NEXT_TIME followed by scan data)
+  if(cfgRecorderCaptures_) {
+    recorder_ = new ecmcScopeRecorder(captureBufferBytes_,
+                                      cfgRecorderCaptures_,
+                                      sizeof(uint64_t) + sourceDataItemInfo_->dataSize,
+                                      cfgRecorderHistoryCycles_,
+                                      objectId_);
   }
   
-  sourceTriggItemInfo_ = sourceTriggItem_->getDataItemInfo();
-  if(!sourceTriggItemInfo_) {
-    SCOPE_DBG_PRINT("ERROR: Trigg dataitem info NULL.\n");
-    throw std::runtime_error( "ERROR: Trigg dataitem info NULL." );
+  if(replay_) {
+    // Replay: recorded nexttime and trigger values (no data items)
+    connectReplaySources();
+  }
+  else {
+    // Get source nexttime dataItem
+    sourceDataNexttimeItem_        = findDataItem(cfgDataNexttimeStr_);
+    if(!sourceDataNexttimeItem_) {
+      SCOPE_DBG_PRINT("ERROR: Source nexttime dataitem NULL.\n");
+      throw std::runtime_error( "ERROR: Source nexttime dataitem NULL." );
+    }
+    sourceDataNexttimeItemInfo_ = sourceDataNexttimeItem_->getDataItemInfo();
+  
+    if(!sourceDataNexttimeItemInfo_) {
+      SCOPE_DBG_PRINT("ERROR: Source nexttime dataitem info NULL.\n");
+      throw std::runtime_error( "ERROR: Source nexttime dataitem info NULL." );
+    }
+
+    // Get trigg dataItems (separated by ',')
+    trigg_ = new ecmcScopeTrigg();
+    trigg_->setLogic(cfgTriggLogic_,
+                     cfgTriggWindowNs_,
+                     cfgTriggSeqTimeoutNs_,
+                     cfgTriggHoldoffNs_,
+                     cfgTriggPrescale_);
+    trigg_->setType(cfgTriggType_, cfgTriggLevel_);
+    trigg_->setCycleSource(sourceDataNexttimeItem_, ecmcSmapleTimeNS_);
+
+    char *pTriggStrs = strdup(cfgTriggStr_);
+    char *pThisTrigg = pTriggStrs;
+    while (pThisTrigg && pThisTrigg[0]) {
+      char *pNextTrigg = strchr(pThisTrigg, ECMC_PLUGIN_TRIGG_SOURCE_SEPARATOR);
+      if (pNextTrigg) {
+        *pNextTrigg = '\0';
+        pNextTrigg++;
+      }
+      ecmcDataItem *triggItem = findDataItem(pThisTrigg);
+      if(!triggItem) {
+        free(pTriggStrs);
+        SCOPE_DBG_PRINT("ERROR: Trigg dataitem NULL.\n");
+        throw std::runtime_error( "ERROR: Trigg dataitem NULL." );
+      }
+      try {
+        trigg_->addSource(triggItem);
+      }
+      catch(...) {
+        free(pTriggStrs);
+        throw;
+      }
+      pThisTrigg = pNextTrigg;
+    }
+    free(pTriggStrs);
   }
 
-  if( sourceTriggItem_->read((uint8_t*)(&oldTriggTime_),sourceTriggItemInfo_->dataElementSize)){
-    SCOPE_DBG_PRINT("ERROR: Failed read trigg time.\n");
-    throw std::runtime_error( "ERROR: Failed read trigg time." );
+  // Timebase of source (32 bit unwrap if any of trigger or nexttime is 32 bit)
+  size_t bitCount = trigg_->getBitCount();
+  if(sourceDataNexttimeItemInfo_->dataBitCount < bitCount) {
+    bitCount = sourceDataNexttimeItemInfo_->dataBitCount;
   }
+  timebase_ = new ecmcScopeTimebase(ecmcSmapleTimeNS_, sourceElementsPerSample_, bitCount);
+  samplePeriodNs_ = timebase_->getSamplePeriodNs();
   
-  if(!sourceDataTypeSupported(sourceDataItem_->getEcmcDataType())) {
+  if(!logic_ && !sourceDataTypeSupported(sourceDataItemInfo_->dataType)) {
     SCOPE_DBG_PRINT("ERROR: Source data type not suppported.\n");
     throw std::runtime_error( "ERROR: Source data type not suppported.");
   }
@@ -282,6 +1184,43 @@ void ecmcScope::connectToDataSources() {
 
   dataSourceLinked_ = 1;
   scopeState_         = ECMC_SCOPE_STATE_WAIT_TRIGG;
+
+  // Replay: all records are processed in worker thread (results to file)
+  if(replay_) {
+    replayExitEvent_ = epicsEventCreate(epicsEventEmpty);
+    if(!replayExitEvent_) {
+      throw std::runtime_error( "ERROR: Failed create replay event.");
+    }
+    char threadName[64];
+    snprintf(threadName, sizeof(threadName), "ecmcScopeReplay%d", objectId_);
+    if(!epicsThreadCreate(threadName,
+                          epicsThreadPriorityLow,
+                          epicsThreadGetStackSize(epicsThreadStackMedium),
+                          replayThread,
+                          this)) {
+      epicsEventDestroy(replayExitEvent_);
+      replayExitEvent_ = NULL;
+      throw std::runtime_error( "ERROR: Failed create replay thread.");
+    }
+  }
+}
+
+/** Replay: recorded nexttime and trigger values. Trigger sources are
+ *  evaluated exactly like live data items (same logic, type and holdoff).
+*/
+void ecmcScope::connectReplaySources() {
+  sourceDataNexttimeItemInfo_ = replay_->getNexttimeInfo();
+  trigg_ = new ecmcScopeTrigg();
+  trigg_->setLogic(cfgTriggLogic_,
+                   cfgTriggWindowNs_,
+                   cfgTriggSeqTimeoutNs_,
+                   cfgTriggHoldoffNs_,
+                   cfgTriggPrescale_);
+  trigg_->setType(cfgTriggType_, cfgTriggLevel_);
+  for(int i = 0; i < replay_->getTriggCount(); ++i) {
+    trigg_->addRecordedSource(replay_->getTriggInfo());
+  }
+  trigg_->setRecordedCycle(replay_->getCycleNs(), sourceDataNexttimeItemInfo_->dataBitCount);
 }
 
 bool ecmcScope::sourceDataTypeSupported(ecmcEcDataType dt) {
@@ -316,40 +1255,241 @@ bool ecmcScope::sourceDataTypeSupported(ecmcEcDataType dt) {
  * If the trigger is newer than "NEXT_TIME" then the dc clocks must be out of sync (see readme)
  * The analog samples from the prev cycles is always buffered to be able to also handle older timestamps (up to 2*NELM back in time) 
 */
-void ecmcScope::execute() {
+void ecmcScope::execute(int ecmcError) {
 
-  size_t bytesToCp = 0;
+  // Replay: state owned by worker thread until all records are processed
+  if(replay_) {
+    publishReplay();
+    return;
+  }
+
+  // Freeze flight recorder on new ecmc error (only a flag, content published next cycle)
+  if(recorder_ && cfgRecorderFreezeOnError_ && ecmcError && ecmcError != lastEcmcError_) {
+    applyFreeze(ecmcError);
+  }
+  lastEcmcError_ = ecmcError;
+
+  // Control changes (plc and asyn) take effect on cycle boundary
+  drainCommands();
+
+  // Large capture mode: remaining chunks of completed capture (one per cycle)
+  chunkThisCycle_ = 0;
+  if(chunkDrain_) {
+    publishChunk();
+  }
+
+  // Flight recorder content (copied by recorder worker)
+  if(recorder_) {
+    publishRecorder();
+  }
+
+  // Trigger decisions of last cycle
+  if(triggLogDirty_) {
+    publishTriggLog();
+  }
+
+  // Persistence image from worker
+  if(persist_ && persist_->imageReady()) {
+    asynPersist_->refreshParam(1);
+    persist_->imageDone();
+  }
+
+  // Windowed readout from worker
+  if(view_ && view_->viewReady()) {
+    asynView_->refreshParam(1, (uint8_t*)view_->getView(), view_->getViewBytes());
+    view_->viewDone();
+  }
+
+  // Evaluate trigger sources (sub rate: evaluated when the scan is recorded)
+  int triggEval = ECMC_SCOPE_TRIGG_EVAL_NONE;
+  if(cfgExecCycles_ <= 1) {
+    triggEval = trigg_->evaluate(&triggTime_);
+  }
+  newTrigg_ = triggEval == ECMC_SCOPE_TRIGG_EVAL_NEW;
 
   // Ensure ethercat bus is started
   if(getEcmcEpicsIOCState() < 15) {
+    if(newTrigg_) {
+      logTrigg(ECMC_SCOPE_TRIGG_DROP_BUS);
+    }
     bytesInResultBuffer_ = 0;
     scopeState_ = ECMC_SCOPE_STATE_WAIT_TRIGG;
+    timebase_->reset();
+    lastScanValid_ = 0;
+    historyCount_  = 0;
     // Wait for new trigg
     setWaitForNextTrigg();
     return;
   }
 
-  // Read trigg data
-  if( sourceTriggItem_->read((uint8_t*)&triggTime_,sourceTriggItemInfo_->dataElementSize)){
-    SCOPE_DBG_PRINT("ERROR: Failed read trigg time.\n");
-    throw std::runtime_error( "ERROR: Failed read trigg time." );
-  }
-
   // Read next sync timestamp
   if( sourceDataNexttimeItem_->read((uint8_t*)&sourceNexttime_,sourceDataNexttimeItemInfo_->dataElementSize)){
     SCOPE_DBG_PRINT("ERROR: Failed read ai nexttime.\n");
     throw std::runtime_error( "ERROR: Failed read nexttime." );
   }
 
-  // Ensure enabled
-  if(!cfgEnable_) {
-    bytesInResultBuffer_ = 0;
-    scopeState_ = ECMC_SCOPE_STATE_WAIT_TRIGG;
+  // Logic analyzer mode: pack channels of this cycle (read by readSource())
+  if(logic_) {
+    logic_->pack();
+  }
+
+  if(recorder_) {
+    recordScan();
+  }
+
+  if(cfgExecCycles_ > 1) {
+    executeSubRate();
+    return;
+  }
+  executeScan(triggEval);
+
+  if(sharedHistory_) {
+    updateHistoryUser();
+  }
+}
+
+/** Previous scan of shared source is only kept while this scope waits for a
+ *  trigger (nothing is copied for disabled, done, collecting or roll mode).
+*/
+void ecmcScope::updateHistoryUser() {
+  int user = cfgEnable_ && scopeState_ == ECMC_SCOPE_STATE_WAIT_TRIGG &&
+             activeMode_ != ECMC_SCOPE_MODE_ROLL;
+  if(user != historyUser_) {
+    source_->addHistoryUser(user ? 1 : -1);
+    historyUser_ = user;
+  }
+}
+
+/** Sub rate execution (EXEC_CYCLES > 1).
+ *  Each cycle the scan data, NEXT_TIME and the trigger evaluation are
+ *  recorded in the history ring. Every EXEC_CYCLES cycle the recorded scans
+ *  are processed (oldest first) exactly like in normal execution. The
+ *  previous scan is read in place from the ring (no last scan copy).
+ *  Nothing is recorded while disabled or done (single shot) unless a
+ *  command is pending, the scan is then handled directly.
+*/
+void ecmcScope::executeSubRate() {
+  if(historyCount_ == 0 && !armCmd_ && cfgMode_ == activeMode_ &&
+     (!cfgEnable_ || scopeState_ == ECMC_SCOPE_STATE_IDLE)) {
+    executeScan(trigg_->evaluate(&triggTime_));
+    return;
+  }
+
+  // Record only (NEXT_TIME, raw trigger sources and scan)
+  size_t dataSize = sourceDataItemInfo_->dataSize;
+  size_t slot     = (historyStart_ + historyCount_) % historySlots_;
+  historyNexttime_[slot] = sourceNexttime_;
+  trigg_->readSources(&historyTriggValues_[slot * ECMC_SCOPE_TRIGG_MAX_SOURCES]);
+  if( readSource(&historyDataBuffer_[slot * dataSize],dataSize)){
+    SCOPE_DBG_PRINT("ERROR: Failed read data source.\n");
+    throw std::runtime_error( "ERROR: Failed read data source." );
+  }
+  historyCount_++;
+  if(historyCount_ < historyBatch_) {
+    return;
+  }
+
+  // Batch: evaluate triggers in order, the state machine only runs for
+  // scans that are not just waiting for a trigger
+  for(size_t i = 0; i < historyCount_; ++i) {
+    slot            = (historyStart_ + i) % historySlots_;
+    sourceNexttime_ = historyNexttime_[slot];
+    int triggEval   = trigg_->evaluateRecorded(&historyTriggValues_[slot * ECMC_SCOPE_TRIGG_MAX_SOURCES],
+                                               sourceNexttime_, &triggTime_);
+    if(isWaitingScan(triggEval)) {
+      timebase_->update(sourceNexttime_);
+      lastScanNexttime_ = timebase_->getNexttime();
+      lastScanValid_    = 1;
+      continue;
+    }
+    replayData_     = &historyDataBuffer_[slot * dataSize];
+    historyLast_    = &historyDataBuffer_[((slot + historySlots_ - 1) % historySlots_) * dataSize];
+    executeScan(triggEval);
+  }
+  replayData_    = NULL;
+  historyLast_   = NULL;
+  historyStart_  = (historyStart_ + historyCount_) % historySlots_;
+  historyCount_  = 0;
+  historyBatch_  = (size_t)cfgExecCycles_;
+}
+
+/** Scan that executeScan() would only use to track the timebase: waiting
+ *  for a trigger (normal or single mode), no trigger and no pending
+ *  control change.
+*/
+bool ecmcScope::isWaitingScan(int triggEval) {
+  return triggEval == ECMC_SCOPE_TRIGG_EVAL_NONE && cfgEnable_ &&
+         scopeState_ == ECMC_SCOPE_STATE_WAIT_TRIGG &&
+         (activeMode_ == ECMC_SCOPE_MODE_NORMAL || activeMode_ == ECMC_SCOPE_MODE_SINGLE) &&
+         cfgMode_ == activeMode_ && !armCmd_ && !triggOnce_;
+}
+
+/** Process one scan (current scan, or recorded scan in sub rate execution)*/
+void ecmcScope::executeScan(int triggEval) {
+
+  size_t bytesToCp = 0;
+  int    collectCycles = 1;
+
+  newTrigg_ = triggEval == ECMC_SCOPE_TRIGG_EVAL_NEW;
+  timebase_->update(sourceNexttime_);
+
+  if(triggEval == ECMC_SCOPE_TRIGG_EVAL_HOLDOFF) {
+    logTrigg(ECMC_SCOPE_TRIGG_DROP_HOLDOFF);
+  }
+  else if(triggEval == ECMC_SCOPE_TRIGG_EVAL_PRESCALE) {
+    logTrigg(ECMC_SCOPE_TRIGG_DROP_PRESCALE);
+  }
+
+  // Mode changed (asyn or plc), start over
+  if(cfgMode_ != activeMode_) {
+    applyMode();
+  }
+
+  // Arm requested (asyn or plc)
+  if(armCmd_) {
+    armCmd_ = 0;
+    if(scopeState_ == ECMC_SCOPE_STATE_IDLE) {
+      SCOPE_DBG_PRINT("INFO: Scope armed.\n");
+      scopeState_ = ECMC_SCOPE_STATE_WAIT_TRIGG;
+    }
+  }
+
+  // Ensure enabled
+  if(!cfgEnable_) {
+    if(newTrigg_) {
+      logTrigg(ECMC_SCOPE_TRIGG_DROP_DISABLED);
+    }
+    triggOnce_ = 0;
+    bytesInResultBuffer_ = 0;
+    if(scopeState_ != ECMC_SCOPE_STATE_IDLE) {
+      scopeState_ = ECMC_SCOPE_STATE_WAIT_TRIGG;
+    }
     // Wait for new trigg
     setWaitForNextTrigg();
     return;
   }
 
+  // Single shot done. Nothing to do until re-armed.
+  if(scopeState_ == ECMC_SCOPE_STATE_IDLE) {
+    if(newTrigg_) {
+      logTrigg(ECMC_SCOPE_TRIGG_DROP_NOT_ARMED);
+    }
+    triggOnce_ = 0;
+    setWaitForNextTrigg();
+    return;
+  }
+
+  // Roll mode: triggers are not used
+  if(activeMode_ == ECMC_SCOPE_MODE_ROLL) {
+    if(newTrigg_) {
+      logTrigg(ECMC_SCOPE_TRIGG_DROP_NOT_ARMED);
+    }
+    triggOnce_ = 0;
+    executeRoll();
+    setWaitForNextTrigg();
+    return;
+  }
+
   switch(scopeState_) {
     case ECMC_SCOPE_STATE_INVALID:
       SCOPE_DBG_PRINT("ERROR: Invalid state (state = ECMC_SCOPE_STATE_INVALID).");
@@ -363,123 +1503,199 @@ void ecmcScope::execute() {
     
     case ECMC_SCOPE_STATE_WAIT_TRIGG:
 
-    // New trigger then collect data (or wait )
-    if(oldTriggTime_ != triggTime_ && !firstTrigg_) {      
+    // Auto mode: free run capture if no trigger within timeout
+    if(activeMode_ == ECMC_SCOPE_MODE_AUTO && !newTrigg_) {
+      autoCycleCounter_++;
+      if(autoCycleCounter_ >= autoTimeoutCycles_) {
+        SCOPE_DBG_PRINT("INFO: Auto mode timeout. Free run capture.\n");
+        triggOnce_ = 1;
+      }
+    }
+
+    // Large capture mode: last chunks of previous capture not yet published
+    if(chunkDrain_ && newTrigg_) {
+      SCOPE_DBG_PRINT("WARNING: Latch while publishing last chunks. This trigger will be disregarded.\n");
+      logTrigg(ECMC_SCOPE_TRIGG_DROP_BUSY);
+      setWaitForNextTrigg();
+      missedTriggs_++;
+      asynMissedTriggs_->refreshParam(1);
+      break;
+    }
+    if(chunkDrain_) {
+      break;  // Software trigger and auto capture wait
+    }
+
+    // New trigger (or software trigger) then collect data (or wait )
+    if(newTrigg_ || triggOnce_) {
+      autoCycleCounter_ = 0;
+
       //printf("sourceNexttime_=%" PRIu64 " ,sourceDataNexttimeItemInfo_->dataSize = %zu\n",sourceNexttime_,sourceDataNexttimeItemInfo_->dataSize);
 
-      // calculate how many samples ago trigger occured     
-      samplesSinceLastTrigg_ = timeDiff() / sourceSampleRateNS_;
-      asynTimeTrigg2Sample_->refreshParam(1);
+      double samples = 0;
+      if(triggOnce_) {
+        // Software trigger: start at first sample of current scan
+        samples = sourceElementsPerSample_;
+        captureTriggTime_ = timebase_->getNexttime() - timebase_->getCycleNs();
+        captureFlags_ = ECMC_SCOPE_FRAME_SOFT_TRIGG;
+        triggPhase_ = -1;
+        triggOnce_ = 0;
+      }
+      else if(trigg_->isCycleAligned()) {
+        // Value trigger: first sample of current scan (NEXT_TIME - one cycle)
+        samples = sourceElementsPerSample_;
+        captureTriggTime_ = timebase_->getNexttime() - timebase_->getCycleNs();
+        captureFlags_ = 0;
+      }
+      else {
+        // calculate how many samples ago trigger occured (tracked sample period)
+        samples = timeDiff() / timebase_->getSamplePeriodNs();
+        captureTriggTime_ = timebase_->unwrap(triggTime_);
+        captureFlags_ = 0;
+      }
+      samplesSinceLastTrigg_ = (double)(int64_t)samples;
+      if(!replay_) {  // Replay: published when done
+        asynTimeTrigg2Sample_->refreshParam(1);
+      }
 
       if( samplesSinceLastTrigg_ > sourceElementsPerSample_ * 2 || samplesSinceLastTrigg_ < 0) {
         SCOPE_DBG_PRINT("WARNING: Invalid trigger (occured more than two ethercat cycles ago or in future)..");
+        logTrigg(samplesSinceLastTrigg_ < 0 ? ECMC_SCOPE_TRIGG_DROP_FUTURE : ECMC_SCOPE_TRIGG_DROP_OLD);
         missedTriggs_++;
-        asynMissedTriggs_->refreshParam(1);
+        if(!replay_) {  // Replay: published when done
+          asynMissedTriggs_->refreshParam(1);
+        }
         // Wait for new trigg (skip this trigger)
         setWaitForNextTrigg();
-        return;
-      }
-      
-      // printf("samplesSinceLastTrigg_=%lf\n",samplesSinceLastTrigg_);
-      
-      SCOPE_DBG_PRINT("INFO: New trigger detected.\n");      
-      
-      // Copy from last scan buffer if needed (if trigger occured during last scan)
-      if(samplesSinceLastTrigg_ > sourceElementsPerSample_) {
-        bytesToCp = (samplesSinceLastTrigg_ - sourceElementsPerSample_) * sourceDataItemInfo_->dataElementSize;
-        if(resultDataBufferBytes_ < bytesToCp) {
-          bytesToCp = resultDataBufferBytes_;
-        }
-        size_t startByte = (sourceElementsPerSample_*2-samplesSinceLastTrigg_) * sourceDataItemInfo_->dataElementSize;
-        
-        
-        memcpy( &resultDataBuffer_[0], &lastScanSourceDataBuffer_[startByte], bytesToCp);
-        bytesInResultBuffer_ = bytesToCp;
+        break;
       }
 
-      // Copy from current scan if needed
-      if(bytesInResultBuffer_ < resultDataBufferBytes_) {              
-        bytesToCp = sourceDataItemInfo_->dataSize;
-        // Ensure not to much data is copied
-        if(bytesToCp > (resultDataBufferBytes_ - bytesInResultBuffer_)) {
-          bytesToCp = resultDataBufferBytes_ - bytesInResultBuffer_;
-        }
-        
-        // Write directtly into results buffer
-        if( sourceDataItem_->read((uint8_t*)&resultDataBuffer_[bytesInResultBuffer_],bytesToCp)){
-          SCOPE_DBG_PRINT("ERROR: Failed read data source.\n");
-          throw std::runtime_error( "ERROR: Failed read data source." );
-        }
-        bytesInResultBuffer_ += bytesToCp;
-      }
+      captureValid_ = 1;
+      captureGaps_  = 0;
 
-      // If more data is needed the go to collect state.
-      if(bytesInResultBuffer_ < resultDataBufferBytes_) {
-        // Fill more data from next scan
-        scopeState_ = ECMC_SCOPE_STATE_COLLECT;          
-      }
-      else {  // The data from current scan was enough. send over asyn and then start over (wait for next trigger)        
-        resultParam_->refreshParam(1);
-        bytesInResultBuffer_ = 0;
-     
-        triggerCounter_++;
-        asynTriggerCounter_->refreshParam(1);
+      // Trigger accepted: context of this cycle
+      snapshotContext();
 
-        SCOPE_DBG_PRINT("INFO: Result Buffer full. Data push over asyn..\n");
+      // Capture starts at trigger + delay (samples from start to NEXT_TIME)
+      if(cfgTriggDelaySamples_) {
+        captureDelayNs_ = cfgTriggDelay_ * timebase_->getSamplePeriodNs();
+        startSamples_   = samples - cfgTriggDelay_;
+      }
+      else {
+        captureDelayNs_ = cfgTriggDelay_;
+        startSamples_   = samples - cfgTriggDelay_ / timebase_->getSamplePeriodNs();
+      }
 
-        if(cfgDbgMode_) {
-          printEcDataArray(resultDataBuffer_,resultDataBufferBytes_,sourceDataItemInfo_->dataType,objectId_);
+      if(startSamples_ > 0) {
+        startCapture();
+      }
+      else {
+        // Start not reached. Nothing is buffered until start.
+        if(newTrigg_) {
+          logTrigg(ECMC_SCOPE_TRIGG_ACCEPTED);
         }
+        SCOPE_DBG_PRINT("INFO: New trigger detected. Change state to ECMC_SCOPE_STATE_WAIT_NEXT.\n");
+        scopeState_ = ECMC_SCOPE_STATE_WAIT_NEXT;
       }
     }
     
-    // Avoid first rubbish trigger timestamp (when first value is read from bus it will differ from "0" and therefor trigger)
-    if(oldTriggTime_ != triggTime_) {
-      firstTrigg_ = 0;  
-    }
-
     // This trigg is handled. Wait for next trigger
     setWaitForNextTrigg();
 
     break;
 
+    // Trigger accepted, waiting for start of capture (TRIGG_DELAY)
+    case ECMC_SCOPE_STATE_WAIT_NEXT:
+
+      if (newTrigg_) {
+        SCOPE_DBG_PRINT("WARNING: Latch during trigger delay. This trigger will be disregarded.\n");
+        logTrigg(ECMC_SCOPE_TRIGG_DROP_BUSY);
+        setWaitForNextTrigg();
+        missedTriggs_++;
+        if(!replay_) {  // Replay: published when done
+          asynMissedTriggs_->refreshParam(1);
+        }
+      }
+
+      // Advance exactly the cycles NEXT_TIME moved (nothing buffered while waiting)
+      collectCycles = cyclesSinceLastScan();
+      if(collectCycles < 0) {
+        SCOPE_DBG_PRINT("WARNING: Timebase lost during trigger delay. Capture aborted.\n");
+        scopeState_ = ECMC_SCOPE_STATE_WAIT_TRIGG;
+        break;
+      }
+      startSamples_ += collectCycles * sourceElementsPerSample_;
+
+      // Start before current scan (only after lost frames). The last scan is
+      // not kept while waiting so these samples can only be filled.
+      if(startSamples_ > sourceElementsPerSample_ && cfgGapPolicy_ != ECMC_SCOPE_GAP_FILL) {
+        SCOPE_DBG_PRINT("WARNING: Lost frames during trigger delay. This trigger will be disregarded.\n");
+        logTrigg(ECMC_SCOPE_TRIGG_DROP_GAP);
+        scopeState_ = ECMC_SCOPE_STATE_WAIT_TRIGG;
+        break;
+      }
+
+      if(startSamples_ > 0) {
+        startCapture();
+      }
+
+    break;
+
     case ECMC_SCOPE_STATE_COLLECT:
 
-      if (oldTriggTime_ != triggTime_) {
+      if (newTrigg_) {
         SCOPE_DBG_PRINT("WARNING: Latch during sampling of data. This trigger will be disregarded.\n");        
+        logTrigg(ECMC_SCOPE_TRIGG_DROP_BUSY);
         setWaitForNextTrigg();
         missedTriggs_++;
-        asynMissedTriggs_->refreshParam(1);
+        if(!replay_) {  // Replay: published when done
+          asynMissedTriggs_->refreshParam(1);
+        }
       }
-      
-      // Ensure not to much data is copied
-      if(bytesInResultBuffer_ < resultDataBufferBytes_) {              
+
+      // NEXT_TIME must advance exactly one cycle for each append
+      collectCycles = cyclesSinceLastScan();
+      if(collectCycles != 1) {
+        SCOPE_DBG_PRINT("WARNING: Lost or repeated frame during collect.\n");
+        if(!handleGap(collectCycles)) {
+          setWaitForNextTrigg();
+          break;
+        }
+      }
+
+      // Ensure not to much data is copied (skip repeated frame if FILL)
+      if(bytesInResultBuffer_ < resultDataBufferBytes_ &&
+         (collectCycles >= 1 || cfgGapPolicy_ != ECMC_SCOPE_GAP_FILL)) {
         bytesToCp = sourceDataItemInfo_->dataSize;
         if(bytesToCp > (resultDataBufferBytes_ - bytesInResultBuffer_)) {
           bytesToCp = resultDataBufferBytes_ - bytesInResultBuffer_;
         }
         
         // Write directtly into results buffer
-        if( sourceDataItem_->read((uint8_t*)&resultDataBuffer_[bytesInResultBuffer_],bytesToCp)){
+        if( readSource((uint8_t*)&resultDataBuffer_[bytesInResultBuffer_],bytesToCp)){
           SCOPE_DBG_PRINT("ERROR: Failed read data source..\n");
           throw std::runtime_error( "ERROR: Failed read data source." );
         }
         bytesInResultBuffer_ += bytesToCp;
       }
+
+      // Large capture mode: publish completed chunks while collecting
+      if(chunkBuffer_ && bytesInResultBuffer_ < resultDataBufferBytes_) {
+        chunkEndBytes_ = bytesInResultBuffer_;
+        publishChunk();
+      }
      
       if(bytesInResultBuffer_ >= resultDataBufferBytes_) {
-        resultParam_->refreshParam(1);
-        bytesInResultBuffer_ = 0;
-        triggerCounter_++;
-        asynTriggerCounter_->refreshParam(1);
-        scopeState_ = ECMC_SCOPE_STATE_WAIT_TRIGG;
+        publishResult();
+        if(activeMode_ == ECMC_SCOPE_MODE_SINGLE) {
+          scopeState_ = ECMC_SCOPE_STATE_IDLE;
+          SCOPE_DBG_PRINT("INFO: Change state to ECMC_SCOPE_STATE_IDLE.\n");
+        }
+        else {
+          scopeState_ = ECMC_SCOPE_STATE_WAIT_TRIGG;
+          SCOPE_DBG_PRINT("INFO: Change state to ECMC_SCOPE_STATE_WAIT_TRIGG.\n");
+        }
        // Wait for next trigger.
         setWaitForNextTrigg();
-        SCOPE_DBG_PRINT("INFO: Change state to ECMC_SCOPE_STATE_WAIT_TRIGG.\n");
-        SCOPE_DBG_PRINT("INFO: Result Buffer full. Data push over asyn..\n");
-        if(cfgDbgMode_) {
-          printEcDataArray(resultDataBuffer_,resultDataBufferBytes_,sourceDataItemInfo_->dataType,objectId_);
-        }
       }
 
       // Wait for next trigger.
@@ -498,408 +1714,1840 @@ void ecmcScope::execute() {
     break;
   }
   
-  // Read source data to last scan buffer (only one "old" scan seems to be needed)
-  if( sourceDataItem_->read((uint8_t*)&lastScanSourceDataBuffer_[0],sourceDataItemInfo_->dataSize)){
-    SCOPE_DBG_PRINT("ERROR: Failed read data source..\n");
-    throw std::runtime_error( "ERROR: Failed source data." );
+  // Read source data to last scan buffer (only one "old" scan seems to be needed).
+  // Only needed while waiting for trigger (trigger may refer to previous cycle).
+  // Shared source: previous scan kept by source, sub rate: previous scan in history ring
+  if(!sharedHistory_ && !historyLast_ && scopeState_ == ECMC_SCOPE_STATE_WAIT_TRIGG) {
+    if( readSource((uint8_t*)&lastScanSourceDataBuffer_[0],sourceDataItemInfo_->dataSize)){
+      SCOPE_DBG_PRINT("ERROR: Failed read data source..\n");
+      throw std::runtime_error( "ERROR: Failed source data." );
+    }
   }
+  lastScanNexttime_ = timebase_->getNexttime();
+  lastScanValid_    = 1;
+}
 
+/** Data item by name. Resolved through the shared registry so that items
+ *  used by several scopes are only looked up once.
+*/
+ecmcDataItem *ecmcScope::findDataItem(const char *name) {
+  if(sources_) {
+    return sources_->getItem(name);
+  }
+  return (ecmcDataItem*) getEcmcDataItem((char*)name);
 }
 
-/** Calculate depending on bits (32 or 64 bit dc)
- *  If one is 32 bit then only compare lower 32 bits
- * sourceDataNexttimeItemInfo_ is always considered to happen in the future (after trigg)
- * If 32 bit registers then it can max be 2^32 ns between trigg and nexttime (approx 4s).
+/** Context items (separated by ','). Resolved once, then one read per item
+ *  and trigger (first element of arrays).
 */
-int64_t ecmcScope::timeDiff() {  
-  // retrun time from trigg to next
-  int64_t retVal = 0;
-  if(sourceTriggItemInfo_->dataBitCount < 64 || sourceDataNexttimeItemInfo_->dataBitCount < 64) {
-    // use only 32bit dc info
-    uint32_t trigg = getUint32((uint8_t*)&triggTime_);
-    uint32_t next  = getUint32((uint8_t*)&sourceNexttime_);
-
-    // Overflow... always report shortest timediff
-    if (std::abs( ((int64_t)next)-((int64_t)trigg)) > (int64_t)(ECMC_MAX_32BIT / 2)) {
-      if(next > trigg) {                
-        retVal = -(((int64_t)trigg) + ECMC_MAX_32BIT - ((int64_t)next));
-        //if(std::abs(retVal)>ECMC_MAX_32BIT/2)  printf("Overflow 1! %" PRId64 "\n", retVal);
-      } 
-      else {        
-        retVal = ((int64_t)next) + ECMC_MAX_32BIT - ((int64_t)trigg);
-        //if(std::abs(retVal)>ECMC_MAX_32BIT/2)  printf("Overflow 2! %" PRId64 "\n", retVal);
-      }      
+void ecmcScope::connectContextItems() {
+  char *pContextStrs = strdup(cfgContextStr_);
+  char *pThisItem = pContextStrs;
+  while (pThisItem && pThisItem[0]) {
+    char *pNextItem = strchr(pThisItem, ECMC_PLUGIN_CONTEXT_SEPARATOR);
+    if (pNextItem) {
+      *pNextItem = '\0';
+      pNextItem++;
     }
-    else {
-      retVal = ((int64_t)next)-((int64_t)trigg);
-      //if(std::abs(retVal)>ECMC_MAX_32BIT/2)  printf("timediff 3! %" PRId64 "\n", retVal);
-    }    
-  }
-  else {
-    // Both are 64 bit dc timestamps
-    retVal = sourceNexttime_ - triggTime_;
-    //if(std::abs(retVal)>ECMC_MAX_32BIT/2)  printf("timediff 4! %" PRId64 "\n", retVal);
+    if(contextCount_ >= ECMC_SCOPE_CONTEXT_MAX_ITEMS) {
+      free(pContextStrs);
+      SCOPE_DBG_PRINT("ERROR: Too many context items.\n");
+      throw std::out_of_range( "ERROR: Too many context items." );
+    }
+    ecmcDataItem *item = findDataItem(pThisItem);
+    if(!item || !item->getDataItemInfo()) {
+      free(pContextStrs);
+      SCOPE_DBG_PRINT("ERROR: Context dataitem NULL.\n");
+      throw std::runtime_error( "ERROR: Context dataitem NULL." );
+    }
+    contextItems_[contextCount_]     = item;
+    contextItemInfos_[contextCount_] = item->getDataItemInfo();
+    contextCount_++;
+    pThisItem = pNextItem;
   }
-
-  return retVal;
+  free(pContextStrs);
 }
 
-void ecmcScope::printEcDataArray(uint8_t*       data, 
-                                 size_t         size,
-                                 ecmcEcDataType dt,
-                                 int objId) {
-  printf("INFO: Scope id: %d, data: ",objId);
-
-  size_t dataElementSize = getEcDataTypeByteSize(dt);
-
-  uint8_t *pData = data;
-  for(unsigned int i = 0; i < size / dataElementSize; ++i) {    
-    if(i % 10 == 0) {
-      printf("\n");
-    } else {
-      printf(", ");
+// Read context items into frame (rt)
+void ecmcScope::snapshotContext() {
+  uint8_t raw[8];
+  for(int i = 0; i < contextCount_; ++i) {
+    size_t bytes = contextItemInfos_[i]->dataElementSize;
+    if(bytes > sizeof(raw)) {
+      bytes = sizeof(raw);
     }
-    switch(dt) {
-      case ECMC_EC_U8:        
-        printf("%hhu",getUint8(pData));
-        break;
-      case ECMC_EC_S8:
-        printf("%hhd",getInt8(pData));
-        break;
-      case ECMC_EC_U16:
-        printf("%hu",getUint16(pData));
-        break;
-      case ECMC_EC_S16:
-        printf("%hd",getInt16(pData));
-        break;
-      case ECMC_EC_U32:
-        printf("%u",getUint32(pData));
-        break;
-      case ECMC_EC_S32:
-        printf("%d",getInt32(pData));
-        break;
-      case ECMC_EC_U64:
-        printf("%" PRIu64 "",getInt64(pData));
-        break;
-      case ECMC_EC_S64:
-        printf("%" PRId64 "",getInt64(pData));
-        break;
-      case ECMC_EC_F32:
-        printf("%f",getFloat32(pData));
-        break;
-      case ECMC_EC_F64:
-        printf("%lf",getFloat64(pData));
-        break;
-      default:
-        break;
+    if(contextItems_[i]->read(raw, bytes)) {
+      SCOPE_DBG_PRINT("ERROR: Failed read context item.\n");
+      throw std::runtime_error( "ERROR: Failed read context item." );
     }
-
-    pData += dataElementSize;
+    contextValues_[i] = getEcDataAsDouble(raw, contextItemInfos_[i]->dataType);
   }
-  printf("\n");
 }
 
-uint8_t   ecmcScope::getUint8(uint8_t* data) {
-  return *data;
-}
+/** Logic analyzer mode: all sources (separated by ',') are packed into one
+ *  64 bit word per sample. sourceDataItemInfo_ then describes the packed words.
+*/
+void ecmcScope::connectLogicSources() {
+  logic_ = new ecmcScopeLogic();
+
+  char *pSourceStrs = strdup(cfgDataSourceStr_);
+  char *pThisSource = pSourceStrs;
+  while (pThisSource && pThisSource[0]) {
+    char *pNextSource = strchr(pThisSource, ECMC_PLUGIN_SOURCE_SEPARATOR);
+    if (pNextSource) {
+      *pNextSource = '\0';
+      pNextSource++;
+    }
+    ecmcDataItem *item = findDataItem(pThisSource);
+    if(!item) {
+      free(pSourceStrs);
+      SCOPE_DBG_PRINT("ERROR: Logic source dataitem NULL.\n");
+      throw std::runtime_error( "ERROR: Logic source dataitem NULL." );
+    }
+    try {
+      logic_->addChannel(item);
+    }
+    catch(...) {
+      free(pSourceStrs);
+      throw;
+    }
+    if(!sourceDataItem_) {
+      sourceDataItem_ = item;
+    }
+    pThisSource = pNextSource;
+  }
+  free(pSourceStrs);
 
-int8_t    ecmcScope::getInt8(uint8_t* data) {
-  int8_t* p=(int8_t*)data;
-  return *p;
+  logic_->init();
+  sourceDataItemInfo_ = logic_->getPackedInfo();
 }
 
-uint16_t  ecmcScope::getUint16(uint8_t* data) {
-  uint16_t* p=(uint16_t*)data;
-  return *p;
+// Read source data of current cycle (packed words in logic analyzer mode)
+int ecmcScope::readSource(uint8_t *data, size_t bytes) {
+  if(replayData_) {
+    // Sub rate execution: recorded scan
+    memcpy(data, replayData_, bytes);
+    return 0;
+  }
+  if(logic_) {
+    memcpy(data, sourceDataItemInfo_->data, bytes);
+    return 0;
+  }
+  if(source_) {
+    memcpy(data, source_->getCurrent(), bytes);
+    return 0;
+  }
+  return sourceDataItem_->read(data, bytes);
 }
 
-int16_t   ecmcScope::getInt16(uint8_t* data) {
-  int16_t* p=(int16_t*)data;
-  return *p;
+/** Current scan data (read only, in place in process image if possible).
+ *  Otherwise it is read to the last scan buffer (then the last scan is not
+ *  needed, re-read at end of cycle).
+*/
+uint8_t *ecmcScope::currentScan() {
+  if(replayData_) {
+    return replayData_;
+  }
+  if(source_) {
+    return source_->getCurrent();
+  }
+  if(logic_ || (sourceDataItemInfo_->data && sourceDataItemInfo_->dataPointerValid)) {
+    return sourceDataItemInfo_->data;
+  }
+  if( readSource((uint8_t*)&lastScanSourceDataBuffer_[0],sourceDataItemInfo_->dataSize)){
+    SCOPE_DBG_PRINT("ERROR: Failed read data source..\n");
+    throw std::runtime_error( "ERROR: Failed source data." );
+  }
+  return lastScanSourceDataBuffer_;
 }
 
-uint32_t  ecmcScope::getUint32(uint8_t* data) {
-  uint32_t* p=(uint32_t*)data;
-  return *p;
+// Scan data of last processed scan
+uint8_t *ecmcScope::lastScan() {
+  if(historyLast_) {
+    return historyLast_;
+  }
+  if(sharedHistory_) {
+    return source_->getLast();
+  }
+  return lastScanSourceDataBuffer_;
 }
 
-int32_t   ecmcScope::getInt32(uint8_t* data) {
-  int32_t* p=(int32_t*)data;
-  return *p;
+/** Number of cycles between last scan buffer and current NEXT_TIME
+ *  (1 if no frames lost or repeated, -1 if unknown).
+*/
+int ecmcScope::cyclesSinceLastScan() {
+  if(!lastScanValid_) {
+    return -1;
+  }
+  int64_t diff = (int64_t)(timebase_->getNexttime() - lastScanNexttime_);
+  return (int)std::floor(diff / timebase_->getCycleNs() + 0.5);
 }
 
-uint64_t  ecmcScope::getUint64(uint8_t* data) {
-  uint64_t* p=(uint64_t*)data;
-  return *p;
-}
+/** Lost (cycles > 1) or repeated (cycles < 1) frames during capture.
+ *  Returns false if capture is aborted (GAP_POLICY=ABORT).
+*/
+bool ecmcScope::handleGap(int cycles) {
+  captureValid_ = 0;
+  captureGaps_ += cycles > 1 ? cycles - 1 : 1;
 
-int64_t   ecmcScope::getInt64(uint8_t* data) {
-  int64_t* p=(int64_t*)data;
-  return *p;
+  switch(cfgGapPolicy_) {
+    case ECMC_SCOPE_GAP_ABORT:
+      SCOPE_DBG_PRINT("WARNING: Capture aborted (lost or repeated frames).\n");
+      bytesInResultBuffer_ = 0;
+      scopeState_ = ECMC_SCOPE_STATE_WAIT_TRIGG;
+      return false;
+      break;
+    case ECMC_SCOPE_GAP_FILL:
+      if(cycles > 1) {
+        appendFill((cycles - 1) * sourceElementsPerSample_);
+      }
+      return true;
+      break;
+    default:
+      return true;
+      break;
+  }
+  return true;
 }
 
-float     ecmcScope::getFloat32(uint8_t* data) {
-  float* p=(float*)data;
-  return *p;
+// Append elements of fill value to result buffer (lost samples)
+void ecmcScope::appendFill(size_t elements) {
+  size_t elementSize = sourceDataItemInfo_->dataElementSize;
+  while(elements > 0 && bytesInResultBuffer_ + elementSize <= resultDataBufferBytes_) {
+    memcpy(&resultDataBuffer_[bytesInResultBuffer_], gapFillElement_, elementSize);
+    bytesInResultBuffer_ += elementSize;
+    elements--;
+  }
 }
 
-double    ecmcScope::getFloat64(uint8_t* data) {
+/** Push result (and compressed result if configured) over asyn.
+ *  The compressed output is encoded in the same cycle so both always
+ *  belong to the same trigger.
+*/
+void ecmcScope::publishResult() {
+  if(replayOut_) {
+    writeReplayFrame();
+    return;
+  }
+  if(chunkBuffer_) {
+    // Large capture mode: remaining chunks in this and the next cycles
+    chunkEndBytes_ = bytesInResultBuffer_;
+    chunkDrain_    = 1;
+    publishChunk();
+  }
+  else if(cfgStats_) {
+    calcStatistics();
+  }
+  asynCaptureValid_->refreshParam(1);
+  asynCaptureGaps_->refreshParam(1);
+
+  // Mask test (result published with capture)
+  bool maskFailed = false;
+  if(mask_) {
+    maskFailed = testMask();
+    publishMask();
+  }
+
+  if(logic_) {
+    // Logic analyzer mode: publish unpacked channels and transition list
+    logic_->unpack((uint64_t*)resultDataBuffer_, cfgBufferElementCount_, logicChannelBuffer_);
+    size_t transitions = logic_->transitions((uint64_t*)resultDataBuffer_,
+                                             cfgBufferElementCount_,
+                                             logicTransBuffer_);
+    asynLogicTrans_->refreshParam(1, (uint8_t*)logicTransBuffer_,
+                                  transitions * ECMC_SCOPE_LOGIC_TRANS_WORDS * sizeof(int32_t));
+  }
+  if(!chunkBuffer_) {
+    resultParam_->refreshParam(1);
+  }
+  samplePeriodNs_ = timebase_->getSamplePeriodNs();
+  asynSamplePeriod_->refreshParam(1);
+
+  // Structured capture (header and data in one update)
+  updateFrameHeader();
+  if(!chunkBuffer_) {
+    asynFrame_->refreshParam(1);
+  }
+  if(asynContext_) {
+    asynContext_->refreshParam(1);
+  }
+
+  if(cfgCompress_) {
+    bytesInCompressedBuffer_ = ecmcScopeCodecEncode(resultDataBuffer_,
+                                                    cfgBufferElementCount_,
+                                                    sourceDataItemInfo_->dataElementSize,
+                                                    isEcDataTypeSigned(sourceDataItemInfo_->dataType),
+                                                    cfgCompress_,
+                                                    compressedDataBuffer_,
+                                                    compressedDataBufferBytes_);
+    if(bytesInCompressedBuffer_ > 0) {
+      asynCompressed_->refreshParam(1, compressedDataBuffer_, bytesInCompressedBuffer_);
+    }
+  }
+
+  // Fold into equivalent time grid (only hardware triggered continuous captures)
+  if(ets_ && triggPhase_ >= 0 && captureValid_) {
+    ets_->add(resultDataBuffer_, triggPhase_);
+    if(ets_->getCount() >= cfgEtsCaptures_) {
+      ets_->reconstruct(etsDataBuffer_);
+      asynEts_->refreshParam(1);
+      ets_->reset();
+    }
+  }
+
+  // Hand over to windowed readout (worker thread)
+  if(view_) {
+    view_->add(resultDataBuffer_);
+  }
+
+  // Keep in flight recorder (unless frozen)
+  if(recorder_) {
+    recorder_->addCapture(captureBuffer_);
+    // Failing capture is newest capture of frozen recorder
+    if(maskFailed && cfgMaskFreeze_) {
+      applyFreeze(ECMC_SCOPE_RECORDER_FREEZE_MASK);
+    }
+  }
+
+  // Fold into persistence image (worker thread)
+  if(persist_ && !persist_->add(resultDataBuffer_)) {
+    SCOPE_DBG_PRINT("WARNING: Persistence worker busy. Capture not folded.\n");
+  }
+
+  bytesInResultBuffer_ = 0;
+  triggerCounter_++;
+  asynTriggerCounter_->refreshParam(1);
+
+
+  SCOPE_DBG_PRINT("INFO: Result Buffer full. Data push over asyn..\n");
+  if(cfgDbgMode_) {
+    printEcDataArray(resultDataBuffer_,resultDataBufferBytes_,sourceDataItemInfo_->dataType,objectId_);
+  }
+}
+
+/** Capture part of frame header (trigger part set at capture start)*/
+void ecmcScope::updateFrameHeader() {
+  frameHeader_->flags          = (frameHeader_->flags & ~ECMC_SCOPE_FRAME_VALID) |
+                                 (captureValid_ ? ECMC_SCOPE_FRAME_VALID : 0);
+  frameHeader_->gaps           = (uint32_t)captureGaps_;
+  frameHeader_->samplePeriodNs = samplePeriodNs_;
+  frameHeader_->triggerCounter = (uint32_t)(triggerCounter_ + 1);
+}
+
+/** Replay: structured capture appended to output file (no asyn per capture)*/
+void ecmcScope::writeReplayFrame() {
+  if(cfgStats_) {
+    calcStatistics();
+  }
+  if(mask_) {
+    testMask();
+  }
+  samplePeriodNs_ = timebase_->getSamplePeriodNs();
+  updateFrameHeader();
+  if(fwrite(captureBuffer_, 1, captureBufferBytes_, replayOut_) != captureBufferBytes_) {
+    SCOPE_DBG_PRINT("ERROR: Failed write replay output file.\n");
+    throw std::runtime_error( "ERROR: Failed write replay output file." );
+  }
+  bytesInResultBuffer_ = 0;
+  triggerCounter_++;
+}
+
+/** Count trigger outcome and add entry to trigger log (ring, rt only).
+ *  The log is published first in next cycle (at most once per cycle).
+*/
+void ecmcScope::logTrigg(int outcome) {
+  triggOutcomes_[outcome]++;
+
+  int64_t offset = timeDiff();
+  if(offset > INT32_MAX) {
+    offset = INT32_MAX;
+  }
+  else if(offset < INT32_MIN) {
+    offset = INT32_MIN;
+  }
+
+  int32_t *entry = &triggLog_[triggLogPos_ * ECMC_SCOPE_TRIGG_LOG_WORDS];
+  entry[0] = (int32_t)(uint32_t)triggTime_;
+  entry[1] = (int32_t)(uint32_t)(triggTime_ >> 32);
+  entry[2] = (int32_t)(uint32_t)sourceNexttime_;
+  entry[3] = (int32_t)(uint32_t)(sourceNexttime_ >> 32);
+  entry[4] = (int32_t)offset;
+  entry[5] = outcome;
+  triggLogPos_   = (triggLogPos_ + 1) % ECMC_SCOPE_TRIGG_LOG_ENTRIES;
+  triggLogDirty_ = 1;
+}
+
+/** Publish outcome counters and trigger log (oldest entry first)*/
+void ecmcScope::publishTriggLog() {
+  size_t wordsFirst = (ECMC_SCOPE_TRIGG_LOG_ENTRIES - triggLogPos_) * ECMC_SCOPE_TRIGG_LOG_WORDS;
+  memcpy(&triggLogPublish_[0],
+         &triggLog_[triggLogPos_ * ECMC_SCOPE_TRIGG_LOG_WORDS],
+         wordsFirst * sizeof(int32_t));
+  memcpy(&triggLogPublish_[wordsFirst],
+         &triggLog_[0],
+         triggLogPos_ * ECMC_SCOPE_TRIGG_LOG_WORDS * sizeof(int32_t));
+  asynTriggOutcomes_->refreshParam(1);
+  asynTriggLog_->refreshParam(1);
+  triggLogDirty_ = 0;
+}
+
+/** Roll mode: Append current scan to sliding window and publish
+ *  the window (oldest sample first) every cfgRollCycles_ cycle.
+*/
+void ecmcScope::executeRoll() {
+  triggPhase_ = -1;
+  uint8_t *pData = currentScan();
+  size_t bytes = sourceDataItemInfo_->dataSize;
+  if(bytes > resultDataBufferBytes_) {
+    pData += bytes - resultDataBufferBytes_;
+    bytes  = resultDataBufferBytes_;
+  }
+
+  size_t bytesFirst = resultDataBufferBytes_ - rollWritePos_;
+  if(bytesFirst > bytes) {
+    bytesFirst = bytes;
+  }
+  memcpy(&rollDataBuffer_[rollWritePos_], pData, bytesFirst);
+  memcpy(&rollDataBuffer_[0], pData + bytesFirst, bytes - bytesFirst);
+  lastScanNexttime_ = timebase_->getNexttime();
+  lastScanValid_    = 1;
+  rollWritePos_ = (rollWritePos_ + bytes) % resultDataBufferBytes_;
+
+  rollCycleCounter_++;
+  if(rollCycleCounter_ < cfgRollCycles_) {
+    return;
+  }
+  rollCycleCounter_ = 0;
+
+  // Unroll to result buffer
+  memcpy(&resultDataBuffer_[0], &rollDataBuffer_[rollWritePos_], resultDataBufferBytes_ - rollWritePos_);
+  memcpy(&resultDataBuffer_[resultDataBufferBytes_ - rollWritePos_], &rollDataBuffer_[0], rollWritePos_);
+  setFrameTrigg(0, 0, ECMC_SCOPE_FRAME_ROLL);
+  snapshotContext();
+  publishResult();
+}
+
+/** Start capture at startSamples_ samples before NEXT_TIME (0 < startSamples_ <= 2 * samples per scan).
+ *  The first sample is placed exactly (also within current scan).
+ *  Returns false if the start is in the last scan and that scan is not from previous cycle.
+*/
+bool ecmcScope::startCapture() {
+  size_t bytesToCp   = 0;
+  size_t elementSize = sourceDataItemInfo_->dataElementSize;
+
+  samplesSinceLastTrigg_ = (double)(int64_t)startSamples_;
+  double phase = startSamples_ - samplesSinceLastTrigg_;
+  if(!(captureFlags_ & ECMC_SCOPE_FRAME_SOFT_TRIGG)) {
+    // Time from start to first sample in capture (fraction of sample period)
+    triggPhase_ = phase;
+  }
+  bytesInResultBuffer_ = 0;
+
+  // Last scan buffer must be from previous cycle
+  int cycles = 1;
+  if(samplesSinceLastTrigg_ > sourceElementsPerSample_) {
+    cycles = cyclesSinceLastScan();
+    if(cycles != 1 && !handleGap(cycles)) {
+      SCOPE_DBG_PRINT("WARNING: Last scan data not from previous cycle. This trigger will be disregarded.\n");
+      logTrigg(ECMC_SCOPE_TRIGG_DROP_GAP);
+      scopeState_ = ECMC_SCOPE_STATE_WAIT_TRIGG;
+      return false;
+    }
+  }
+
+  // printf("samplesSinceLastTrigg_=%lf\n",samplesSinceLastTrigg_);
+  if(newTrigg_) {
+    logTrigg(ECMC_SCOPE_TRIGG_ACCEPTED);
+  }
+
+  setFrameTrigg(captureTriggTime_,
+                captureDelayNs_ + phase * timebase_->getSamplePeriodNs(),
+                captureFlags_);
+  chunkPublishedBytes_ = 0;
+  chunkEndBytes_       = 0;
+  chunkIndex_          = 0;
+  chunkCapture_        = (uint32_t)(triggerCounter_ + 1);
+  if(cfgStats_) {
+    statsReset();
+  }
+
+  SCOPE_DBG_PRINT("INFO: Capture started.\n");
+
+  // Copy from last scan buffer if needed (if start occured during last scan)
+  if(samplesSinceLastTrigg_ > sourceElementsPerSample_) {
+    bytesToCp = (samplesSinceLastTrigg_ - sourceElementsPerSample_) * elementSize;
+    if(resultDataBufferBytes_ < bytesToCp) {
+      bytesToCp = resultDataBufferBytes_;
+    }
+
+    // Last scan only covers two scans back (older start is filled)
+    if(samplesSinceLastTrigg_ <= sourceElementsPerSample_ * 2 &&
+       (cycles == 1 || cfgGapPolicy_ != ECMC_SCOPE_GAP_FILL)) {
+      size_t startByte = (sourceElementsPerSample_*2-samplesSinceLastTrigg_) * elementSize;
+      memcpy( &resultDataBuffer_[0], &lastScan()[startByte], bytesToCp);
+      bytesInResultBuffer_ = bytesToCp;
+    }
+    else {
+      // Last scan data not valid for this trigger
+      bytesInResultBuffer_ = 0;
+      appendFill(bytesToCp / elementSize);
+    }
+  }
+
+  // Copy from current scan if needed
+  if(bytesInResultBuffer_ < resultDataBufferBytes_) {
+    if(samplesSinceLastTrigg_ < sourceElementsPerSample_) {
+      // Start within current scan
+      size_t startByte = (sourceElementsPerSample_ - samplesSinceLastTrigg_) * elementSize;
+      uint8_t *pScan = currentScan();
+      bytesToCp = sourceDataItemInfo_->dataSize - startByte;
+      if(bytesToCp > (resultDataBufferBytes_ - bytesInResultBuffer_)) {
+        bytesToCp = resultDataBufferBytes_ - bytesInResultBuffer_;
+      }
+      memcpy(&resultDataBuffer_[bytesInResultBuffer_], &pScan[startByte], bytesToCp);
+    }
+    else {
+      bytesToCp = sourceDataItemInfo_->dataSize;
+      // Ensure not to much data is copied
+      if(bytesToCp > (resultDataBufferBytes_ - bytesInResultBuffer_)) {
+        bytesToCp = resultDataBufferBytes_ - bytesInResultBuffer_;
+      }
+
+      // Write directtly into results buffer
+      if( readSource((uint8_t*)&resultDataBuffer_[bytesInResultBuffer_],bytesToCp)){
+        SCOPE_DBG_PRINT("ERROR: Failed read data source.\n");
+        throw std::runtime_error( "ERROR: Failed read data source." );
+      }
+    }
+    bytesInResultBuffer_ += bytesToCp;
+  }
+
+  // If more data is needed the go to collect state.
+  if(bytesInResultBuffer_ < resultDataBufferBytes_) {
+    // Fill more data from next scan
+    scopeState_ = ECMC_SCOPE_STATE_COLLECT;
+    if(chunkBuffer_) {
+      chunkEndBytes_ = bytesInResultBuffer_;
+      publishChunk();
+    }
+  }
+  else {  // The data from current scan was enough. send over asyn and then start over (wait for next trigger)
+    publishResult();
+    scopeState_ = activeMode_ == ECMC_SCOPE_MODE_SINGLE ?
+                  ECMC_SCOPE_STATE_IDLE : ECMC_SCOPE_STATE_WAIT_TRIGG;
+  }
+  return true;
+}
+
+/** Trigger part of frame header (rest is filled at publish)*/
+void ecmcScope::setFrameTrigg(uint64_t triggTime, double firstSampleOffsetNs, uint32_t flags) {
+  frameHeader_->triggTime           = triggTime;
+  frameHeader_->firstSampleOffsetNs = firstSampleOffsetNs;
+  frameHeader_->flags               = flags;
+}
+
+/** Start over in new mode (also invalid mode written over asyn is handled here)*/
+void ecmcScope::applyMode() {
+  if(cfgMode_ < ECMC_SCOPE_MODE_NORMAL || cfgMode_ > ECMC_SCOPE_MODE_ROLL ||
+     (cfgMode_ == ECMC_SCOPE_MODE_ROLL && !rollDataBuffer_)) {
+    SCOPE_DBG_PRINT("WARNING: Invalid mode. Fallback to NORMAL.\n");
+    cfgMode_ = ECMC_SCOPE_MODE_NORMAL;
+    syncRequest(&modeReq_, &modeSeen_, cfgMode_, asynMode_);
+  }
+  activeMode_          = cfgMode_;
+  bytesInResultBuffer_ = 0;
+  autoCycleCounter_    = 0;
+  rollCycleCounter_    = 0;
+  rollWritePos_        = 0;
+  triggPhase_          = -1;
+  scopeState_          = ECMC_SCOPE_STATE_WAIT_TRIGG;
+}
+
+/** Min, max, mean and rms of the result buffer (for plc access)*/
+void ecmcScope::calcStatistics() {
+  statsReset();
+  statsAdd(resultDataBuffer_, cfgBufferElementCount_);
+  statsFinish();
+}
+
+void ecmcScope::statsReset() {
+  statsMin_    = std::numeric_limits<double>::max();
+  statsMax_    = -std::numeric_limits<double>::max();
+  statsSum_    = 0;
+  statsSumSqr_ = 0;
+}
+
+// Accumulate statistics (large capture mode: one chunk at a time)
+void ecmcScope::statsAdd(const uint8_t *data, size_t elements) {
+  ecmcEcDataType dt = sourceDataItemInfo_->dataType;
+  size_t elementSize = sourceDataItemInfo_->dataElementSize;
+
+  uint8_t *pData = (uint8_t*)data;
+  for(size_t i = 0; i < elements; ++i) {
+    double value = getEcDataAsDouble(pData, dt);
+    statsMin_     = value < statsMin_ ? value : statsMin_;
+    statsMax_     = value > statsMax_ ? value : statsMax_;
+    statsSum_    += value;
+    statsSumSqr_ += value * value;
+    pData        += elementSize;
+  }
+}
+
+void ecmcScope::statsFinish() {
+  resultStats_[ECMC_SCOPE_STAT_MIN]  = statsMin_;
+  resultStats_[ECMC_SCOPE_STAT_MAX]  = statsMax_;
+  resultStats_[ECMC_SCOPE_STAT_MEAN] = statsSum_ / cfgBufferElementCount_;
+  resultStats_[ECMC_SCOPE_STAT_RMS]  = std::sqrt(statsSumSqr_ / cfgBufferElementCount_);
+}
+
+/** Large capture mode: publish the next chunk of the current capture, at
+ *  most one per cycle (one asyn array, a second update in the same cycle
+ *  would replace the first before it is read). While collecting only full
+ *  chunks are published. When the capture is completed (chunkDrain_) the
+ *  remaining chunks, including the last partial one, are published in the
+ *  following cycles and new triggers are rejected (busy) until done.
+ *  Statistics are accumulated per chunk so the complete capture is never
+ *  processed in one cycle.
+*/
+void ecmcScope::publishChunk() {
+  size_t elementSize = sourceDataItemInfo_->dataElementSize;
+  size_t chunkBytes  = cfgChunkElements_ * elementSize;
+
+  if(chunkPublishedBytes_ >= chunkEndBytes_) {
+    chunkDrain_ = 0;  // Nothing left
+    return;
+  }
+  if(chunkThisCycle_) {
+    return;
+  }
+  size_t bytes = chunkEndBytes_ - chunkPublishedBytes_;
+  if(bytes > chunkBytes) {
+    bytes = chunkBytes;
+  }
+  if(bytes < chunkBytes && !chunkDrain_) {
+    return;
+  }
+  bool lastChunk = chunkDrain_ && chunkPublishedBytes_ + bytes >= chunkEndBytes_;
+  const uint8_t *pData = &resultDataBuffer_[chunkPublishedBytes_];
+  if(cfgStats_) {
+    statsAdd(pData, bytes / elementSize);
+  }
+
+  chunkHeader_->flags          = (chunkIndex_ == 0 ? ECMC_SCOPE_CHUNK_FIRST : 0) |
+                                 (lastChunk ? ECMC_SCOPE_CHUNK_LAST : 0) |
+                                 (lastChunk && captureValid_ ? ECMC_SCOPE_CHUNK_VALID : 0);
+  chunkHeader_->sequence       = chunkSequence_++;
+  chunkHeader_->triggerCounter = chunkCapture_;
+  chunkHeader_->chunkIndex     = chunkIndex_++;
+  chunkHeader_->firstElement   = chunkPublishedBytes_ / elementSize;
+  chunkHeader_->elements       = (uint32_t)(bytes / elementSize);
+  chunkHeader_->triggTime      = frameHeader_->triggTime;
+  memcpy(chunkBuffer_ + sizeof(ecmcScopeChunkHeader), pData, bytes);
+  asynChunk_->refreshParam(1, chunkBuffer_, sizeof(ecmcScopeChunkHeader) + bytes);
+  chunkPublishedBytes_ += bytes;
+  chunkThisCycle_       = 1;
+
+  if(lastChunk) {
+    chunkDrain_ = 0;
+    if(cfgStats_) {
+      statsFinish();
+    }
+  }
+}
+
+/** Time from trigger to NEXT_TIME on the unwrapped source timeline.
+ *  If trigger or nexttime is 32 bit then the trigger must be within
+ *  +-2^31 ns (approx 2s) of NEXT_TIME.
+ *  sourceDataNexttimeItemInfo_ is always considered to happen in the future (after trigg)
+*/
+int64_t ecmcScope::timeDiff() {
+  // retrun time from trigg to next
+  return (int64_t)(timebase_->getNexttime() - timebase_->unwrap(triggTime_));
+}
+
+void ecmcScope::printEcDataArray(uint8_t*       data, 
+                                 size_t         size,
+                                 ecmcEcDataType dt,
+                                 int objId) {
+  printf("INFO: Scope id: %d, data: ",objId);
+
+  size_t dataElementSize = getEcDataTypeByteSize(dt);
+
+  uint8_t *pData = data;
+  for(unsigned int i = 0; i < size / dataElementSize; ++i) {    
+    if(i % 10 == 0) {
+      printf("\n");
+    } else {
+      printf(", ");
+    }
+    switch(dt) {
+      case ECMC_EC_U8:        
+        printf("%hhu",getUint8(pData));
+        break;
+      case ECMC_EC_S8:
+        printf("%hhd",getInt8(pData));
+        break;
+      case ECMC_EC_U16:
+        printf("%hu",getUint16(pData));
+        break;
+      case ECMC_EC_S16:
+        printf("%hd",getInt16(pData));
+        break;
+      case ECMC_EC_U32:
+        printf("%u",getUint32(pData));
+        break;
+      case ECMC_EC_S32:
+        printf("%d",getInt32(pData));
+        break;
+      case ECMC_EC_U64:
+        printf("%" PRIu64 "",getInt64(pData));
+        break;
+      case ECMC_EC_S64:
+        printf("%" PRId64 "",getInt64(pData));
+        break;
+      case ECMC_EC_F32:
+        printf("%f",getFloat32(pData));
+        break;
+      case ECMC_EC_F64:
+        printf("%lf",getFloat64(pData));
+        break;
+      default:
+        break;
+    }
+
+    pData += dataElementSize;
+  }
+  printf("\n");
+}
+
+uint8_t   ecmcScope::getUint8(uint8_t* data) {
+  return *data;
+}
+
+int8_t    ecmcScope::getInt8(uint8_t* data) {
+  int8_t* p=(int8_t*)data;
+  return *p;
+}
+
+uint16_t  ecmcScope::getUint16(uint8_t* data) {
+  uint16_t* p=(uint16_t*)data;
+  return *p;
+}
+
+int16_t   ecmcScope::getInt16(uint8_t* data) {
+  int16_t* p=(int16_t*)data;
+  return *p;
+}
+
+uint32_t  ecmcScope::getUint32(uint8_t* data) {
+  uint32_t* p=(uint32_t*)data;
+  return *p;
+}
+
+int32_t   ecmcScope::getInt32(uint8_t* data) {
+  int32_t* p=(int32_t*)data;
+  return *p;
+}
+
+uint64_t  ecmcScope::getUint64(uint8_t* data) {
+  uint64_t* p=(uint64_t*)data;
+  return *p;
+}
+
+int64_t   ecmcScope::getInt64(uint8_t* data) {
+  int64_t* p=(int64_t*)data;
+  return *p;
+}
+
+float     ecmcScope::getFloat32(uint8_t* data) {
+  float* p=(float*)data;
+  return *p;
+}
+
+double    ecmcScope::getFloat64(uint8_t* data) {
   double* p=(double*)data;
   return *p;
 }
 
-size_t ecmcScope::getEcDataTypeByteSize(ecmcEcDataType dt){
-  switch(dt) {
-  case ECMC_EC_NONE:
-    return 0;
-    break;
+double ecmcScope::getEcDataAsDouble(uint8_t* data, ecmcEcDataType dt) {
+  switch(dt) {
+    case ECMC_EC_U8:
+      return (double)getUint8(data);
+      break;
+    case ECMC_EC_S8:
+      return (double)getInt8(data);
+      break;
+    case ECMC_EC_U16:
+      return (double)getUint16(data);
+      break;
+    case ECMC_EC_S16:
+      return (double)getInt16(data);
+      break;
+    case ECMC_EC_U32:
+      return (double)getUint32(data);
+      break;
+    case ECMC_EC_S32:
+      return (double)getInt32(data);
+      break;
+    case ECMC_EC_U64:
+      return (double)getUint64(data);
+      break;
+    case ECMC_EC_S64:
+      return (double)getInt64(data);
+      break;
+    case ECMC_EC_F32:
+      return (double)getFloat32(data);
+      break;
+    case ECMC_EC_F64:
+      return getFloat64(data);
+      break;
+    default:
+      return 0;
+      break;
+  }
+  return 0;
+}
+
+void ecmcScope::setEcDataFromDouble(uint8_t* data, ecmcEcDataType dt, double value) {
+  switch(dt) {
+    case ECMC_EC_U8:
+      *data = (uint8_t)value;
+      break;
+    case ECMC_EC_S8:
+      *(int8_t*)data = (int8_t)value;
+      break;
+    case ECMC_EC_U16:
+      *(uint16_t*)data = (uint16_t)value;
+      break;
+    case ECMC_EC_S16:
+      *(int16_t*)data = (int16_t)value;
+      break;
+    case ECMC_EC_U32:
+      *(uint32_t*)data = (uint32_t)value;
+      break;
+    case ECMC_EC_S32:
+      *(int32_t*)data = (int32_t)value;
+      break;
+    case ECMC_EC_U64:
+      *(uint64_t*)data = (uint64_t)value;
+      break;
+    case ECMC_EC_S64:
+      *(int64_t*)data = (int64_t)value;
+      break;
+    case ECMC_EC_F32:
+      *(float*)data = (float)value;
+      break;
+    case ECMC_EC_F64:
+      *(double*)data = value;
+      break;
+    default:
+      break;
+  }
+}
+
+size_t ecmcScope::getEcDataTypeByteSize(ecmcEcDataType dt){
+  switch(dt) {
+  case ECMC_EC_NONE:
+    return 0;
+    break;
+
+  case ECMC_EC_B1:
+    return 1;
+    break;
+
+  case ECMC_EC_B2:
+    return 1;
+    break;
+
+  case ECMC_EC_B3:
+    return 1;
+    break;
+
+  case ECMC_EC_B4:
+    return 1;
+    break;
+
+  case ECMC_EC_U8:
+    return 1;
+    break;
+
+  case ECMC_EC_S8:
+    return 1;
+    break;
+
+  case ECMC_EC_U16:
+    return 2;
+    break;
+
+  case ECMC_EC_S16:
+    return 2;
+    break;
+
+  case ECMC_EC_U32:
+    return 4;
+    break;
+
+  case ECMC_EC_S32:
+    return 4;
+    break;
+
+  case ECMC_EC_U64:
+    return 8;
+    break;
+
+  case ECMC_EC_S64:
+    return 8;
+    break;
+
+  case ECMC_EC_F32:
+    return 4;
+    break;
+
+  case ECMC_EC_F64:
+    return 8;
+    break;
+
+  default:
+    return 0;
+    break;
+  }
+
+  return 0;
+}
+
+int ecmcScope::isEcDataTypeBit(ecmcEcDataType dt){
+  switch(dt) {
+  case ECMC_EC_B1:
+  case ECMC_EC_B2:
+  case ECMC_EC_B3:
+  case ECMC_EC_B4:
+    return 1;
+    break;
+
+  default:
+    return 0;
+    break;
+  }
+
+  return 0;
+}
+
+int ecmcScope::isEcDataTypeSigned(ecmcEcDataType dt){
+  switch(dt) {
+  case ECMC_EC_S8:
+  case ECMC_EC_S16:
+  case ECMC_EC_S32:
+  case ECMC_EC_S64:
+  case ECMC_EC_F32:   // bit pattern handled as signed integer by codec
+  case ECMC_EC_F64:
+    return 1;
+    break;
+
+  default:
+    return 0;
+    break;
+  }
+
+  return 0;
+}
+
+// Params are only registered here. Callbacks are done once for all scopes
+// at the end of linkDataToScopes().
+void ecmcScope::initAsyn() {
+
+   ecmcAsynPortDriver *ecmcAsynPort = (ecmcAsynPortDriver *)getEcmcAsynPortDriver();
+   if(!ecmcAsynPort) {
+     SCOPE_DBG_PRINT("ERROR: ecmcAsynPort NULL.");
+     throw std::runtime_error( "ERROR: ecmcAsynPort NULL." );
+   }
+
+  // Add resultdata "plugin.scope%d.resultdata" (unpacked channels in logic analyzer mode)
+  std::string paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_RESULTDATA;
+  asynParamType asynType = logic_ ? asynParamInt8Array :
+                           getResultAsynDTFromEcDT(sourceDataItemInfo_->dataType);
+
+  if(asynType == asynParamNotDefined) {
+    SCOPE_DBG_PRINT("ERROR: ecmc data type not supported for param.");
+    throw std::runtime_error( "ERROR: ecmc data type not supported for param: " + paramName);
+  }
+
+  resultParam_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynType,              // asyn type 
+                                          logic_ ? logicChannelBuffer_ : resultDataBuffer_,  // pointer to data
+                                          logic_ ? logicChannelBufferBytes_ : resultDataBufferBytes_, // size of data
+                                          logic_ ? ECMC_EC_U8 : sourceDataItemInfo_->dataType, // ecmc data type
+                                          0);                    // die if fail
+
+  if(!resultParam_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for result.");
+    throw std::runtime_error( "ERROR: Failed create asyn param for result: " + paramName);
+  }
+
+  resultParam_->setAllowWriteToEcmc(false);  // read only
+  resultParam_->refreshParam(1); // read once into asyn param lib
+
+  // Add enable "plugin.scope%d.enable"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_ENABLE;
+
+  enbaleParam_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynParamInt32,        // asyn type 
+                                          (uint8_t*)&enableReq_, // pointer to data (request cell)
+                                          sizeof(enableReq_),    // size of data
+                                          ECMC_EC_S32,           // ecmc data type
+                                          0);                    // die if fail
+
+  if(!enbaleParam_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for enable.");
+    throw std::runtime_error( "ERROR: Failed create asyn param for enable: " + paramName);
+  }
+
+  enbaleParam_->setAllowWriteToEcmc(true);
+  enbaleParam_->refreshParam(1); // read once into asyn param lib
+
+  // Add mode "plugin.scope%d.mode"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_MODE;
+
+  asynMode_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynParamInt32,        // asyn type 
+                                          (uint8_t*)&modeReq_,   // pointer to data (request cell)
+                                          sizeof(modeReq_),      // size of data
+                                          ECMC_EC_S32,           // ecmc data type
+                                          0);                    // die if fail
+
+  if(!asynMode_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for mode.");
+    throw std::runtime_error( "ERROR: Failed create asyn param for mode: " + paramName);
+  }
+
+  asynMode_->setAllowWriteToEcmc(true);
+  asynMode_->refreshParam(1); // read once into asyn param lib
+
+  // Add arm "plugin.scope%d.arm"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_ARM;
+
+  asynArm_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynParamInt32,        // asyn type 
+                                          (uint8_t*)&armReq_,    // pointer to data (request cell)
+                                          sizeof(armReq_),       // size of data
+                                          ECMC_EC_S32,           // ecmc data type
+                                          0);                    // die if fail
+
+  if(!asynArm_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for arm.");
+    throw std::runtime_error( "ERROR: Failed create asyn param for arm: " + paramName);
+  }
+
+  asynArm_->setAllowWriteToEcmc(true);
+  asynArm_->refreshParam(1); // read once into asyn param lib
+
+  // Add missed triggers "plugin.scope%d.missed"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_MISSED;
+
+  asynMissedTriggs_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynParamInt32,        // asyn type 
+                                          (uint8_t*)&missedTriggs_, // pointer to data
+                                          sizeof(missedTriggs_),    // size of data
+                                          ECMC_EC_S32,           // ecmc data type
+                                          0);                    // die if fail
+
+  if(!asynMissedTriggs_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for missed trigg counter.");   
+    throw std::runtime_error( "ERROR: Failed create asyn param for missed trigg counter: " + paramName);
+  }
+
+  asynMissedTriggs_->setAllowWriteToEcmc(false);
+  asynMissedTriggs_->refreshParam(1); // read once into asyn param lib
+
+  // Add trigger counter "plugin.scope%d.count"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_TRIGG_COUNT;
+
+  asynTriggerCounter_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynParamInt32,        // asyn type 
+                                          (uint8_t*)&triggerCounter_, // pointer to data
+                                          sizeof(triggerCounter_),    // size of data
+                                          ECMC_EC_S32,           // ecmc data type
+                                          0);                    // die if fail
+
+  if(!asynTriggerCounter_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for trigg counter.");   
+    throw std::runtime_error( "ERROR: Failed create asyn param for trigg counter: " + paramName);
+  }
+
+  asynTriggerCounter_->setAllowWriteToEcmc(false);
+  asynTriggerCounter_->refreshParam(1); // read once into asyn param lib
+
+  // Add trigger counter "plugin.scope%d.scantotrigg"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_SCAN_TO_TRIGG_OFFSET;
 
-  case ECMC_EC_B1:
-    return 1;
-    break;
+  asynTimeTrigg2Sample_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynParamFloat64,      // asyn type 
+                                          (uint8_t*)&samplesSinceLastTrigg_, // pointer to data
+                                          sizeof(samplesSinceLastTrigg_),    // size of data
+                                          ECMC_EC_S64,           // ecmc data type
+                                          0);                    // die if fail
 
-  case ECMC_EC_B2:
-    return 1;
-    break;
+  if(!asynTimeTrigg2Sample_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for time trigg to sample.");   
+    throw std::runtime_error( "ERROR: Failed create asyn param for time trigg to sample: " + paramName);
+  }
 
-  case ECMC_EC_B3:
-    return 1;
-    break;
+  asynTimeTrigg2Sample_->addSupportedAsynType(asynParamFloat64);
+  asynTimeTrigg2Sample_->setAllowWriteToEcmc(false);
+  asynTimeTrigg2Sample_->refreshParam(1); // read once into asyn param lib
 
-  case ECMC_EC_B4:
-    return 1;
-    break;
+  // Add tracked sample period "plugin.scope%d.sampleperiod" (ns)
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_SAMPLE_PERIOD;
 
-  case ECMC_EC_U8:
-    return 1;
-    break;
+  asynSamplePeriod_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynParamFloat64,      // asyn type 
+                                          (uint8_t*)&samplePeriodNs_, // pointer to data
+                                          sizeof(samplePeriodNs_),    // size of data
+                                          ECMC_EC_F64,           // ecmc data type
+                                          0);                    // die if fail
 
-  case ECMC_EC_S8:
-    return 1;
-    break;
+  if(!asynSamplePeriod_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for sample period.");   
+    throw std::runtime_error( "ERROR: Failed create asyn param for sample period: " + paramName);
+  }
 
-  case ECMC_EC_U16:
-    return 2;
-    break;
+  asynSamplePeriod_->setAllowWriteToEcmc(false);
+  asynSamplePeriod_->refreshParam(1); // read once into asyn param lib
 
-  case ECMC_EC_S16:
-    return 2;
-    break;
+  // Add capture valid "plugin.scope%d.valid" (no lost or repeated frames in last capture)
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_CAPTURE_VALID;
 
-  case ECMC_EC_U32:
-    return 4;
-    break;
+  asynCaptureValid_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynParamInt32,        // asyn type 
+                                          (uint8_t*)&captureValid_, // pointer to data
+                                          sizeof(captureValid_),    // size of data
+                                          ECMC_EC_S32,           // ecmc data type
+                                          0);                    // die if fail
 
-  case ECMC_EC_S32:
-    return 4;
-    break;
+  if(!asynCaptureValid_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for capture valid.");   
+    throw std::runtime_error( "ERROR: Failed create asyn param for capture valid: " + paramName);
+  }
 
-  case ECMC_EC_U64:
-    return 8;
-    break;
+  asynCaptureValid_->setAllowWriteToEcmc(false);
+  asynCaptureValid_->refreshParam(1); // read once into asyn param lib
 
-  case ECMC_EC_S64:
-    return 8;
-    break;
+  // Add capture gaps "plugin.scope%d.gaps" (lost or repeated frames in last capture)
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_CAPTURE_GAPS;
 
-  case ECMC_EC_F32:
-    return 4;
-    break;
+  asynCaptureGaps_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynParamInt32,        // asyn type 
+                                          (uint8_t*)&captureGaps_, // pointer to data
+                                          sizeof(captureGaps_),    // size of data
+                                          ECMC_EC_S32,           // ecmc data type
+                                          0);                    // die if fail
 
-  case ECMC_EC_F64:
-    return 8;
-    break;
+  if(!asynCaptureGaps_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for capture gaps.");   
+    throw std::runtime_error( "ERROR: Failed create asyn param for capture gaps: " + paramName);
+  }
 
-  default:
-    return 0;
-    break;
+  asynCaptureGaps_->setAllowWriteToEcmc(false);
+  asynCaptureGaps_->refreshParam(1); // read once into asyn param lib
+
+  // Add enable "plugin.scope%d.source"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_SCOPE_SOURCE;
+
+  sourceStrParam_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynParamInt8Array,    // asyn type 
+                                          (uint8_t*)cfgDataSourceStr_,// pointer to data
+                                          strlen(cfgDataSourceStr_),  // size of data
+                                          ECMC_EC_U8,            // ecmc data type
+                                          0);                    // die if fail
+
+  if(!sourceStrParam_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for data source.");   
+    throw std::runtime_error( "ERROR: Failed create asyn param for data source: " + paramName);
   }
 
-  return 0;
-}
+  sourceStrParam_->setAllowWriteToEcmc(false);  // read only
+  sourceStrParam_->refreshParam(1); // read once into asyn param lib
 
-void ecmcScope::initAsyn() {
+  // Add enable "plugin.scope%d.trigg"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_SCOPE_TRIGG;
 
-   ecmcAsynPortDriver *ecmcAsynPort = (ecmcAsynPortDriver *)getEcmcAsynPortDriver();
-   if(!ecmcAsynPort) {
-     SCOPE_DBG_PRINT("ERROR: ecmcAsynPort NULL.");
-     throw std::runtime_error( "ERROR: ecmcAsynPort NULL." );
-   }
+  triggStrParam_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynParamInt8Array,    // asyn type 
+                                          (uint8_t*)cfgTriggStr_,// pointer to data
+                                          strlen(cfgTriggStr_),  // size of data
+                                          ECMC_EC_U8,            // ecmc data type
+                                          0);                    // die if fail
 
-  // Add resultdata "plugin.scope%d.resultdata"
-  std::string paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
-                          "." + ECMC_PLUGIN_ASYN_RESULTDATA;
-  asynParamType asynType = getResultAsynDTFromEcDT(sourceDataItemInfo_->dataType);
+  if(!triggStrParam_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for trigger.");       
+    throw std::runtime_error( "ERROR: Failed create asyn param for trigger: " + paramName);
+  }
 
-  if(asynType == asynParamNotDefined) {
-    SCOPE_DBG_PRINT("ERROR: ecmc data type not supported for param.");
-    throw std::runtime_error( "ERROR: ecmc data type not supported for param: " + paramName);
+  triggStrParam_->setAllowWriteToEcmc(false);  // read only
+  triggStrParam_->refreshParam(1); // read once into asyn param lib
+
+  // Add enable "plugin.scope%d.nexttime"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_SCOPE_NEXT_SYNC;
+
+  sourceNexttimeStrParam_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynParamInt8Array,    // asyn type 
+                                          (uint8_t*)cfgDataNexttimeStr_,// pointer to data
+                                          strlen(cfgDataNexttimeStr_),  // size of data
+                                          ECMC_EC_U8,            // ecmc data type
+                                          0);                    // die if fail
+
+  if(!sourceNexttimeStrParam_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for nexttime.");       
+    throw std::runtime_error( "ERROR: Failed create asyn param for nexttime: " + paramName);
   }
 
-  resultParam_ = ecmcAsynPort->addNewAvailParam(
+  sourceNexttimeStrParam_->setAllowWriteToEcmc(false);  // read only
+  sourceNexttimeStrParam_->refreshParam(1); // read once into asyn param lib
+
+  // Add trigger outcome counters "plugin.scope%d.outcomes" (index = ECMC_SCOPE_TRIGG_*)
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_TRIGG_OUTCOMES;
+
+  asynTriggOutcomes_ = ecmcAsynPort->addNewAvailParam(
                                           paramName.c_str(),     // name
-                                          asynType,              // asyn type 
-                                          resultDataBuffer_,     // pointer to data
-                                          resultDataBufferBytes_,// size of data
-                                          sourceDataItemInfo_->dataType, // ecmc data type
+                                          asynParamInt32Array,   // asyn type 
+                                          (uint8_t*)triggOutcomes_, // pointer to data
+                                          sizeof(triggOutcomes_),   // size of data
+                                          ECMC_EC_S32,           // ecmc data type
+                                          0);                    // die if fail
+
+  if(!asynTriggOutcomes_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for trigger outcomes.");
+    throw std::runtime_error( "ERROR: Failed create asyn param for trigger outcomes: " + paramName);
+  }
+
+  asynTriggOutcomes_->setAllowWriteToEcmc(false);  // read only
+  asynTriggOutcomes_->refreshParam(1); // read once into asyn param lib
+
+  // Add trigger log "plugin.scope%d.trigglog"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                          "." + ECMC_PLUGIN_ASYN_TRIGG_LOG;
+
+  asynTriggLog_ = ecmcAsynPort->addNewAvailParam(
+                                          paramName.c_str(),     // name
+                                          asynParamInt32Array,   // asyn type 
+                                          (uint8_t*)triggLogPublish_, // pointer to data
+                                          sizeof(triggLogPublish_),   // size of data
+                                          ECMC_EC_S32,           // ecmc data type
                                           0);                    // die if fail
 
-  if(!resultParam_) {
-    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for result.");
-    throw std::runtime_error( "ERROR: Failed create asyn param for result: " + paramName);
-  }
+  if(!asynTriggLog_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for trigger log.");
+    throw std::runtime_error( "ERROR: Failed create asyn param for trigger log: " + paramName);
+  }
+
+  asynTriggLog_->setAllowWriteToEcmc(false);  // read only
+  asynTriggLog_->refreshParam(1); // read once into asyn param lib
+
+  // Add transition list "plugin.scope%d.resulttransitions" (logic analyzer mode)
+  if(logic_) {
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_RESULT_TRANSITIONS;
+
+    asynLogicTrans_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32Array,   // asyn type 
+                                            (uint8_t*)logicTransBuffer_, // pointer to data
+                                            logicTransBufferBytes_,// size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynLogicTrans_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for transitions.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for transitions: " + paramName);
+    }
+
+    asynLogicTrans_->setAllowWriteToEcmc(false);  // read only
+    asynLogicTrans_->refreshParam(1); // read once into asyn param lib
+  }
+
+  // Add equivalent time sampling result "plugin.scope%d.resultets"
+  if(cfgEtsFactor_) {
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_RESULT_ETS;
+
+    asynEts_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamFloat64Array, // asyn type 
+                                            (uint8_t*)etsDataBuffer_, // pointer to data
+                                            etsDataBufferBytes_,   // size of data
+                                            ECMC_EC_F64,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynEts_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for ets result.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for ets result: " + paramName);
+    }
+
+    asynEts_->setAllowWriteToEcmc(false);  // read only
+    asynEts_->refreshParam(1); // read once into asyn param lib
+  }
+
+  // Add persistence image "plugin.scope%d.resultpersist"
+  if(persist_) {
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_RESULT_PERSIST;
+
+    asynPersist_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamFloat64Array, // asyn type 
+                                            (uint8_t*)persist_->getImage(), // pointer to data
+                                            persist_->getImageBytes(),      // size of data
+                                            ECMC_EC_F64,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynPersist_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for persistence image.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for persistence image: " + paramName);
+    }
+
+    asynPersist_->setAllowWriteToEcmc(false);  // read only
+    asynPersist_->refreshParam(1); // read once into asyn param lib
+  }
+
+  // Flight recorder
+  if(recorder_) {
+    // Add recorder frozen "plugin.scope%d.recorderfrozen"
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_RECORDER_FROZEN;
+
+    asynRecorderFrozen_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32, // asyn type 
+                                            (uint8_t*)&recorderFrozen_, // pointer to data
+                                            sizeof(recorderFrozen_), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynRecorderFrozen_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for recorder frozen.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for recorder frozen: " + paramName);
+    }
+
+    asynRecorderFrozen_->setAllowWriteToEcmc(false);  // read only
+    asynRecorderFrozen_->refreshParam(1); // read once into asyn param lib
+
+    // Add recorder freeze error "plugin.scope%d.recordererror"
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_RECORDER_ERROR;
+
+    asynRecorderError_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32, // asyn type 
+                                            (uint8_t*)&recorderError_, // pointer to data
+                                            sizeof(recorderError_), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynRecorderError_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for recorder error.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for recorder error: " + paramName);
+    }
+
+    asynRecorderError_->setAllowWriteToEcmc(false);  // read only
+    asynRecorderError_->refreshParam(1); // read once into asyn param lib
+
+    // Add recorder capture count "plugin.scope%d.recordercount"
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_RECORDER_COUNT;
+
+    asynRecorderCount_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32, // asyn type 
+                                            (uint8_t*)&recorderCount_, // pointer to data
+                                            sizeof(recorderCount_), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynRecorderCount_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for recorder count.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for recorder count: " + paramName);
+    }
+
+    asynRecorderCount_->setAllowWriteToEcmc(false);  // read only
+    asynRecorderCount_->refreshParam(1); // read once into asyn param lib
+
+    // Add recorder freeze "plugin.scope%d.recorderfreeze"
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_RECORDER_FREEZE;
+
+    asynRecorderFreeze_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32, // asyn type 
+                                            (uint8_t*)&recorderFreezeReq_, // pointer to data
+                                            sizeof(recorderFreezeReq_), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynRecorderFreeze_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for recorder freeze.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for recorder freeze: " + paramName);
+    }
+
+    asynRecorderFreeze_->setAllowWriteToEcmc(true);
+    asynRecorderFreeze_->refreshParam(1); // read once into asyn param lib
+
+    // Add recorder readout index "plugin.scope%d.recorderindex"
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_RECORDER_INDEX;
+
+    asynRecorderIndex_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32, // asyn type 
+                                            (uint8_t*)&recorderIndexReq_, // pointer to data
+                                            sizeof(recorderIndexReq_), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynRecorderIndex_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for recorder index.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for recorder index: " + paramName);
+    }
+
+    asynRecorderIndex_->setAllowWriteToEcmc(true);
+    asynRecorderIndex_->refreshParam(1); // read once into asyn param lib
+
+    // Add recorder capture "plugin.scope%d.recorderframe"
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_RECORDER_FRAME;
+
+    asynRecorderFrame_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt8Array, // asyn type 
+                                            recorder_->getCaptureOut(), // pointer to data
+                                            captureBufferBytes_, // size of data
+                                            ECMC_EC_U8,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynRecorderFrame_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for recorder frame.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for recorder frame: " + paramName);
+    }
+
+    asynRecorderFrame_->setAllowWriteToEcmc(false);  // read only
+    asynRecorderFrame_->refreshParam(1); // read once into asyn param lib
+
+    if(cfgRecorderHistoryCycles_) {
+      // Add recorder history "plugin.scope%d.recorderhistory"
+      paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                              "." + ECMC_PLUGIN_ASYN_RECORDER_HISTORY;
+
+      asynRecorderHistory_ = ecmcAsynPort->addNewAvailParam(
+                                              paramName.c_str(),     // name
+                                              asynParamInt8Array, // asyn type 
+                                              recorder_->getHistoryOut(), // pointer to data
+                                              recorder_->getHistoryBytes(), // size of data
+                                              ECMC_EC_U8,           // ecmc data type
+                                              0);                    // die if fail
+
+      if(!asynRecorderHistory_) {
+        SCOPE_DBG_PRINT("ERROR: Failed create asyn param for recorder history.");
+        throw std::runtime_error( "ERROR: Failed create asyn param for recorder history: " + paramName);
+      }
+
+      asynRecorderHistory_->setAllowWriteToEcmc(false);  // read only
+      asynRecorderHistory_->refreshParam(1); // read once into asyn param lib
+    }
+  }
+
+  // Windowed readout (request cells owned by view, polled by its worker)
+  if(view_) {
+    // Add view start element "plugin.scope%d.viewstart"
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_VIEW_START;
+
+    asynViewStart_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32, // asyn type 
+                                            (uint8_t*)view_->getStartReq(), // pointer to data
+                                            sizeof(int32_t), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynViewStart_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for view start.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for view start: " + paramName);
+    }
+
+    asynViewStart_->setAllowWriteToEcmc(true);
+    asynViewStart_->refreshParam(1); // read once into asyn param lib
+
+    // Add view length (elements) "plugin.scope%d.viewlength"
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_VIEW_LENGTH;
+
+    asynViewLength_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32, // asyn type 
+                                            (uint8_t*)view_->getLengthReq(), // pointer to data
+                                            sizeof(int32_t), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynViewLength_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for view length.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for view length: " + paramName);
+    }
+
+    asynViewLength_->setAllowWriteToEcmc(true);
+    asynViewLength_->refreshParam(1); // read once into asyn param lib
+
+    // Add view output points "plugin.scope%d.viewpoints"
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_VIEW_POINTS;
+
+    asynViewPoints_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32, // asyn type 
+                                            (uint8_t*)view_->getPointsReq(), // pointer to data
+                                            sizeof(int32_t), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynViewPoints_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for view points.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for view points: " + paramName);
+    }
+
+    asynViewPoints_->setAllowWriteToEcmc(true);
+    asynViewPoints_->refreshParam(1); // read once into asyn param lib
+
+    // Add view mode (0=decimate, 1=min/max) "plugin.scope%d.viewmode"
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_VIEW_MODE;
+
+    asynViewMode_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32, // asyn type 
+                                            (uint8_t*)view_->getModeReq(), // pointer to data
+                                            sizeof(int32_t), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynViewMode_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for view mode.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for view mode: " + paramName);
+    }
+
+    asynViewMode_->setAllowWriteToEcmc(true);
+    asynViewMode_->refreshParam(1); // read once into asyn param lib
+
+    // Add view "plugin.scope%d.resultview"
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_RESULT_VIEW;
+
+    asynView_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamFloat64Array, // asyn type 
+                                            (uint8_t*)view_->getView(), // pointer to data
+                                            view_->getViewMaxBytes(), // size of data
+                                            ECMC_EC_F64,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynView_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for view.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for view: " + paramName);
+    }
+
+    asynView_->setAllowWriteToEcmc(false);  // read only
+    asynView_->refreshParam(1); // read once into asyn param lib
+  }
+
+  // Add chunk "plugin.scope%d.chunk" (large capture mode, chunk header + data)
+  if(chunkBuffer_) {
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_CHUNK;
+
+    asynChunk_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt8Array,    // asyn type 
+                                            chunkBuffer_,          // pointer to data
+                                            chunkBufferBytes_,     // size of data
+                                            ECMC_EC_U8,            // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynChunk_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for chunk.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for chunk: " + paramName);
+    }
+
+    asynChunk_->setAllowWriteToEcmc(false);  // read only
+    asynChunk_->refreshParam(1); // read once into asyn param lib
+  }
+
+  // Add context "plugin.scope%d.context" (snapshot at trigger)
+  if(contextCount_) {
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_CONTEXT;
+
+    asynContext_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamFloat64Array, // asyn type 
+                                            (uint8_t*)contextValues_, // pointer to data
+                                            contextCount_ * sizeof(double), // size of data
+                                            ECMC_EC_F64,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynContext_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for context.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for context: " + paramName);
+    }
+
+    asynContext_->setAllowWriteToEcmc(false);  // read only
+    asynContext_->refreshParam(1); // read once into asyn param lib
+  }
+
+  // Add replay progress "plugin.scope%d.replaycycles" (records processed)
+  if(replay_) {
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_REPLAY_CYCLES;
+
+    asynReplayCycles_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32,        // asyn type 
+                                            (uint8_t*)&replayCyclesPublish_, // pointer to data
+                                            sizeof(replayCyclesPublish_), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynReplayCycles_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for replay cycles.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for replay cycles: " + paramName);
+    }
+
+    asynReplayCycles_->setAllowWriteToEcmc(false);  // read only
+    asynReplayCycles_->refreshParam(1); // read once into asyn param lib
+  }
+
+  // Add mask test "plugin.scope%d.mask*" (envelope written over asyn, counters)
+  if(mask_) {
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_MASK_UPPER;
+
+    asynMaskUpper_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamFloat64Array, // asyn type 
+                                            (uint8_t*)mask_->getUpperReq(), // pointer to data
+                                            cfgBufferElementCount_ * sizeof(double), // size of data
+                                            ECMC_EC_F64,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynMaskUpper_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for mask upper.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for mask upper: " + paramName);
+    }
+
+    asynMaskUpper_->setAllowWriteToEcmc(true);
+    asynMaskUpper_->refreshParam(1); // read once into asyn param lib
+
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_MASK_LOWER;
+
+    asynMaskLower_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamFloat64Array, // asyn type 
+                                            (uint8_t*)mask_->getLowerReq(), // pointer to data
+                                            cfgBufferElementCount_ * sizeof(double), // size of data
+                                            ECMC_EC_F64,           // ecmc data type
+                                            0);                    // die if fail
+
+    if(!asynMaskLower_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for mask lower.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for mask lower: " + paramName);
+    }
+
+    asynMaskLower_->setAllowWriteToEcmc(true);
+    asynMaskLower_->refreshParam(1); // read once into asyn param lib
+    mask_->setAsynPort(ecmcAsynPort);  // Locked by mask worker while copying envelope
+
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_MASK_PASS;
 
-  resultParam_->setAllowWriteToEcmc(false);  // read only
-  resultParam_->refreshParam(1); // read once into asyn param lib
-  ecmcAsynPort->callParamCallbacks(ECMC_ASYN_DEFAULT_LIST, ECMC_ASYN_DEFAULT_ADDR);  
+    asynMaskPass_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32,        // asyn type 
+                                            (uint8_t*)&maskPass_, // pointer to data
+                                            sizeof(maskPass_), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
 
-  // Add enable "plugin.scope%d.enable"
-  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
-                          "." + ECMC_PLUGIN_ASYN_ENABLE;
+    if(!asynMaskPass_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for mask pass.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for mask pass: " + paramName);
+    }
 
-  enbaleParam_ = ecmcAsynPort->addNewAvailParam(
-                                          paramName.c_str(),     // name
-                                          asynParamInt32,        // asyn type 
-                                          (uint8_t*)&cfgEnable_, // pointer to data
-                                          sizeof(cfgEnable_),    // size of data
-                                          ECMC_EC_S32,           // ecmc data type
-                                          0);                    // die if fail
+    asynMaskPass_->setAllowWriteToEcmc(false);  // read only
+    asynMaskPass_->refreshParam(1); // read once into asyn param lib
 
-  if(!enbaleParam_) {
-    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for enable.");
-    throw std::runtime_error( "ERROR: Failed create asyn param for enable: " + paramName);
-  }
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_MASK_FAIL;
 
-  enbaleParam_->setAllowWriteToEcmc(true);
-  enbaleParam_->refreshParam(1); // read once into asyn param lib
-  ecmcAsynPort->callParamCallbacks(ECMC_ASYN_DEFAULT_LIST, ECMC_ASYN_DEFAULT_ADDR);  
+    asynMaskFail_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32,        // asyn type 
+                                            (uint8_t*)&maskFail_, // pointer to data
+                                            sizeof(maskFail_), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
 
-  // Add missed triggers "plugin.scope%d.missed"
-  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
-                          "." + ECMC_PLUGIN_ASYN_MISSED;
+    if(!asynMaskFail_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for mask fail.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for mask fail: " + paramName);
+    }
 
-  asynMissedTriggs_ = ecmcAsynPort->addNewAvailParam(
-                                          paramName.c_str(),     // name
-                                          asynParamInt32,        // asyn type 
-                                          (uint8_t*)&missedTriggs_, // pointer to data
-                                          sizeof(missedTriggs_),    // size of data
-                                          ECMC_EC_S32,           // ecmc data type
-                                          0);                    // die if fail
+    asynMaskFail_->setAllowWriteToEcmc(false);  // read only
+    asynMaskFail_->refreshParam(1); // read once into asyn param lib
 
-  if(!asynMissedTriggs_) {
-    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for missed trigg counter.");   
-    throw std::runtime_error( "ERROR: Failed create asyn param for missed trigg counter: " + paramName);
-  }
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_MASK_FIRST;
 
-  asynMissedTriggs_->setAllowWriteToEcmc(false);
-  asynMissedTriggs_->refreshParam(1); // read once into asyn param lib
-  ecmcAsynPort->callParamCallbacks(ECMC_ASYN_DEFAULT_LIST, ECMC_ASYN_DEFAULT_ADDR);  
+    asynMaskFirst_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32,        // asyn type 
+                                            (uint8_t*)&maskFirst_, // pointer to data
+                                            sizeof(maskFirst_), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
 
-  // Add trigger counter "plugin.scope%d.count"
-  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
-                          "." + ECMC_PLUGIN_ASYN_TRIGG_COUNT;
+    if(!asynMaskFirst_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for mask first violation.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for mask first violation: " + paramName);
+    }
 
-  asynTriggerCounter_ = ecmcAsynPort->addNewAvailParam(
-                                          paramName.c_str(),     // name
-                                          asynParamInt32,        // asyn type 
-                                          (uint8_t*)&triggerCounter_, // pointer to data
-                                          sizeof(triggerCounter_),    // size of data
-                                          ECMC_EC_S32,           // ecmc data type
-                                          0);                    // die if fail
+    asynMaskFirst_->setAllowWriteToEcmc(false);  // read only
+    asynMaskFirst_->refreshParam(1); // read once into asyn param lib
 
-  if(!asynTriggerCounter_) {
-    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for trigg counter.");   
-    throw std::runtime_error( "ERROR: Failed create asyn param for trigg counter: " + paramName);
-  }
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_MASK_VIOLATIONS;
 
-  asynTriggerCounter_->setAllowWriteToEcmc(false);
-  asynTriggerCounter_->refreshParam(1); // read once into asyn param lib
-  ecmcAsynPort->callParamCallbacks(ECMC_ASYN_DEFAULT_LIST, ECMC_ASYN_DEFAULT_ADDR);  
+    asynMaskViolations_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32,        // asyn type 
+                                            (uint8_t*)&maskViolations_, // pointer to data
+                                            sizeof(maskViolations_), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
 
-  // Add trigger counter "plugin.scope%d.scantotrigg"
-  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
-                          "." + ECMC_PLUGIN_ASYN_SCAN_TO_TRIGG_OFFSET;
+    if(!asynMaskViolations_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for mask violations.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for mask violations: " + paramName);
+    }
 
-  asynTimeTrigg2Sample_ = ecmcAsynPort->addNewAvailParam(
-                                          paramName.c_str(),     // name
-                                          asynParamFloat64,      // asyn type 
-                                          (uint8_t*)&samplesSinceLastTrigg_, // pointer to data
-                                          sizeof(samplesSinceLastTrigg_),    // size of data
-                                          ECMC_EC_S64,           // ecmc data type
-                                          0);                    // die if fail
+    asynMaskViolations_->setAllowWriteToEcmc(false);  // read only
+    asynMaskViolations_->refreshParam(1); // read once into asyn param lib
 
-  if(!asynTimeTrigg2Sample_) {
-    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for time trigg to sample.");   
-    throw std::runtime_error( "ERROR: Failed create asyn param for time trigg to sample: " + paramName);
-  }
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_MASK_RESET;
 
-  asynTimeTrigg2Sample_->addSupportedAsynType(asynParamFloat64);
-  asynTimeTrigg2Sample_->setAllowWriteToEcmc(false);
-  asynTimeTrigg2Sample_->refreshParam(1); // read once into asyn param lib
-  ecmcAsynPort->callParamCallbacks(ECMC_ASYN_DEFAULT_LIST, ECMC_ASYN_DEFAULT_ADDR);  
+    asynMaskReset_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32,        // asyn type 
+                                            (uint8_t*)&maskResetReq_, // pointer to data
+                                            sizeof(maskResetReq_), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
 
-  // Add enable "plugin.scope%d.source"
-  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
-                          "." + ECMC_PLUGIN_ASYN_SCOPE_SOURCE;
+    if(!asynMaskReset_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for mask reset.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for mask reset: " + paramName);
+    }
 
-  sourceStrParam_ = ecmcAsynPort->addNewAvailParam(
-                                          paramName.c_str(),     // name
-                                          asynParamInt8Array,    // asyn type 
-                                          (uint8_t*)cfgDataSourceStr_,// pointer to data
-                                          strlen(cfgDataSourceStr_),  // size of data
-                                          ECMC_EC_U8,            // ecmc data type
-                                          0);                    // die if fail
+    asynMaskReset_->setAllowWriteToEcmc(true);
+    asynMaskReset_->refreshParam(1); // read once into asyn param lib
 
-  if(!sourceStrParam_) {
-    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for data source.");   
-    throw std::runtime_error( "ERROR: Failed create asyn param for data source: " + paramName);
-  }
+    paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+                            "." + ECMC_PLUGIN_ASYN_MASK_APPLY;
 
-  sourceStrParam_->setAllowWriteToEcmc(false);  // read only
-  sourceStrParam_->refreshParam(1); // read once into asyn param lib
-  ecmcAsynPort->callParamCallbacks(ECMC_ASYN_DEFAULT_LIST, ECMC_ASYN_DEFAULT_ADDR);  
+    asynMaskApply_ = ecmcAsynPort->addNewAvailParam(
+                                            paramName.c_str(),     // name
+                                            asynParamInt32,        // asyn type 
+                                            (uint8_t*)&maskApplyReq_, // pointer to data
+                                            sizeof(maskApplyReq_), // size of data
+                                            ECMC_EC_S32,           // ecmc data type
+                                            0);                    // die if fail
 
-  // Add enable "plugin.scope%d.trigg"
+    if(!asynMaskApply_) {
+      SCOPE_DBG_PRINT("ERROR: Failed create asyn param for mask apply.");
+      throw std::runtime_error( "ERROR: Failed create asyn param for mask apply: " + paramName);
+    }
+
+    asynMaskApply_->setAllowWriteToEcmc(true);
+    asynMaskApply_->refreshParam(1); // read once into asyn param lib
+  }
+
+  // Add structured capture "plugin.scope%d.frame" (frame header + data)
   paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
-                          "." + ECMC_PLUGIN_ASYN_SCOPE_TRIGG;
+                          "." + ECMC_PLUGIN_ASYN_FRAME;
 
-  triggStrParam_ = ecmcAsynPort->addNewAvailParam(
+  asynFrame_ = ecmcAsynPort->addNewAvailParam(
                                           paramName.c_str(),     // name
                                           asynParamInt8Array,    // asyn type 
-                                          (uint8_t*)cfgTriggStr_,// pointer to data
-                                          strlen(cfgTriggStr_),  // size of data
+                                          captureBuffer_,        // pointer to data
+                                          captureBufferBytes_,   // size of data
                                           ECMC_EC_U8,            // ecmc data type
                                           0);                    // die if fail
 
-  if(!triggStrParam_) {
-    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for trigger.");       
-    throw std::runtime_error( "ERROR: Failed create asyn param for trigger: " + paramName);
+  if(!asynFrame_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for frame.");
+    throw std::runtime_error( "ERROR: Failed create asyn param for frame: " + paramName);
   }
 
-  triggStrParam_->setAllowWriteToEcmc(false);  // read only
-  triggStrParam_->refreshParam(1); // read once into asyn param lib
-  ecmcAsynPort->callParamCallbacks(ECMC_ASYN_DEFAULT_LIST, ECMC_ASYN_DEFAULT_ADDR);  
+  asynFrame_->setAllowWriteToEcmc(false);  // read only
+  asynFrame_->refreshParam(1); // read once into asyn param lib
 
-  // Add enable "plugin.scope%d.nexttime"
+  if(!cfgCompress_) {
+    return;
+  }
+
+  // Add compressed result "plugin.scope%d.resultcompressed" (codec header + payload)
   paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
-                          "." + ECMC_PLUGIN_ASYN_SCOPE_NEXT_SYNC;
+                          "." + ECMC_PLUGIN_ASYN_RESULT_COMPRESSED;
 
-  sourceNexttimeStrParam_ = ecmcAsynPort->addNewAvailParam(
+  asynCompressed_ = ecmcAsynPort->addNewAvailParam(
                                           paramName.c_str(),     // name
                                           asynParamInt8Array,    // asyn type 
-                                          (uint8_t*)cfgDataNexttimeStr_,// pointer to data
-                                          strlen(cfgDataNexttimeStr_),  // size of data
+                                          compressedDataBuffer_, // pointer to data
+                                          compressedDataBufferBytes_,  // size of data
                                           ECMC_EC_U8,            // ecmc data type
                                           0);                    // die if fail
 
-  if(!sourceNexttimeStrParam_) {
-    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for nexttime.");       
-    throw std::runtime_error( "ERROR: Failed create asyn param for nexttime: " + paramName);
+  if(!asynCompressed_) {
+    SCOPE_DBG_PRINT("ERROR: Failed create asyn param for compressed result.");
+    throw std::runtime_error( "ERROR: Failed create asyn param for compressed result: " + paramName);
   }
 
-  sourceNexttimeStrParam_->setAllowWriteToEcmc(false);  // read only
-  sourceNexttimeStrParam_->refreshParam(1); // read once into asyn param lib
-  ecmcAsynPort->callParamCallbacks(ECMC_ASYN_DEFAULT_LIST, ECMC_ASYN_DEFAULT_ADDR);
+  asynCompressed_->setAllowWriteToEcmc(false);  // read only
+  asynCompressed_->refreshParam(1); // read once into asyn param lib
 
 }
 
@@ -980,23 +3628,448 @@ std::string ecmcScope::to_string(int value) {
 }
 
 void ecmcScope::setEnable(int enable) {
-  if(enable) {
-    SCOPE_DBG_PRINT("INFO: Scope enabled.\n");
+  pushCommand(ECMC_SCOPE_CMD_ENABLE, enable);
+}
+  
+void ecmcScope::triggScope() {
+  pushCommand(ECMC_SCOPE_CMD_TRIGG, 0);
+}
+
+/** Arm scope. singleShot=1: SINGLE mode, only one capture then wait for re-arm.
+ *  singleShot=0: leave SINGLE mode (NORMAL), other modes are kept.
+*/
+void ecmcScope::armScope(int singleShot) {
+  pushCommand(ECMC_SCOPE_CMD_ARM, singleShot ? 1 : 0);
+}
+
+void ecmcScope::setMode(int mode) {
+  pushCommand(ECMC_SCOPE_CMD_MODE, mode);
+}
+
+/** Queue control command (applied by rt at start of next execute())*/
+void ecmcScope::pushCommand(int cmd, int value) {
+  if(!cmdQueue_->push(cmd, value)) {
+    SCOPE_DBG_PRINT("ERROR: Command queue full.\n");
+    throw std::runtime_error("ERROR: Command queue full.");
+  }
+  if(hotWake_) {
+    __atomic_store_n(hotWake_, 1, __ATOMIC_RELEASE);
+  }
+}
+
+void ecmcScope::bindHot(ecmcScopeHot *hot, size_t index) {
+  hot->setNexttime(index, sourceDataNexttimeItemInfo_, timebase_);
+  for(int i = 0; i < trigg_->getSourceCount(); ++i) {
+    hot->addTrigg(index, trigg_->getSourceInfo(i));
+  }
+  // Asyn requests wake a quiet scope (flags are reset to 0 when applied)
+  static const int reqApplied = 0;
+  hot->addRequest(index, &enableReq_, &enableSeen_);
+  hot->addRequest(index, &modeReq_, &modeSeen_);
+  hot->addRequest(index, &armReq_, &reqApplied);
+  if(mask_) {
+    hot->addRequest(index, &maskResetReq_, &reqApplied);
+    hot->addRequest(index, &maskApplyReq_, &reqApplied);
+  }
+  hotWake_ = hot->getWakeCell(index);
+}
+
+/** Quiet: waiting for trigger (normal or single mode), single shot done or
+ *  disabled, and no per cycle work (own last scan copy, logic packing,
+ *  sub rate, flight recorder, windowed readout, pending publish (also
+ *  last chunks and mask envelope copy) or commands).
+*/
+bool ecmcScope::isQuiet() {
+  if(!dataSourceLinked_ || !sharedHistory_ || logic_ || recorder_ ||
+     view_ || triggLogDirty_ || triggOnce_ || armCmd_ || cfgMode_ != activeMode_ ||
+     chunkDrain_ || (mask_ && mask_->envelopeBusy())) {
+    return false;
+  }
+  if(!cfgEnable_ || scopeState_ == ECMC_SCOPE_STATE_IDLE) {
+    return true;
+  }
+  return scopeState_ == ECMC_SCOPE_STATE_WAIT_TRIGG &&
+         activeMode_ != ECMC_SCOPE_MODE_AUTO &&
+         activeMode_ != ECMC_SCOPE_MODE_ROLL;
+}
+
+void ecmcScope::resume(uint32_t skipped) {
+  // Waiting for trigger: last scan is previous cycle (shared source)
+  if(skipped && cfgEnable_ && scopeState_ == ECMC_SCOPE_STATE_WAIT_TRIGG) {
+    lastScanNexttime_ = timebase_->getNexttime();
+    lastScanValid_    = 1;
+  }
+}
+
+/** Apply asyn requests and queued commands (rt only).
+ *  Asyn writes and plc commands in the same cycle: last applied wins
+ *  (asyn requests are applied first).
+*/
+void ecmcScope::drainCommands() {
+  ecmcScopeCmd cmd;
+
+  // Asyn request cells
+  int req = __atomic_load_n(&enableReq_, __ATOMIC_ACQUIRE);
+  if(req != enableSeen_) {
+    enableSeen_ = req;
+    cmd.cmd     = ECMC_SCOPE_CMD_ENABLE;
+    cmd.value   = req;
+    applyCommand(&cmd);
+  }
+
+  req = __atomic_load_n(&modeReq_, __ATOMIC_ACQUIRE);
+  if(req != modeSeen_) {
+    modeSeen_ = req;
+    cmd.cmd   = ECMC_SCOPE_CMD_MODE;
+    cmd.value = req;
+    applyCommand(&cmd);
+  }
+
+  if(__atomic_exchange_n(&armReq_, 0, __ATOMIC_ACQ_REL)) {
+    cmd.cmd   = ECMC_SCOPE_CMD_ARM;
+    cmd.value = -1;  // Keep mode
+    applyCommand(&cmd);
+    asynArm_->refreshParam(1);
+  }
+
+  if(recorder_) {
+    if(__atomic_exchange_n(&recorderFreezeReq_, 0, __ATOMIC_ACQ_REL)) {
+      cmd.cmd   = ECMC_SCOPE_CMD_FREEZE;
+      cmd.value = 0;
+      applyCommand(&cmd);
+      asynRecorderFreeze_->refreshParam(1);
+    }
+
+    // New readout index: publish that capture
+    req = __atomic_load_n(&recorderIndexReq_, __ATOMIC_ACQUIRE);
+    if(req != recorderIndexSeen_) {
+      recorderIndexSeen_ = req;
+      if(!recorderPublish_) {
+        recorderPublish_ = 1;
+      }
+    }
+  }
+
+  if(mask_ && __atomic_exchange_n(&maskResetReq_, 0, __ATOMIC_ACQ_REL)) {
+    maskPass_       = 0;
+    maskFail_       = 0;
+    maskFirst_      = -1;
+    maskViolations_ = 0;
+    publishMask();
+    asynMaskReset_->refreshParam(1);
+  }
+
+  // Envelope copied by mask worker (under asyn lock), then swapped in here.
+  // The request cell is left set while a copy is in progress.
+  if(mask_ && !mask_->envelopeBusy() &&
+     __atomic_exchange_n(&maskApplyReq_, 0, __ATOMIC_ACQ_REL)) {
+    mask_->requestEnvelope();
+  }
+
+  if(mask_ && mask_->applyEnvelope()) {
+    asynMaskApply_->refreshParam(1);
+  }
+
+  // Plc commands
+  while(cmdQueue_->pop(&cmd)) {
+    applyCommand(&cmd);
+  }
+
+  // Re-arm: unfreeze when the recorder worker is not reading the rings
+  if(recorderUnfreeze_ && !recorder_->publishBusy()) {
+    recorder_->unfreeze();
+    recorderUnfreeze_ = 0;
+    recorderFrozen_   = 0;
+    asynRecorderFrozen_->refreshParam(1);
+  }
+}
+
+void ecmcScope::applyCommand(ecmcScopeCmd *cmd) {
+  switch(cmd->cmd) {
+    case ECMC_SCOPE_CMD_ENABLE:
+      if(cmd->value) {
+        SCOPE_DBG_PRINT("INFO: Scope enabled.\n");
+      }
+      else {
+        SCOPE_DBG_PRINT("INFO: Scope disabled.\n");
+      }
+      cfgEnable_ = cmd->value;
+      syncRequest(&enableReq_, &enableSeen_, cfgEnable_, enbaleParam_);
+      break;
+    case ECMC_SCOPE_CMD_TRIGG:
+      triggOnce_ = 1;
+      break;
+    case ECMC_SCOPE_CMD_ARM:
+      if(cmd->value > 0) {
+        cfgMode_ = ECMC_SCOPE_MODE_SINGLE;
+      }
+      else if(cmd->value == 0 && cfgMode_ == ECMC_SCOPE_MODE_SINGLE) {
+        cfgMode_ = ECMC_SCOPE_MODE_NORMAL;
+      }
+      syncRequest(&modeReq_, &modeSeen_, cfgMode_, asynMode_);
+      armCmd_ = 1;
+      // Re-arm also restarts the flight recorder (end of drainCommands())
+      if(recorder_ && recorder_->isFrozen()) {
+        recorderUnfreeze_ = 1;
+      }
+      break;
+    case ECMC_SCOPE_CMD_MODE:
+      cfgMode_ = cmd->value;
+      syncRequest(&modeReq_, &modeSeen_, cfgMode_, asynMode_);
+      break;
+    case ECMC_SCOPE_CMD_FREEZE:
+      if(recorder_) {
+        applyFreeze(0);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+/** Write back live value to asyn request cell. Only if the cell was not
+ *  written over asyn since last poll (then the new request is applied next
+ *  cycle instead).
+*/
+void ecmcScope::syncRequest(int *req, int *seen, int value, ecmcAsynDataItem *param) {
+  if(*seen == value) {
+    return;
+  }
+  int expected = *seen;
+  if(__atomic_compare_exchange_n(req, &expected, value, false,
+                                 __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    *seen = value;
+    if(param) {
+      param->refreshParam(1);
+    }
+  }
+}
+
+int ecmcScope::getStatus() {
+  if(!cfgEnable_) {
+    return ECMC_SCOPE_STATUS_DISABLED;
+  }
+  if(scopeState_ == ECMC_SCOPE_STATE_IDLE) {
+    return ECMC_SCOPE_STATUS_DONE;
+  }
+  if(scopeState_ == ECMC_SCOPE_STATE_COLLECT || scopeState_ == ECMC_SCOPE_STATE_WAIT_NEXT ||
+     activeMode_ == ECMC_SCOPE_MODE_ROLL) {
+    return ECMC_SCOPE_STATUS_COLLECT;
+  }
+  return ECMC_SCOPE_STATUS_WAIT_TRIGG;
+}
+
+int ecmcScope::getTriggerCount() {
+  return triggerCounter_;
+}
+
+double ecmcScope::getStatistic(int stat) {
+  if(stat < 0 || stat >= ECMC_SCOPE_STAT_COUNT) {
+    throw std::out_of_range("ERROR: Statistic index out of range.");
+  }
+  if(!cfgStats_) {
+    throw std::runtime_error("ERROR: Statistics not enabled (STATS=1).");
+  }
+  return resultStats_[stat];
+}
+
+/** Element of result buffer. Note: During collect (see getStatus()) the buffer
+ *  contains data from the ongoing capture.
+ *  Logic analyzer mode: element of the unpacked result (same as "resultdata",
+ *  channel major, updated when the capture is published).
+*/
+double ecmcScope::getResultElement(size_t index) {
+  if(logic_) {
+    if(!logicChannelBuffer_ || index >= logicChannelBufferBytes_) {
+      throw std::out_of_range("ERROR: Result element index out of range.");
+    }
+    return (double)logicChannelBuffer_[index];
+  }
+  if(!resultDataBuffer_ || index >= cfgBufferElementCount_) {
+    throw std::out_of_range("ERROR: Result element index out of range.");
+  }
+  return getEcDataAsDouble(&resultDataBuffer_[index * sourceDataItemInfo_->dataElementSize],
+                           sourceDataItemInfo_->dataType);
+}
+
+/** Freeze flight recorder (applied by rt at start of next execute()).
+ *  Unfreeze by arm.
+*/
+void ecmcScope::freezeRecorder() {
+  if(!cfgRecorderCaptures_) {
+    throw std::runtime_error("ERROR: Flight recorder not configured.");
+  }
+  pushCommand(ECMC_SCOPE_CMD_FREEZE, 0);
+}
+
+/** Add current scan to flight recorder history (read directly into the ring).*/
+void ecmcScope::recordScan() {
+  uint8_t *slot = recorder_->getScanSlot();
+  if(!slot) {
+    return;
+  }
+  uint64_t nexttime = timebase_->unwrap(sourceNexttime_);
+  memcpy(slot, &nexttime, sizeof(nexttime));
+  if( readSource(slot + sizeof(nexttime),sourceDataItemInfo_->dataSize)){
+    SCOPE_DBG_PRINT("ERROR: Failed read data source.\n");
+    throw std::runtime_error( "ERROR: Failed read data source." );
+  }
+  recorder_->commitScan();
+}
+
+/** Freeze flight recorder. Constant time (rt), the content is published
+ *  first in next cycle.
+*/
+void ecmcScope::applyFreeze(int error) {
+  // A pending unfreeze is dropped (content unchanged, frozen again)
+  if(recorder_->isFrozen() && !recorderUnfreeze_) {
+    return;
+  }
+  recorderUnfreeze_ = 0;
+  recorder_->freeze();
+  recorderFrozen_   = 1;
+  recorderError_    = error;
+  recorderPublish_  = 2;  // Capture and history
+  SCOPE_DBG_PRINT("INFO: Flight recorder frozen.\n");
+}
+
+/** Publish capture of readout index (0 = newest) and, first cycle after
+ *  freeze, the history.
+*/
+/** The rings are copied by the recorder worker (rt never copies them).
+ *  Copies ready since last cycle are published first, then a pending
+ *  request is handed to the worker (retried next cycle if busy).
+*/
+void ecmcScope::publishRecorder() {
+  if(recorder_->publishReady()) {
+    const uint8_t *history = recorder_->getPublishedHistory();
+    if(history && asynRecorderHistory_) {
+      asynRecorderHistory_->refreshParam(1, (uint8_t*)history,
+                                         recorder_->getPublishedHistoryBytes());
+    }
+    const uint8_t *capture = recorder_->getPublishedCapture();
+    if(capture) {
+      asynRecorderFrame_->refreshParam(1);
+    }
+    else {
+      SCOPE_DBG_PRINT("WARNING: Flight recorder index out of range.\n");
+    }
+    recorder_->publishDone();
+  }
+
+  if(!recorderPublish_ ||
+     !recorder_->requestPublish(recorderIndexSeen_, recorderPublish_ > 1)) {
+    return;
+  }
+  if(recorderPublish_ > 1) {
+    asynRecorderFrozen_->refreshParam(1);
+    asynRecorderError_->refreshParam(1);
+  }
+  recorderPublish_ = 0;
+  recorderCount_   = recorder_->getCaptureCount();
+  asynRecorderCount_->refreshParam(1);
+}
+
+/** Mask test of completed capture. Returns true if failed.*/
+bool ecmcScope::testMask() {
+  maskViolations_ = (int)mask_->test(resultDataBuffer_);
+  maskFirst_      = (int)mask_->getFirstViolation();
+  if(maskViolations_) {
+    maskFail_++;
   }
   else {
-    SCOPE_DBG_PRINT("INFO: Scope disabled.\n");
+    maskPass_++;
   }
+  return maskViolations_ > 0;
+}
 
-  cfgEnable_ = enable;
-  enbaleParam_->refreshParam(1);
+void ecmcScope::publishMask() {
+  asynMaskPass_->refreshParam(1);
+  asynMaskFail_->refreshParam(1);
+  asynMaskFirst_->refreshParam(1);
+  asynMaskViolations_->refreshParam(1);
 }
-  
-void ecmcScope::triggScope() {
-  triggOnce_ = 1;
+
+void ecmcScope::replayThread(void *obj) {
+  ((ecmcScope*)obj)->runReplay();
+}
+
+/** Replay worker: all records through the scope engine (oldest first) as
+ *  fast as possible. Each record is processed like one live cycle (trigger
+ *  evaluation, timebase, gap detection and capture). Captures are appended
+ *  to the output file.
+*/
+void ecmcScope::runReplay() {
+  uint64_t records = replay_->getRecordCount();
+  uint64_t cycles  = 0;
+  epicsTimeStamp start;
+  epicsTimeStamp end;
+  epicsTimeGetCurrent(&start);
+
+  try {
+    // First record is reference (no trigger)
+    trigg_->resetRecorded(replay_->getTrigg(0));
+    for(; cycles < records && !__atomic_load_n(&replayStop_, __ATOMIC_ACQUIRE); ++cycles) {
+      sourceNexttime_ = replay_->getNexttime(cycles);
+      replayData_     = (uint8_t*)replay_->getScan(cycles);
+      executeScan(trigg_->evaluateRecorded(replay_->getTrigg(cycles), sourceNexttime_, &triggTime_));
+      __atomic_store_n(&replayCycles_, cycles + 1, __ATOMIC_RELAXED);
+    }
+  }
+  catch(std::exception &e) {
+    printf("ecmcScope%d: ERROR: Replay aborted at record %" PRIu64 ": %s\n",
+           objectId_, cycles, e.what());
+  }
+  replayData_ = NULL;
+  fflush(replayOut_);
+
+  epicsTimeGetCurrent(&end);
+  double seconds  = epicsTimeDiffInSeconds(&end, &start);
+  double recorded = cycles * (double)replay_->getCycleNs() / 1E9;
+  printf("ecmcScope%d: Replay done: %" PRIu64 " cycles, %d captures in %.3f s (%.1f x realtime).\n",
+         objectId_, cycles, triggerCounter_, seconds,
+         seconds > 0 ? recorded / seconds : 0.0);
+
+  __atomic_store_n(&replayDone_, 1, __ATOMIC_RELEASE);
+  epicsEventSignal(replayExitEvent_);
+}
+
+/** Replay progress (rt). When the worker is done the counters, trigger log
+ *  and last capture are published once.
+*/
+void ecmcScope::publishReplay() {
+  if(replayPublished_) {
+    return;
+  }
+  int done = __atomic_load_n(&replayDone_, __ATOMIC_ACQUIRE);
+  int32_t cycles = (int32_t)__atomic_load_n(&replayCycles_, __ATOMIC_RELAXED);
+  if(cycles != replayCyclesPublish_ || done) {
+    replayCyclesPublish_ = cycles;
+    asynReplayCycles_->refreshParam(done);  // Progress at param sample rate
+  }
+  if(!done) {
+    return;
+  }
+
+  asynMissedTriggs_->refreshParam(1);
+  asynTriggerCounter_->refreshParam(1);
+  asynCaptureValid_->refreshParam(1);
+  asynCaptureGaps_->refreshParam(1);
+  asynSamplePeriod_->refreshParam(1);
+  publishTriggLog();
+  if(mask_) {
+    publishMask();
+  }
+  if(triggerCounter_) {
+    resultParam_->refreshParam(1);
+    asynFrame_->refreshParam(1);
+  }
+  replayPublished_ = 1;
 }
 
+// Trigger handled (or disregarded)
 void ecmcScope::setWaitForNextTrigg() {
-  oldTriggTime_ = triggTime_; 
+  newTrigg_ = 0;
 }
 
 // void ecmcScope::clearBuffers() {
@@ -16,14 +16,33 @@
 #include "ecmcDataItem.h"
 #include "ecmcAsynPortDriver.h"
 #include "ecmcScopeDefs.h"
+#include "ecmcScopeCodec.h"
+#include "ecmcScopeTrigg.h"
+#include "ecmcScopeTimebase.h"
+#include "ecmcScopeEts.h"
+#include "ecmcScopeLogic.h"
+#include "ecmcScopeCmdQueue.h"
+#include "ecmcScopeFrame.h"
+#include "ecmcScopePersist.h"
+#include "ecmcScopeSource.h"
+#include "ecmcScopeRecorder.h"
+#include "ecmcScopeView.h"
+#include "ecmcScopeMem.h"
+#include "ecmcScopeHot.h"
+#include "ecmcScopeReplay.h"
+#include "ecmcScopeMask.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
 #include "inttypes.h"
+#include <stdio.h>
 #include <string>
 
 typedef enum {
     ECMC_SCOPE_STATE_INVALID,     /**Invalid. */
     ECMC_SCOPE_STATE_WAIT_TRIGG,  /**Waiting for trigger. */
-    ECMC_SCOPE_STATE_WAIT_NEXT,   /**Waiting analog. (trigger newer than next ai time)*/
+    ECMC_SCOPE_STATE_WAIT_NEXT,   /**Trigger accepted, waiting for start of capture (trigger delay). */
     ECMC_SCOPE_STATE_COLLECT,     /**Filling buffer (waiting for data). */    
+    ECMC_SCOPE_STATE_IDLE,        /**Single shot done (waiting for re-arm). */
 } ecmcScopeState;
 
 class ecmcScope {
@@ -45,11 +64,24 @@ class ecmcScope {
   //                                           size_t size,
   //                                           ecmcEcDataType dt);
   // Call just before realtime because then all data sources should be available
-  void                  connectToDataSources();
+  void                  connectToDataSources(ecmcScopeSourceRegistry *sources);
   void                  setEnable(int enable);
   //void                  clearBuffers();
   void                  triggScope();
-  void                  execute();
+  void                  armScope(int singleShot);
+  void                  setMode(int mode);
+  int                   getStatus();
+  int                   getTriggerCount();
+  double                getStatistic(int stat);
+  double                getResultElement(size_t index);
+  void                  freezeRecorder();
+  void                  execute(int ecmcError);
+  // Hot state of scope manager (after connectToDataSources())
+  void                  bindHot(ecmcScopeHot *hot, size_t index);
+  // Nothing can happen until a trigger source changes
+  bool                  isQuiet();
+  // Full execution after skipped cycles (timebase tracked by hot state)
+  void                  resume(uint32_t skipped);
 
  private:
   void                  parseConfigStr(char *configStr);
@@ -59,45 +91,240 @@ class ecmcScope {
   int64_t               timeDiff();
   asynParamType         getResultAsynDTFromEcDT(ecmcEcDataType ecDT);
   void                  setWaitForNextTrigg();
+  void                  publishResult();
+  void                  calcStatistics();
+  void                  statsReset();
+  void                  statsAdd(const uint8_t *data, size_t elements);
+  void                  statsFinish();
+  void                  publishChunk();
+  void                  executeRoll();
+  void                  executeSubRate();
+  bool                  isWaitingScan(int triggEval);
+  void                  executeScan(int triggEval);
+  void                  applyMode();
+  void                  logTrigg(int outcome);
+  void                  publishTriggLog();
+  int                   cyclesSinceLastScan();
+  bool                  handleGap(int cycles);
+  void                  appendFill(size_t elements);
+  void                  connectLogicSources();
+  void                  connectContextItems();
+  void                  connectReplaySources();
+  ecmcDataItem         *findDataItem(const char *name);
+  void                  snapshotContext();
+  int                   readSource(uint8_t *data, size_t bytes);
+  uint8_t              *currentScan();
+  uint8_t              *lastScan();
+  void                  drainCommands();
+  void                  applyCommand(ecmcScopeCmd *cmd);
+  void                  pushCommand(int cmd, int value);
+  void                  syncRequest(int *req, int *seen, int value, ecmcAsynDataItem *param);
+  bool                  startCapture();
+  void                  setFrameTrigg(uint64_t triggTime, double firstSampleOffsetNs, uint32_t flags);
+  void                  recordScan();
+  void                  updateHistoryUser();
+  void                  applyFreeze(int error);
+  void                  publishRecorder();
+  bool                  testMask();
+  void                  publishMask();
+  void                  updateFrameHeader();
+  void                  writeReplayFrame();
+  void                  publishReplay();
+  void                  runReplay();
+  static void           replayThread(void *obj);
 
 
-  uint8_t*              resultDataBuffer_;
+  uint8_t*              captureBuffer_;      // Frame header + result data
+  size_t                captureBufferBytes_;
+  size_t                captureBufferMapped_; // Large capture mode: mmap bytes (0 = new[])
+  ecmcScopeFrameHeader *frameHeader_;        // Start of captureBuffer_
+  uint8_t*              resultDataBuffer_;   // Data part of captureBuffer_
+  double*               contextValues_;      // Context part of captureBuffer_ (after data)
+  ecmcDataItem         *contextItems_[ECMC_SCOPE_CONTEXT_MAX_ITEMS];
+  ecmcDataItemInfo     *contextItemInfos_[ECMC_SCOPE_CONTEXT_MAX_ITEMS];
+  int                   contextCount_;
   uint8_t*              lastScanSourceDataBuffer_;
   size_t                resultDataBufferBytes_;
   size_t                bytesInResultBuffer_;
+  uint8_t*              compressedDataBuffer_;
+  size_t                compressedDataBufferBytes_;
+  size_t                bytesInCompressedBuffer_;
   ecmcDataItem         *sourceDataItem_;
   ecmcDataItemInfo     *sourceDataItemInfo_;
   ecmcDataItem         *sourceDataNexttimeItem_;
   ecmcDataItemInfo     *sourceDataNexttimeItemInfo_;
-  ecmcDataItem         *sourceTriggItem_;
-  ecmcDataItemInfo     *sourceTriggItemInfo_;
+  ecmcScopeTrigg       *trigg_;
+  ecmcScopeTimebase    *timebase_;
+  ecmcScopeEts         *ets_;
+  double               *etsDataBuffer_;
+  size_t                etsDataBufferBytes_;
+  ecmcScopeLogic       *logic_;              // Logic analyzer mode if not NULL
+  uint8_t*              logicChannelBuffer_; // Unpacked result (channel major)
+  size_t                logicChannelBufferBytes_;
+  int32_t*              logicTransBuffer_;   // Transition list of result
+  size_t                logicTransBufferBytes_;
+  ecmcScopePersist     *persist_;            // Persistence image (worker thread) if not NULL
+  uint8_t*              historyDataBuffer_;  // Sub rate: recorded scans
+  uint64_t*             historyNexttime_;    // Sub rate: NEXT_TIME of recorded scans
+  uint64_t*             historyTriggValues_; // Sub rate: raw trigger sources of recorded scans
+  size_t                historySlots_;       // Sub rate: ring slots (EXEC_CYCLES + previous scan)
+  size_t                historyStart_;       // Sub rate: slot of oldest scan in batch
+  size_t                historyCount_;
+  size_t                historyBatch_;       // Sub rate: scans in next batch (first batch staggered)
+  uint8_t*              historyLast_;        // Sub rate: previous scan of processed scan (in ring)
+  uint8_t*              replayData_;         // Sub rate: scan read by readSource() (NULL = live)
+  ecmcScopeSource      *source_;             // Shared source history (not in logic analyzer mode)
+  ecmcScopeSourceRegistry *sources_;         // Shared sources and resolved data items
+  uint8_t              *hotWake_;            // Wake cell in hot state (queued commands)
+  int                   sharedHistory_;      // Last scan from source_ (no own last scan buffer)
+  int                   historyUser_;        // Needs last scan of source_ next cycle
+  ecmcScopeRecorder    *recorder_;           // Flight recorder if not NULL
+  ecmcScopeView        *view_;               // Windowed readout (worker thread) if not NULL
+  ecmcScopeReplay      *replay_;             // Offline replay (worker thread) if not NULL
+  FILE                 *replayOut_;          // Replay: structured captures written here
+  epicsEventId          replayExitEvent_;
+  int                   replayStop_;
+  int                   replayDone_;         // Worker finished (all state owned by rt again)
+  int                   replayPublished_;
+  uint64_t              replayCycles_;       // Records processed (written by worker)
+  int32_t               replayCyclesPublish_;
+  ecmcScopeMask        *mask_;               // Mask test if not NULL
+  int                   maskPass_;           // Published
+  int                   maskFail_;           // Published
+  int                   maskFirst_;          // First violation of last capture (-1 = pass, published)
+  int                   maskViolations_;     // Violations of last capture (published)
+  uint8_t*              chunkBuffer_;        // Large capture mode: chunk header + data
+  size_t                chunkBufferBytes_;
+  ecmcScopeChunkHeader *chunkHeader_;        // Start of chunkBuffer_
+  size_t                chunkPublishedBytes_; // Bytes of current capture published in chunks
+  size_t                chunkEndBytes_;      // Bytes of current capture available for chunks
+  uint32_t              chunkSequence_;
+  uint32_t              chunkIndex_;
+  uint32_t              chunkCapture_;       // Capture counter of current capture (chunk header)
+  int                   chunkDrain_;         // Capture completed, remaining chunks published one per cycle
+  int                   chunkThisCycle_;     // A chunk was published this cycle
+  int                   recorderFrozen_;     // Published
+  int                   recorderError_;      // ecmc error that froze the recorder (0 = command)
+  int                   recorderCount_;      // Captures in recorder (published)
+  int                   recorderPublish_;    // Copy request for recorder worker (2 = with history)
+  int                   recorderUnfreeze_;   // Re-arm: unfreeze when worker is idle
+  int                   lastEcmcError_;
   
   int                   dataSourceLinked_;   // To avoid link several times
   int                   objectId_;           // Unique object id
   int                   triggOnce_;
-  int                   firstTrigg_;
+  int                   armCmd_;
+  int                   activeMode_;
+  int                   autoCycleCounter_;
+  int                   autoTimeoutCycles_;
+  int                   rollCycleCounter_;
+  uint8_t*              rollDataBuffer_;
+  size_t                rollWritePos_;
+  int                   newTrigg_;
   
   uint64_t              triggTime_;
-  uint64_t              oldTriggTime_;
   uint64_t              sourceNexttime_;
-  int64_t               sourceSampleRateNS_; // nanoseconds
   ecmcScopeState        scopeState_;
   uint64_t              ecmcSmapleTimeNS_;
   int64_t               sourceElementsPerSample_;
   size_t                elementsInResultBuffer_;
   double                samplesSinceLastTrigg_;
+  double                samplePeriodNs_;     // Tracked sample period (published)
+  double                triggPhase_;         // Sub sample phase of trigger (-1 if software trigger)
+  uint64_t              captureTriggTime_;   // Unwrapped dc time of trigger of current capture
+  uint32_t              captureFlags_;       // Frame flags of current capture
+  double                captureDelayNs_;     // Trigger delay of current capture
+  double                startSamples_;       // Samples from capture start to NEXT_TIME (<= 0: waiting)
 
   // Config options
   char*                 cfgDataSourceStr_;   // Config: data source string
   char*                 cfgDataNexttimeStr_; // Config: data source string
   char*                 cfgTriggStr_;        // Config: trigg string
+  char*                 cfgContextStr_;      // Config: context items snapshot at trigger
   int                   cfgDbgMode_;         // Config: allow dbg printouts
   size_t                cfgBufferElementCount_; // Config: Data set size
   int                   cfgEnable_;          // Config: Enable data acq./calc.
+  int                   cfgCompress_;        // Config: Codec for compressed result (0=off)
+  int                   cfgMode_;            // Config: Acquisition mode
+  double                cfgAutoTimeoutMs_;   // Config: Auto mode timeout
+  int                   cfgRollCycles_;      // Config: Roll mode publish rate
+  int                   cfgTriggLogic_;      // Config: Trigger logic (OR/AND/SEQ)
+  int                   cfgTriggType_;       // Config: Trigger type (LATCH/CHANGE/RISING/FALLING/CROSS)
+  double                cfgTriggLevel_;      // Config: Level of RISING/FALLING/CROSS
+  int64_t               cfgTriggWindowNs_;   // Config: AND window
+  int64_t               cfgTriggSeqTimeoutNs_; // Config: SEQ timeout
+  int64_t               cfgTriggHoldoffNs_;  // Config: Holdoff after trigger
+  int                   cfgTriggPrescale_;   // Config: Use every n:th trigger
+  int64_t               cfgTriggDelay_;      // Config: Capture start after trigger
+  int                   cfgTriggDelaySamples_; // Config: Trigger delay unit (0=ns, 1=samples)
+  int                   cfgGapPolicy_;       // Config: Lost/repeated frames (FLAG/FILL/ABORT)
+  double                cfgGapFillValue_;    // Config: Value for lost samples (FILL)
+  int                   cfgEtsFactor_;       // Config: Equivalent time sampling grid factor (0=off)
+  int                   cfgEtsCaptures_;     // Config: Captures folded per ets result
+  int                   cfgExecCycles_;      // Config: Process scans every n:th cycle (sub rate)
+  int                   cfgPersistBins_;     // Config: Persistence amplitude bins (0=off)
+  double                cfgPersistMin_;      // Config: Persistence amplitude range
+  double                cfgPersistMax_;
+  double                cfgPersistDecay_;    // Config: Persistence decay per published image
+  double                cfgPersistPublishMs_; // Config: Persistence image publish period
+  int                   cfgRecorderCaptures_; // Config: Flight recorder captures (0=off)
+  int                   cfgRecorderHistoryCycles_; // Config: Flight recorder continuous history
+  int                   cfgRecorderFreezeOnError_; // Config: Freeze recorder on ecmc error
+  int                   cfgViewPoints_;      // Config: Windowed readout max points (0=off)
+  int                   cfgChunkElements_;   // Config: Large capture mode chunk size (0=off)
+  char*                 cfgReplayFileStr_;   // Config: Recorded cycles to replay (offline)
+  char*                 cfgReplayOutputStr_; // Config: Replay result file
+  int                   cfgMask_;            // Config: Mask test of each capture
+  int                   cfgMaskFreeze_;      // Config: Freeze flight recorder on failed mask test
+  int                   cfgStats_;           // Config: Statistics of each capture (scope_get_stat())
+
+  double                resultStats_[ECMC_SCOPE_STAT_COUNT];
+  double                statsMin_;           // Statistics accumulated over capture
+  double                statsMax_;
+  double                statsSum_;
+  double                statsSumSqr_;
 
   int                   missedTriggs_;
   int                   triggerCounter_;
 
+  // Trigger outcome counters and log (only written from rt)
+  int32_t               triggOutcomes_[ECMC_SCOPE_TRIGG_OUTCOME_COUNT];
+  int32_t               triggLog_[ECMC_SCOPE_TRIGG_LOG_ENTRIES * ECMC_SCOPE_TRIGG_LOG_WORDS];
+  int32_t               triggLogPublish_[ECMC_SCOPE_TRIGG_LOG_ENTRIES * ECMC_SCOPE_TRIGG_LOG_WORDS];
+  size_t                triggLogPos_;
+  int                   triggLogDirty_;
+
+  // Frame gap detection
+  uint64_t              lastScanNexttime_;   // Unwrapped NEXT_TIME of last scan buffer
+  int                   lastScanValid_;
+  uint8_t               gapFillElement_[8];  // cfgGapFillValue_ in source data type
+  int                   captureValid_;       // No gaps in capture (published)
+  int                   captureGaps_;        // Lost/repeated frames in capture (published)
+
+  // Control commands. Live state (cfgEnable_, cfgMode_, triggOnce_, armCmd_)
+  // is only written from rt when draining the queue (plc) and the request
+  // cells (asyn).
+  // Asyn request cell protocol: ecmc copies a written value into the cell
+  // with a plain 4 byte memcpy (asyn thread, port locked), not an atomic
+  // store. rt reads with __atomic loads, resets flags with exchange and
+  // writes back applied values with compare and swap (syncRequest()). This
+  // is formally a data race. It relies on the aligned int store being single
+  // copy atomic on the supported targets (x86-64, arm/aarch64), so rt sees
+  // the old or the new value, never a torn one. There is no ordering
+  // guarantee to other data, so a cell only carries its own value (the
+  // mask envelope is copied under the port lock, see ecmcScopeMask).
+  ecmcScopeCmdQueue    *cmdQueue_;
+  int                   enableReq_;          // Asyn request cell: enable
+  int                   enableSeen_;
+  int                   modeReq_;            // Asyn request cell: mode
+  int                   modeSeen_;
+  int                   armReq_;             // Asyn request cell: arm (reset by rt)
+  int                   recorderFreezeReq_;  // Asyn request cell: freeze recorder (reset by rt)
+  int                   recorderIndexReq_;   // Asyn request cell: recorder readout index
+  int                   recorderIndexSeen_;
+  int                   maskResetReq_;       // Asyn request cell: reset mask counters (reset by rt)
+  int                   maskApplyReq_;       // Asyn request cell: apply written envelope (reset by rt when copy starts)
+
   // Asyn
   ecmcAsynDataItem     *sourceStrParam_;
   ecmcAsynDataItem     *triggStrParam_;
@@ -107,6 +334,41 @@ class ecmcScope {
   ecmcAsynDataItem     *asynMissedTriggs_;
   ecmcAsynDataItem     *asynTriggerCounter_;
   ecmcAsynDataItem     *asynTimeTrigg2Sample_;
+  ecmcAsynDataItem     *asynCompressed_;
+  ecmcAsynDataItem     *asynMode_;
+  ecmcAsynDataItem     *asynArm_;
+  ecmcAsynDataItem     *asynTriggOutcomes_;
+  ecmcAsynDataItem     *asynTriggLog_;
+  ecmcAsynDataItem     *asynSamplePeriod_;
+  ecmcAsynDataItem     *asynCaptureValid_;
+  ecmcAsynDataItem     *asynCaptureGaps_;
+  ecmcAsynDataItem     *asynEts_;
+  ecmcAsynDataItem     *asynLogicTrans_;
+  ecmcAsynDataItem     *asynFrame_;
+  ecmcAsynDataItem     *asynPersist_;
+  ecmcAsynDataItem     *asynRecorderFrozen_;
+  ecmcAsynDataItem     *asynRecorderError_;
+  ecmcAsynDataItem     *asynRecorderCount_;
+  ecmcAsynDataItem     *asynRecorderFreeze_;
+  ecmcAsynDataItem     *asynRecorderIndex_;
+  ecmcAsynDataItem     *asynRecorderFrame_;
+  ecmcAsynDataItem     *asynRecorderHistory_;
+  ecmcAsynDataItem     *asynViewStart_;
+  ecmcAsynDataItem     *asynViewLength_;
+  ecmcAsynDataItem     *asynViewPoints_;
+  ecmcAsynDataItem     *asynViewMode_;
+  ecmcAsynDataItem     *asynView_;
+  ecmcAsynDataItem     *asynChunk_;
+  ecmcAsynDataItem     *asynContext_;
+  ecmcAsynDataItem     *asynReplayCycles_;
+  ecmcAsynDataItem     *asynMaskUpper_;
+  ecmcAsynDataItem     *asynMaskLower_;
+  ecmcAsynDataItem     *asynMaskPass_;
+  ecmcAsynDataItem     *asynMaskFail_;
+  ecmcAsynDataItem     *asynMaskFirst_;
+  ecmcAsynDataItem     *asynMaskViolations_;
+  ecmcAsynDataItem     *asynMaskReset_;
+  ecmcAsynDataItem     *asynMaskApply_;
 
 
   // Some generic utility functions
@@ -120,7 +382,11 @@ class ecmcScope {
   static int64_t        getInt64(uint8_t* data);
   static float          getFloat32(uint8_t* data);
   static double         getFloat64(uint8_t* data);
+  static double         getEcDataAsDouble(uint8_t* data, ecmcEcDataType dt);
+  static void           setEcDataFromDouble(uint8_t* data, ecmcEcDataType dt, double value);
   static size_t         getEcDataTypeByteSize(ecmcEcDataType dt);
+  static int            isEcDataTypeSigned(ecmcEcDataType dt);
+  static int            isEcDataTypeBit(ecmcEcDataType dt);
   static void           printEcDataArray(uint8_t*       data, 
                                          size_t         size,
                                          ecmcEcDataType dt,
@@ -0,0 +1,51 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeCmdQueue.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+#include <string.h>
+#include "ecmcScopeCmdQueue.h"
+
+#define ECMC_SCOPE_CMD_QUEUE_MASK (ECMC_SCOPE_CMD_QUEUE_SIZE - 1)
+
+ecmcScopeCmdQueue::ecmcScopeCmdQueue() {
+  memset(buffer_,0,sizeof(buffer_));
+  memset(pad_,0,sizeof(pad_));
+  head_ = 0;
+  tail_ = 0;
+}
+
+ecmcScopeCmdQueue::~ecmcScopeCmdQueue() {
+}
+
+bool ecmcScopeCmdQueue::push(int cmd, int value) {
+  size_t head = __atomic_load_n(&head_, __ATOMIC_RELAXED);
+  size_t tail = __atomic_load_n(&tail_, __ATOMIC_ACQUIRE);
+  if(head - tail >= ECMC_SCOPE_CMD_QUEUE_SIZE) {
+    return false;
+  }
+  buffer_[head & ECMC_SCOPE_CMD_QUEUE_MASK].cmd   = cmd;
+  buffer_[head & ECMC_SCOPE_CMD_QUEUE_MASK].value = value;
+  // Publish entry
+  __atomic_store_n(&head_, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+bool ecmcScopeCmdQueue::pop(ecmcScopeCmd *cmd) {
+  size_t tail = __atomic_load_n(&tail_, __ATOMIC_RELAXED);
+  size_t head = __atomic_load_n(&head_, __ATOMIC_ACQUIRE);
+  if(tail == head) {
+    return false;
+  }
+  *cmd = buffer_[tail & ECMC_SCOPE_CMD_QUEUE_MASK];
+  // Release slot
+  __atomic_store_n(&tail_, tail + 1, __ATOMIC_RELEASE);
+  return true;
+}
@@ -0,0 +1,57 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeCmdQueue.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_CMD_QUEUE_H_
+#define ECMC_SCOPE_CMD_QUEUE_H_
+
+#include <stddef.h>
+
+#define ECMC_SCOPE_CMD_QUEUE_SIZE  64  // Must be 2^n
+#define ECMC_SCOPE_CMD_QUEUE_PAD   64  // Cache line (head and tail on different lines)
+
+typedef enum {
+    ECMC_SCOPE_CMD_ENABLE,    /**Enable (value 1/0). */
+    ECMC_SCOPE_CMD_TRIGG,     /**Software trigger. */
+    ECMC_SCOPE_CMD_ARM,       /**Arm (value 1 = SINGLE, 0 = leave SINGLE, -1 = keep mode). */
+    ECMC_SCOPE_CMD_MODE,      /**Acquisition mode (value ECMC_SCOPE_MODE_*). */
+    ECMC_SCOPE_CMD_FREEZE,    /**Freeze flight recorder. */
+} ecmcScopeCmdType;
+
+typedef struct {
+  int cmd;    /**ecmcScopeCmdType */
+  int value;
+} ecmcScopeCmd;
+
+/** Bounded lock free single producer single consumer queue of control
+ *  commands. The consumer (rt) drains the queue at the start of a cycle so
+ *  control changes take effect on cycle boundaries.
+ *  Only plc functions push (the producer also runs in the rt thread). Asyn
+ *  writes do not use the queue (ecmc has no asyn write callback), they land
+ *  in request cells of the scope, see ecmcScope.h.
+*/
+class ecmcScopeCmdQueue {
+ public:
+  ecmcScopeCmdQueue();
+  ~ecmcScopeCmdQueue();
+
+  // Producer. Returns false if queue is full.
+  bool                  push(int cmd, int value);
+  // Consumer. Returns false if queue is empty.
+  bool                  pop(ecmcScopeCmd *cmd);
+
+ private:
+  ecmcScopeCmd          buffer_[ECMC_SCOPE_CMD_QUEUE_SIZE];
+  size_t                head_;   // Written by producer only
+  char                  pad_[ECMC_SCOPE_CMD_QUEUE_PAD];
+  size_t                tail_;   // Written by consumer only
+};
+
+#endif  /* ECMC_SCOPE_CMD_QUEUE_H_ */
@@ -0,0 +1,316 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeCodec.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+*  The inner loops (prediction, zigzag and width reduction) work on one
+*  block at a time and each output element only depends on its own input
+*  elements, so a block never waits for the previous element of the block.
+*
+\*************************************************************************/
+
+#include <string.h>
+#include "ecmcScopeCodec.h"
+
+#define ECMC_SCOPE_CODEC_HEADER_BYTES sizeof(ecmcScopeCodecHeader)
+
+static inline void storeLE64(uint8_t *dst, uint64_t value, size_t bytes) {
+  for(size_t i = 0; i < bytes; ++i) {
+    dst[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+// Load up to 8 bytes (zero padded if end of buffer)
+static inline uint64_t loadLE64(const uint8_t *src, const uint8_t *end) {
+  uint64_t value = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if(end - src >= 8) {
+    memcpy(&value, src, 8);
+    return value;
+  }
+#endif
+  size_t   bytes = (size_t)(end - src) < 8 ? (size_t)(end - src) : 8;
+  for(size_t i = 0; i < bytes; ++i) {
+    value |= ((uint64_t)src[i]) << (8 * i);
+  }
+  return value;
+}
+
+static inline uint64_t zigzag(uint64_t residual) {
+  return (residual << 1) ^ (uint64_t)(((int64_t)residual) >> 63);
+}
+
+static inline uint64_t unzigzag(uint64_t value) {
+  return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+template <typename T>
+static size_t encodeBlocks(const uint8_t *src,
+                           size_t         elements,
+                           int            order,
+                           uint8_t       *dst,
+                           size_t         dstBytes) {
+  const T *data  = (const T*)src;
+  uint64_t values[ECMC_SCOPE_CODEC_BLOCK_SIZE + 2];
+  uint64_t residuals[ECMC_SCOPE_CODEC_BLOCK_SIZE];
+  uint64_t prev1 = 0;
+  uint64_t prev2 = 0;
+  size_t   pos   = 0;
+
+  for(size_t block = 0; block < elements; block += ECMC_SCOPE_CODEC_BLOCK_SIZE) {
+    size_t count = elements - block;
+    if(count > ECMC_SCOPE_CODEC_BLOCK_SIZE) {
+      count = ECMC_SCOPE_CODEC_BLOCK_SIZE;
+    }
+
+    // Sign/zero extend to 64 bit (wrap around arithmetics from here)
+    values[0] = prev2;
+    values[1] = prev1;
+    for(size_t i = 0; i < count; ++i) {
+      values[i + 2] = (uint64_t)(int64_t)data[block + i];
+    }
+
+    uint64_t orAll = 0;
+    if(order == ECMC_SCOPE_CODEC_DELTA) {
+      for(size_t i = 0; i < count; ++i) {
+        residuals[i] = zigzag(values[i + 2] - values[i + 1]);
+        orAll       |= residuals[i];
+      }
+    }
+    else {
+      for(size_t i = 0; i < count; ++i) {
+        residuals[i] = zigzag(values[i + 2] - 2 * values[i + 1] + values[i]);
+        orAll       |= residuals[i];
+      }
+    }
+    prev2 = values[count];
+    prev1 = values[count + 1];
+
+    unsigned int width = orAll ? 64 - __builtin_clzll(orAll) : 0;
+    size_t bytes = 1 + (count * width + 7) / 8;
+    if(pos + bytes > dstBytes) {
+      return 0;  // Does not pay off
+    }
+
+    dst[pos++] = (uint8_t)width;
+    if(width == 0) {
+      continue;
+    }
+
+    uint64_t     acc  = 0;
+    unsigned int bits = 0;
+    for(size_t i = 0; i < count; ++i) {
+      acc  |= residuals[i] << bits;
+      bits += width;
+      if(bits >= 64) {
+        storeLE64(&dst[pos], acc, 8);
+        pos  += 8;
+        bits -= 64;
+        acc   = bits ? residuals[i] >> (width - bits) : 0;
+      }
+    }
+    if(bits) {
+      storeLE64(&dst[pos], acc, (bits + 7) / 8);
+      pos += (bits + 7) / 8;
+    }
+  }
+  return pos;
+}
+
+template <typename T>
+static int decodeBlocks(const uint8_t *src,
+                        size_t         srcBytes,
+                        size_t         elements,
+                        int            order,
+                        uint8_t       *dst) {
+  T             *data  = (T*)dst;
+  const uint8_t *end   = src + srcBytes;
+  const uint8_t *pos   = src;
+  uint64_t       prev1 = 0;
+  uint64_t       prev2 = 0;
+
+  for(size_t block = 0; block < elements; block += ECMC_SCOPE_CODEC_BLOCK_SIZE) {
+    size_t count = elements - block;
+    if(count > ECMC_SCOPE_CODEC_BLOCK_SIZE) {
+      count = ECMC_SCOPE_CODEC_BLOCK_SIZE;
+    }
+    if(pos >= end) {
+      return 1;
+    }
+
+    unsigned int width = *pos++;
+    size_t bytes = (count * width + 7) / 8;
+    if(width > 64 || (size_t)(end - pos) < bytes) {
+      return 1;
+    }
+
+    // Unpack block (no dependencies between elements)
+    uint64_t residuals[ECMC_SCOPE_CODEC_BLOCK_SIZE];
+    if(width == 0) {
+      memset(residuals, 0, sizeof(residuals));
+    }
+    else {
+      uint64_t mask   = width == 64 ? ~(uint64_t)0 : (((uint64_t)1) << width) - 1;
+      size_t   bitPos = 0;
+      for(size_t i = 0; i < count; ++i) {
+        const uint8_t *p     = pos + (bitPos >> 3);
+        unsigned int   shift = bitPos & 7;
+        uint64_t       value = loadLE64(p, end) >> shift;
+        if(shift + width > 64) {
+          value |= loadLE64(p + 8, end) << (64 - shift);
+        }
+        residuals[i] = unzigzag(value & mask);
+        bitPos      += width;
+      }
+    }
+
+    // Integrate prediction
+    if(order == ECMC_SCOPE_CODEC_DELTA) {
+      for(size_t i = 0; i < count; ++i) {
+        prev1 += residuals[i];
+        data[block + i] = (T)prev1;
+      }
+    }
+    else {
+      for(size_t i = 0; i < count; ++i) {
+        uint64_t current = 2 * prev1 - prev2 + residuals[i];
+        data[block + i]  = (T)current;
+        prev2 = prev1;
+        prev1 = current;
+      }
+    }
+    pos += bytes;
+  }
+  return 0;
+}
+
+size_t ecmcScopeCodecMaxBytes(size_t elements, size_t elementSize) {
+  return ECMC_SCOPE_CODEC_HEADER_BYTES + elements * elementSize;
+}
+
+size_t ecmcScopeCodecEncode(const uint8_t *src,
+                            size_t         elements,
+                            size_t         elementSize,
+                            int            isSigned,
+                            int            codec,
+                            uint8_t       *dst,
+                            size_t         dstBytes) {
+
+  if(!src || !dst || elements > UINT32_MAX ||
+     dstBytes < ecmcScopeCodecMaxBytes(elements, elementSize)) {
+    return 0;
+  }
+
+  ecmcScopeCodecHeader header;
+  header.magic       = ECMC_SCOPE_CODEC_MAGIC;
+  header.version     = ECMC_SCOPE_CODEC_VERSION;
+  header.codec       = (uint8_t)codec;
+  header.elementSize = (uint8_t)elementSize;
+  header.isSigned    = (uint8_t)(isSigned ? 1 : 0);
+  header.elements    = (uint32_t)elements;
+
+  uint8_t *payload      = dst + ECMC_SCOPE_CODEC_HEADER_BYTES;
+  size_t   payloadMax   = elements * elementSize;
+  size_t   payloadBytes = 0;
+
+  if(codec == ECMC_SCOPE_CODEC_DELTA || codec == ECMC_SCOPE_CODEC_DELTA2) {
+    switch(elementSize) {
+      case 1:
+        payloadBytes = isSigned ?
+          encodeBlocks<int8_t>(src, elements, codec, payload, payloadMax) :
+          encodeBlocks<uint8_t>(src, elements, codec, payload, payloadMax);
+        break;
+      case 2:
+        payloadBytes = isSigned ?
+          encodeBlocks<int16_t>(src, elements, codec, payload, payloadMax) :
+          encodeBlocks<uint16_t>(src, elements, codec, payload, payloadMax);
+        break;
+      case 4:
+        payloadBytes = isSigned ?
+          encodeBlocks<int32_t>(src, elements, codec, payload, payloadMax) :
+          encodeBlocks<uint32_t>(src, elements, codec, payload, payloadMax);
+        break;
+      case 8:
+        payloadBytes = isSigned ?
+          encodeBlocks<int64_t>(src, elements, codec, payload, payloadMax) :
+          encodeBlocks<uint64_t>(src, elements, codec, payload, payloadMax);
+        break;
+      default:
+        return 0;
+    }
+  }
+
+  // Store raw if not compressible (or codec raw)
+  if(payloadBytes == 0 && elements > 0) {
+    header.codec = ECMC_SCOPE_CODEC_RAW;
+    memcpy(payload, src, payloadMax);
+    payloadBytes = payloadMax;
+  }
+
+  header.payloadBytes = (uint32_t)payloadBytes;
+  memcpy(dst, &header, ECMC_SCOPE_CODEC_HEADER_BYTES);
+  return ECMC_SCOPE_CODEC_HEADER_BYTES + payloadBytes;
+}
+
+int ecmcScopeCodecDecode(const uint8_t *src,
+                         size_t         srcBytes,
+                         uint8_t       *dst,
+                         size_t         dstBytes,
+                         size_t        *elements) {
+
+  ecmcScopeCodecHeader header;
+  if(!src || !dst || srcBytes < ECMC_SCOPE_CODEC_HEADER_BYTES) {
+    return 1;
+  }
+
+  memcpy(&header, src, ECMC_SCOPE_CODEC_HEADER_BYTES);
+  if(header.magic != ECMC_SCOPE_CODEC_MAGIC ||
+     header.version != ECMC_SCOPE_CODEC_VERSION ||
+     header.payloadBytes > srcBytes - ECMC_SCOPE_CODEC_HEADER_BYTES ||
+     (size_t)header.elements * header.elementSize > dstBytes) {
+    return 1;
+  }
+
+  const uint8_t *payload = src + ECMC_SCOPE_CODEC_HEADER_BYTES;
+  int error = 0;
+
+  switch(header.codec) {
+    case ECMC_SCOPE_CODEC_RAW:
+      if(header.payloadBytes != (size_t)header.elements * header.elementSize) {
+        return 1;
+      }
+      memcpy(dst, payload, header.payloadBytes);
+      break;
+    case ECMC_SCOPE_CODEC_DELTA:
+    case ECMC_SCOPE_CODEC_DELTA2:
+      switch(header.elementSize) {
+        case 1:
+          error = decodeBlocks<uint8_t>(payload, header.payloadBytes, header.elements, header.codec, dst);
+          break;
+        case 2:
+          error = decodeBlocks<uint16_t>(payload, header.payloadBytes, header.elements, header.codec, dst);
+          break;
+        case 4:
+          error = decodeBlocks<uint32_t>(payload, header.payloadBytes, header.elements, header.codec, dst);
+          break;
+        case 8:
+          error = decodeBlocks<uint64_t>(payload, header.payloadBytes, header.elements, header.codec, dst);
+          break;
+        default:
+          return 1;
+      }
+      break;
+    default:
+      return 1;
+  }
+
+  if(elements) {
+    *elements = header.elements;
+  }
+  return error;
+}
@@ -0,0 +1,95 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeCodec.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+*  Lossless codec for scope waveforms (integer data types).
+*  Samples are predicted (delta or second order delta), the residuals are
+*  zigzag encoded and bit packed in blocks of ECMC_SCOPE_CODEC_BLOCK_SIZE
+*  elements (one width byte per block).
+*  No ecmc dependencies. Client side decoders (c header and python) are
+*  in tools/codec.
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_CODEC_H_
+#define ECMC_SCOPE_CODEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ECMC_SCOPE_CODEC_MAGIC      0x43444353  /* "SCDC" */
+#define ECMC_SCOPE_CODEC_VERSION    1
+#define ECMC_SCOPE_CODEC_BLOCK_SIZE 64
+
+typedef enum {
+  ECMC_SCOPE_CODEC_RAW    = 0,  /**Uncompressed copy of data. */
+  ECMC_SCOPE_CODEC_DELTA  = 1,  /**First order prediction (x[n]-x[n-1]). */
+  ECMC_SCOPE_CODEC_DELTA2 = 2,  /**Second order prediction (x[n]-2x[n-1]+x[n-2]). */
+} ecmcScopeCodecType;
+
+/** Header in front of all encoded data (little endian, 16 bytes)*/
+typedef struct {
+  uint32_t magic;           /**ECMC_SCOPE_CODEC_MAGIC */
+  uint8_t  version;         /**ECMC_SCOPE_CODEC_VERSION */
+  uint8_t  codec;           /**ecmcScopeCodecType */
+  uint8_t  elementSize;     /**Bytes per element (1,2,4,8) */
+  uint8_t  isSigned;        /**1 if signed integer data */
+  uint32_t elements;        /**Element count */
+  uint32_t payloadBytes;    /**Bytes after header */
+} ecmcScopeCodecHeader;
+
+# ifdef __cplusplus
+extern "C" {
+# endif  // ifdef __cplusplus
+
+/** \brief Max bytes needed for encoding of elements\n
+ *
+ *  Encoder falls back to ECMC_SCOPE_CODEC_RAW if compression does not pay off\n
+ *  so output is never bigger than header + raw data.\n
+ */
+size_t ecmcScopeCodecMaxBytes(size_t elements, size_t elementSize);
+
+/** \brief Encode data\n
+ *
+ *  \param[in] src Source data.\n
+ *  \param[in] elements Element count.\n
+ *  \param[in] elementSize Bytes per element (1,2,4,8).\n
+ *  \param[in] isSigned Data is signed integer.\n
+ *  \param[in] codec Codec to use (ecmcScopeCodecType).\n
+ *  \param[out] dst Destination buffer.\n
+ *  \param[in] dstBytes Size of destination buffer.\n
+ *  \return bytes written to dst (including header) or 0 if error.\n
+ */
+size_t ecmcScopeCodecEncode(const uint8_t *src,
+                            size_t         elements,
+                            size_t         elementSize,
+                            int            isSigned,
+                            int            codec,
+                            uint8_t       *dst,
+                            size_t         dstBytes);
+
+/** \brief Decode data\n
+ *
+ *  \param[in] src Encoded data (including header).\n
+ *  \param[in] srcBytes Bytes of encoded data.\n
+ *  \param[out] dst Destination buffer.\n
+ *  \param[in] dstBytes Size of destination buffer.\n
+ *  \param[out] elements Decoded element count.\n
+ *  \return 0 if success or otherwise an error code.\n
+ */
+int ecmcScopeCodecDecode(const uint8_t *src,
+                         size_t         srcBytes,
+                         uint8_t       *dst,
+                         size_t         dstBytes,
+                         size_t        *elements);
+
+# ifdef __cplusplus
+}
+# endif  // ifdef __cplusplus
+
+#endif  /* ECMC_SCOPE_CODEC_H_ */
@@ -21,6 +21,138 @@
 #define ECMC_PLUGIN_TRIGG_OPTION_CMD           "TRIGG="
 #define ECMC_PLUGIN_RESULT_ELEMENTS_OPTION_CMD "RESULT_ELEMENTS="
 #define ECMC_PLUGIN_ENABLE_OPTION_CMD          "ENABLE="
+#define ECMC_PLUGIN_COMPRESS_OPTION_CMD        "COMPRESS="
+#define ECMC_PLUGIN_MODE_OPTION_CMD            "MODE="
+#define ECMC_PLUGIN_AUTO_TIMEOUT_OPTION_CMD    "AUTO_TIMEOUT_MS="
+#define ECMC_PLUGIN_ROLL_CYCLES_OPTION_CMD     "ROLL_CYCLES="
+#define ECMC_PLUGIN_TRIGG_LOGIC_OPTION_CMD     "TRIGG_LOGIC="
+#define ECMC_PLUGIN_TRIGG_WINDOW_OPTION_CMD    "TRIGG_WINDOW_NS="
+#define ECMC_PLUGIN_TRIGG_TIMEOUT_OPTION_CMD   "TRIGG_SEQ_TIMEOUT_NS="
+#define ECMC_PLUGIN_TRIGG_HOLDOFF_OPTION_CMD   "TRIGG_HOLDOFF_NS="
+#define ECMC_PLUGIN_TRIGG_PRESCALE_OPTION_CMD  "TRIGG_PRESCALE="
+#define ECMC_PLUGIN_TRIGG_DELAY_OPTION_CMD     "TRIGG_DELAY="
+#define ECMC_PLUGIN_TRIGG_TYPE_OPTION_CMD      "TRIGG_TYPE="
+#define ECMC_PLUGIN_TRIGG_LEVEL_OPTION_CMD     "TRIGG_LEVEL="
+#define ECMC_PLUGIN_GAP_POLICY_OPTION_CMD      "GAP_POLICY="
+#define ECMC_PLUGIN_GAP_FILL_VALUE_OPTION_CMD  "GAP_FILL_VALUE="
+#define ECMC_PLUGIN_ETS_FACTOR_OPTION_CMD      "ETS_FACTOR="
+#define ECMC_PLUGIN_ETS_CAPTURES_OPTION_CMD    "ETS_CAPTURES="
+#define ECMC_PLUGIN_EXEC_CYCLES_OPTION_CMD     "EXEC_CYCLES="
+#define ECMC_PLUGIN_PERSIST_BINS_OPTION_CMD    "PERSIST_BINS="
+#define ECMC_PLUGIN_PERSIST_MIN_OPTION_CMD     "PERSIST_MIN="
+#define ECMC_PLUGIN_PERSIST_MAX_OPTION_CMD     "PERSIST_MAX="
+#define ECMC_PLUGIN_PERSIST_DECAY_OPTION_CMD   "PERSIST_DECAY="
+#define ECMC_PLUGIN_PERSIST_PUBLISH_OPTION_CMD "PERSIST_PUBLISH_MS="
+#define ECMC_PLUGIN_RECORDER_CAPTURES_OPTION_CMD     "RECORDER_CAPTURES="
+#define ECMC_PLUGIN_RECORDER_HISTORY_OPTION_CMD      "RECORDER_HISTORY_CYCLES="
+#define ECMC_PLUGIN_RECORDER_FREEZE_ERROR_OPTION_CMD "RECORDER_FREEZE_ON_ERROR="
+#define ECMC_PLUGIN_VIEW_POINTS_OPTION_CMD     "VIEW_POINTS="
+#define ECMC_PLUGIN_CHUNK_ELEMENTS_OPTION_CMD  "CHUNK_ELEMENTS="
+#define ECMC_PLUGIN_CONTEXT_OPTION_CMD         "CONTEXT="
+#define ECMC_PLUGIN_CONFIG_FILE_OPTION_CMD     "CONFIG_FILE="
+#define ECMC_PLUGIN_REPLAY_FILE_OPTION_CMD     "REPLAY_FILE="
+#define ECMC_PLUGIN_REPLAY_OUTPUT_OPTION_CMD   "REPLAY_OUTPUT="
+#define ECMC_PLUGIN_MASK_OPTION_CMD            "MASK="
+#define ECMC_PLUGIN_MASK_FREEZE_OPTION_CMD     "MASK_FREEZE="
+#define ECMC_PLUGIN_STATS_OPTION_CMD           "STATS="
+
+// Mode options
+#define ECMC_PLUGIN_MODE_NORMAL_OPTION         "NORMAL"
+#define ECMC_PLUGIN_MODE_SINGLE_OPTION         "SINGLE"
+#define ECMC_PLUGIN_MODE_AUTO_OPTION           "AUTO"
+#define ECMC_PLUGIN_MODE_ROLL_OPTION           "ROLL"
+
+// Trigger delay unit (suffix of TRIGG_DELAY value, defaults to NS)
+#define ECMC_PLUGIN_TRIGG_DELAY_NS_OPTION      "NS"
+#define ECMC_PLUGIN_TRIGG_DELAY_SAMPLES_OPTION "SAMPLES"
+
+// Gap policy options
+#define ECMC_PLUGIN_GAP_POLICY_FLAG_OPTION     "FLAG"
+#define ECMC_PLUGIN_GAP_POLICY_FILL_OPTION     "FILL"
+#define ECMC_PLUGIN_GAP_POLICY_ABORT_OPTION    "ABORT"
+
+// Trigger logic options (several trigger sources separated by ',' in TRIGG)
+#define ECMC_PLUGIN_TRIGG_LOGIC_OR_OPTION      "OR"
+#define ECMC_PLUGIN_TRIGG_LOGIC_AND_OPTION     "AND"
+#define ECMC_PLUGIN_TRIGG_LOGIC_SEQ_OPTION     "SEQ"
+#define ECMC_PLUGIN_TRIGG_SOURCE_SEPARATOR     ','
+
+// Trigger type options (LATCH: timestamp, others: value of any data item)
+#define ECMC_PLUGIN_TRIGG_TYPE_LATCH_OPTION    "LATCH"
+#define ECMC_PLUGIN_TRIGG_TYPE_CHANGE_OPTION   "CHANGE"
+#define ECMC_PLUGIN_TRIGG_TYPE_RISING_OPTION   "RISING"
+#define ECMC_PLUGIN_TRIGG_TYPE_FALLING_OPTION  "FALLING"
+#define ECMC_PLUGIN_TRIGG_TYPE_CROSS_OPTION    "CROSS"
+
+// Logic analyzer mode (several bit sources separated by ',' in SOURCE)
+#define ECMC_PLUGIN_SOURCE_SEPARATOR           ','
+
+// Context items snapshot at trigger (separated by ',' in CONTEXT)
+#define ECMC_PLUGIN_CONTEXT_SEPARATOR          ','
+#define ECMC_SCOPE_CONTEXT_MAX_ITEMS           16
+
+// Acquisition modes
+#define ECMC_SCOPE_MODE_NORMAL       0   // Re-arm after each capture
+#define ECMC_SCOPE_MODE_SINGLE       1   // One capture then wait for re-arm
+#define ECMC_SCOPE_MODE_AUTO         2   // Free run capture if no trigger within timeout
+#define ECMC_SCOPE_MODE_ROLL         3   // Publish sliding window every N cycles
+
+// Gap policy (lost or repeated ethercat frames during capture)
+#define ECMC_SCOPE_GAP_FLAG          0   // Only flag capture as invalid
+#define ECMC_SCOPE_GAP_FILL          1   // Fill lost frames with GAP_FILL_VALUE (skip repeated)
+#define ECMC_SCOPE_GAP_ABORT         2   // Abort capture
+
+// Status (scope_get_status())
+#define ECMC_SCOPE_STATUS_DISABLED   0   // Disabled
+#define ECMC_SCOPE_STATUS_WAIT_TRIGG 1   // Armed, waiting for trigger
+#define ECMC_SCOPE_STATUS_COLLECT    2   // Collecting data
+#define ECMC_SCOPE_STATUS_DONE       3   // Single shot done, waiting for re-arm
+
+#define ECMC_PLUGIN_SCOPE_ERROR_CODE      1   // Error return of wrapper and plc commands
+#define ECMC_PLUGIN_SCOPE_PLC_ERROR_VALUE -1  // Error return of scope_get_status/count (stat/value return NaN)
+
+// Statistics of last capture (scope_get_stat())
+#define ECMC_SCOPE_STAT_MIN          0
+#define ECMC_SCOPE_STAT_MAX          1
+#define ECMC_SCOPE_STAT_MEAN         2
+#define ECMC_SCOPE_STAT_RMS          3
+#define ECMC_SCOPE_STAT_COUNT        4
+
+// Flight recorder frozen by failed mask test (recorder error)
+#define ECMC_SCOPE_RECORDER_FREEZE_MASK -1
+
+// Trigger outcomes (index of per reason counters and outcome in trigger log)
+#define ECMC_SCOPE_TRIGG_ACCEPTED       0   // Capture started
+#define ECMC_SCOPE_TRIGG_DROP_OLD       1   // More than two ethercat cycles ago
+#define ECMC_SCOPE_TRIGG_DROP_FUTURE    2   // Newer than NEXT_TIME (dc out of sync)
+#define ECMC_SCOPE_TRIGG_DROP_BUSY      3   // Latch during collect (or last chunks publishing)
+#define ECMC_SCOPE_TRIGG_DROP_BUS       4   // Ethercat bus not started
+#define ECMC_SCOPE_TRIGG_DROP_DISABLED  5   // Scope disabled
+#define ECMC_SCOPE_TRIGG_DROP_NOT_ARMED 6   // Single shot done or roll mode
+#define ECMC_SCOPE_TRIGG_DROP_HOLDOFF   7   // Within holdoff
+#define ECMC_SCOPE_TRIGG_DROP_PRESCALE  8   // Prescaling
+#define ECMC_SCOPE_TRIGG_DROP_GAP       9   // Last scan not previous cycle (GAP_POLICY=ABORT)
+#define ECMC_SCOPE_TRIGG_OUTCOME_COUNT  10
+
+// Trigger log (ring of last trigger decisions, published oldest first)
+// Entry: trigg time low, trigg time high, nexttime low, nexttime high,
+//        offset nexttime - trigg [ns], outcome
+#define ECMC_SCOPE_TRIGG_LOG_ENTRIES    64
+#define ECMC_SCOPE_TRIGG_LOG_WORDS      6
+
+// Defaults for modes
+#define ECMC_PLUGIN_DEFAULT_AUTO_TIMEOUT_MS 1000
+#define ECMC_PLUGIN_DEFAULT_ROLL_CYCLES     100
+
+// Defaults for equivalent time sampling
+#define ECMC_PLUGIN_DEFAULT_ETS_CAPTURES    100
+
+// Defaults for persistence image
+#define ECMC_PLUGIN_DEFAULT_PERSIST_DECAY      1.0
+#define ECMC_PLUGIN_DEFAULT_PERSIST_PUBLISH_MS 1000
+
+// Defaults for trigger engine
+#define ECMC_PLUGIN_DEFAULT_TRIGG_SEQ_TIMEOUT_NS 1000000000
 
 // Default size (must be n²)
 #define ECMC_PLUGIN_DEFAULT_BUFFER_SIZE 4096
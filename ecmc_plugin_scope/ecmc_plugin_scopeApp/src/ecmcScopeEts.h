@@ -0,0 +1,54 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeEts.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_ETS_H_
+#define ECMC_SCOPE_ETS_H_
+
+#include <stdexcept>
+#include "ecmcDataItem.h"
+#include "inttypes.h"
+
+/** Equivalent time sampling
+ *  Captures of a repetitive signal are folded into a grid that is "factor"
+ *  times finer than the source sample period. The bin is selected by the
+ *  sub sample phase of the trigger (time from trigger to first sample of
+ *  the capture divided by the sample period, 0..1).
+ *  The accumulator is stored phase major (one row of "elements" per phase
+ *  bin) so folding of a capture is a contiguous add of one row.
+ *  This object can throw:
+ *    - bad_alloc
+ *    - invalid_argument
+*/
+class ecmcScopeEts {
+ public:
+  ecmcScopeEts(size_t         elements,
+               int            factor,
+               ecmcEcDataType dt);
+  ~ecmcScopeEts();
+
+  // Fold capture (elements of dt) with trigger phase [0..1[
+  void                  add(const uint8_t *data, double phase);
+  // Captures folded since reset
+  int                   getCount();
+  // Mean of each bin, dst[k * factor + phase bin] (NaN if empty bin)
+  void                  reconstruct(double *dst);
+  void                  reset();
+
+ private:
+  size_t                elements_;
+  int                   factor_;
+  ecmcEcDataType        dt_;
+  double               *sum_;      // factor_ rows of elements_
+  int                  *binCount_; // captures per phase bin
+  int                   count_;
+};
+
+#endif  /* ECMC_SCOPE_ETS_H_ */
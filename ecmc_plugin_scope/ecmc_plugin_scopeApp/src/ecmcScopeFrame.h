@@ -0,0 +1,107 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeFrame.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+*  Layout of structured capture (asyn parameter "plugin.scope<index>.frame").
+*  One frame per capture: header directly followed by the result data (raw
+*  source data type) and the context values (float64, snapshot at trigger,
+*  starting at the first 8 byte boundary after the data). Header, data and
+*  context share one buffer so a client always gets data and metadata of
+*  the same capture in one update.
+*  No ecmc dependencies so the file can be used by clients.
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_FRAME_H_
+#define ECMC_SCOPE_FRAME_H_
+
+#include <stdint.h>
+
+#define ECMC_SCOPE_FRAME_MAGIC       0x52464353  /* "SCFR" */
+#define ECMC_SCOPE_FRAME_VERSION     2
+
+// Frame flags
+#define ECMC_SCOPE_FRAME_VALID       0x01  /**No lost/repeated frames in capture */
+#define ECMC_SCOPE_FRAME_SOFT_TRIGG  0x02  /**Software trigger (or AUTO timeout) */
+#define ECMC_SCOPE_FRAME_ROLL        0x04  /**ROLL mode (no trigger) */
+
+/** Header in front of data (little endian, 64 bytes)*/
+typedef struct {
+  uint32_t magic;                /**ECMC_SCOPE_FRAME_MAGIC */
+  uint16_t version;              /**ECMC_SCOPE_FRAME_VERSION */
+  uint16_t headerBytes;          /**Bytes before data */
+  uint32_t flags;                /**ECMC_SCOPE_FRAME_* */
+  uint32_t gaps;                 /**Lost/repeated ethercat frames in capture */
+  uint64_t triggTime;            /**Dc time of trigger [ns] (64bit unwrapped) */
+  double   samplePeriodNs;       /**Tracked sample period [ns] */
+  double   firstSampleOffsetNs;  /**Time of first sample relative trigger [ns] */
+  uint32_t triggerCounter;       /**Capture counter (same as "count") */
+  uint32_t elements;             /**Element count of data */
+  uint8_t  dataType;             /**ecmcEcDataType of data */
+  uint8_t  elementSize;          /**Bytes per element */
+  uint8_t  contextCount;         /**Context values after data (version >= 2) */
+  uint8_t  reserved[13];
+} ecmcScopeFrameHeader;
+
+#define ECMC_SCOPE_CHUNK_MAGIC       0x48434353  /* "SCCH" */
+#define ECMC_SCOPE_CHUNK_VERSION     1
+
+// Chunk flags
+#define ECMC_SCOPE_CHUNK_FIRST       0x01  /**First chunk of capture */
+#define ECMC_SCOPE_CHUNK_LAST        0x02  /**Last chunk of capture */
+#define ECMC_SCOPE_CHUNK_VALID       0x04  /**Last chunk: no lost/repeated frames in capture */
+
+/** Header in front of chunk data (little endian, 48 bytes).
+ *  Large capture mode: the capture is published in chunks while collecting.
+*/
+typedef struct {
+  uint32_t magic;                /**ECMC_SCOPE_CHUNK_MAGIC */
+  uint16_t version;              /**ECMC_SCOPE_CHUNK_VERSION */
+  uint16_t headerBytes;          /**Bytes before data */
+  uint32_t flags;                /**ECMC_SCOPE_CHUNK_* */
+  uint32_t sequence;             /**Chunk sequence number (all captures, gap = lost chunk) */
+  uint32_t triggerCounter;       /**Capture counter (same as "count" after capture) */
+  uint32_t chunkIndex;           /**Chunk index in capture */
+  uint64_t firstElement;         /**Index of first element in capture */
+  uint32_t elements;             /**Element count of data */
+  uint8_t  dataType;             /**ecmcEcDataType of data */
+  uint8_t  elementSize;          /**Bytes per element */
+  uint8_t  reserved[2];
+  uint64_t triggTime;            /**Dc time of trigger [ns] (64bit unwrapped) */
+} ecmcScopeChunkHeader;
+
+#define ECMC_SCOPE_REPLAY_MAGIC      0x50455253  /* "SREP" */
+#define ECMC_SCOPE_REPLAY_VERSION    1
+#define ECMC_SCOPE_REPLAY_MAX_TRIGG  8
+
+/** Header of replay file (little endian, 64 bytes).
+ *  Recorded cycles for offline reprocessing (REPLAY_FILE). The header is
+ *  followed by one record per ethercat cycle:
+ *    uint64_t nexttime;            NEXT_TIME of source
+ *    uint64_t trigg[triggCount];   Trigger values (timestamps or values)
+ *    uint8_t  scan[scanBytes];     Source data, padded to 8 bytes
+ *  The output file (REPLAY_OUTPUT) is a sequence of structured captures
+ *  (ecmcScopeFrameHeader followed by data, see above).
+*/
+typedef struct {
+  uint32_t magic;                /**ECMC_SCOPE_REPLAY_MAGIC */
+  uint16_t version;              /**ECMC_SCOPE_REPLAY_VERSION */
+  uint16_t headerBytes;          /**Bytes before first record */
+  uint32_t scanBytes;            /**Source data per cycle */
+  uint32_t cycleNs;              /**Ethercat cycle time [ns] */
+  uint64_t records;              /**Recorded cycles */
+  uint8_t  dataType;             /**ecmcEcDataType of source data */
+  uint8_t  elementSize;          /**Bytes per source element */
+  uint8_t  nexttimeBits;         /**Bits of NEXT_TIME (32 or 64) */
+  uint8_t  triggCount;           /**Trigger values per record (1..8) */
+  uint8_t  triggBits;            /**Bits of trigger timestamps (32 or 64) */
+  uint8_t  triggDataType;        /**ecmcEcDataType of trigger values */
+  uint8_t  reserved[34];
+} ecmcScopeReplayHeader;
+
+#endif  /* ECMC_SCOPE_FRAME_H_ */
@@ -0,0 +1,197 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeHot.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+// Needed to get headers in ecmc right...
+#define ECMC_IS_PLUGIN
+
+#include <string.h>
+#include "ecmcScopeHot.h"
+#include "ecmcScopeTrigg.h"
+
+ecmcScopeHot::ecmcScopeHot(size_t scopes) {
+  count_         = scopes;
+  cycle_         = 0;
+  triggTotal_    = 0;
+  quiet_         = new uint8_t[count_];
+  wake_          = new uint8_t[count_];
+  run_           = new uint8_t[count_];
+  direct_        = new uint8_t[count_];
+  skipped_       = new uint32_t[count_];
+  nexttimeData_  = new const uint8_t*[count_];
+  nexttimeBytes_ = new size_t[count_];
+  timebase_      = new ecmcScopeTimebase*[count_];
+  triggFirst_    = new size_t[count_];
+  triggCount_    = new size_t[count_];
+  // Max trigger sources per scope
+  triggData_     = new const uint8_t*[count_ * ECMC_SCOPE_TRIGG_MAX_SOURCES];
+  triggBytes_    = new size_t[count_ * ECMC_SCOPE_TRIGG_MAX_SOURCES];
+  triggLast_     = new uint64_t[count_ * ECMC_SCOPE_TRIGG_MAX_SOURCES];
+  reqCount_      = new size_t[count_];
+  reqCell_       = new const int*[count_ * ECMC_SCOPE_HOT_MAX_REQUESTS];
+  reqSeen_       = new const int*[count_ * ECMC_SCOPE_HOT_MAX_REQUESTS];
+
+  memset(quiet_, 0, count_);
+  memset(wake_, 0, count_);
+  memset(run_, 1, count_);
+  memset(direct_, 0, count_);
+  memset(skipped_, 0, count_ * sizeof(uint32_t));
+  memset(nexttimeData_, 0, count_ * sizeof(uint8_t*));
+  memset(nexttimeBytes_, 0, count_ * sizeof(size_t));
+  memset(timebase_, 0, count_ * sizeof(ecmcScopeTimebase*));
+  memset(triggFirst_, 0, count_ * sizeof(size_t));
+  memset(triggCount_, 0, count_ * sizeof(size_t));
+  memset(triggData_, 0, count_ * ECMC_SCOPE_TRIGG_MAX_SOURCES * sizeof(uint8_t*));
+  memset(triggBytes_, 0, count_ * ECMC_SCOPE_TRIGG_MAX_SOURCES * sizeof(size_t));
+  memset(triggLast_, 0, count_ * ECMC_SCOPE_TRIGG_MAX_SOURCES * sizeof(uint64_t));
+  memset(reqCount_, 0, count_ * sizeof(size_t));
+  memset(reqCell_, 0, count_ * ECMC_SCOPE_HOT_MAX_REQUESTS * sizeof(int*));
+  memset(reqSeen_, 0, count_ * ECMC_SCOPE_HOT_MAX_REQUESTS * sizeof(int*));
+}
+
+ecmcScopeHot::~ecmcScopeHot() {
+  delete[] quiet_;
+  delete[] wake_;
+  delete[] run_;
+  delete[] direct_;
+  delete[] skipped_;
+  delete[] nexttimeData_;
+  delete[] nexttimeBytes_;
+  delete[] timebase_;
+  delete[] triggFirst_;
+  delete[] triggCount_;
+  delete[] triggData_;
+  delete[] triggBytes_;
+  delete[] triggLast_;
+  delete[] reqCount_;
+  delete[] reqCell_;
+  delete[] reqSeen_;
+}
+
+/** Must be called before addTrigg() of same index
+ *  (scopes are registered in index order).
+*/
+void ecmcScopeHot::setNexttime(size_t index,
+                               ecmcDataItemInfo *info,
+                               ecmcScopeTimebase *timebase) {
+  if(index >= count_) {
+    throw std::out_of_range("ERROR: Hot state index out of range.");
+  }
+  timebase_[index]   = timebase;
+  triggFirst_[index] = triggTotal_;
+  triggCount_[index] = 0;
+  direct_[index]     = info && info->data && info->dataPointerValid &&
+                       info->dataElementSize <= sizeof(uint64_t) && timebase;
+  if(direct_[index]) {
+    nexttimeData_[index]  = info->data;
+    nexttimeBytes_[index] = info->dataElementSize;
+  }
+}
+
+void ecmcScopeHot::addTrigg(size_t index, ecmcDataItemInfo *info) {
+  if(index >= count_ || triggCount_[index] >= ECMC_SCOPE_TRIGG_MAX_SOURCES) {
+    throw std::out_of_range("ERROR: Hot state index out of range.");
+  }
+  if(!info || !info->data || !info->dataPointerValid ||
+     info->dataElementSize > sizeof(uint64_t)) {
+    direct_[index] = 0;  // Always full execution
+    return;
+  }
+  size_t t = triggFirst_[index] + triggCount_[index];
+  triggData_[t]  = info->data;
+  triggBytes_[t] = info->dataElementSize;
+  triggLast_[t]  = readRaw(info->data, info->dataElementSize);
+  triggCount_[index]++;
+  triggTotal_++;
+}
+
+void ecmcScopeHot::addRequest(size_t index, const int *cell, const int *seen) {
+  if(index >= count_ || reqCount_[index] >= ECMC_SCOPE_HOT_MAX_REQUESTS) {
+    throw std::out_of_range("ERROR: Hot state index out of range.");
+  }
+  size_t r    = index * ECMC_SCOPE_HOT_MAX_REQUESTS + reqCount_[index];
+  reqCell_[r] = cell;
+  reqSeen_[r] = seen;
+  reqCount_[index]++;
+}
+
+uint8_t *ecmcScopeHot::getWakeCell(size_t index) {
+  if(index >= count_) {
+    throw std::out_of_range("ERROR: Hot state index out of range.");
+  }
+  return &wake_[index];
+}
+
+uint64_t ecmcScopeHot::readRaw(const uint8_t *data, size_t bytes) {
+  uint64_t value = 0;
+  memcpy(&value, data, bytes);
+  return value;
+}
+
+bool ecmcScopeHot::triggChanged(size_t index) {
+  size_t end     = triggFirst_[index] + triggCount_[index];
+  bool   changed = false;
+  for(size_t t = triggFirst_[index]; t < end; ++t) {
+    uint64_t value = readRaw(triggData_[t], triggBytes_[t]);
+    changed |= value != triggLast_[t];
+  }
+  return changed;
+}
+
+// Request cells are written by asyn (atomic load, see ecmcScope::drainCommands())
+bool ecmcScopeHot::requestChanged(size_t index) {
+  size_t first   = index * ECMC_SCOPE_HOT_MAX_REQUESTS;
+  size_t end     = first + reqCount_[index];
+  bool   changed = false;
+  for(size_t r = first; r < end; ++r) {
+    changed |= __atomic_load_n(reqCell_[r], __ATOMIC_ACQUIRE) != *reqSeen_[r];
+  }
+  return changed;
+}
+
+void ecmcScopeHot::scan() {
+  cycle_++;
+  for(size_t i = 0; i < count_; ++i) {
+    // Wake and service cycle (staggered over scopes)
+    if(!quiet_[i] || __atomic_load_n(&wake_[i], __ATOMIC_ACQUIRE) ||
+       (cycle_ + i) % ECMC_SCOPE_HOT_SERVICE_CYCLES == 0 || triggChanged(i) ||
+       requestChanged(i)) {
+      run_[i] = 1;
+      continue;
+    }
+    // Nothing happens in scope this cycle, keep timebase
+    timebase_[i]->update(readRaw(nexttimeData_[i], nexttimeBytes_[i]));
+    skipped_[i]++;
+    run_[i] = 0;
+  }
+}
+
+bool ecmcScopeHot::getRun(size_t index) {
+  return run_[index];
+}
+
+uint32_t ecmcScopeHot::startRun(size_t index) {
+  uint32_t skipped = skipped_[index];
+  skipped_[index]  = 0;
+  __atomic_store_n(&wake_[index], 0, __ATOMIC_RELEASE);
+  return skipped;
+}
+
+void ecmcScopeHot::setQuiet(size_t index, bool quiet) {
+  quiet_[index] = quiet && direct_[index];
+  if(!quiet_[index]) {
+    return;
+  }
+  size_t end = triggFirst_[index] + triggCount_[index];
+  for(size_t t = triggFirst_[index]; t < end; ++t) {
+    triggLast_[t] = readRaw(triggData_[t], triggBytes_[t]);
+  }
+}
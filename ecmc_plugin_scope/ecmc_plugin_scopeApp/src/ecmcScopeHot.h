@@ -0,0 +1,91 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeHot.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_HOT_H_
+#define ECMC_SCOPE_HOT_H_
+
+#include <stdexcept>
+#include "ecmcDataItem.h"
+#include "ecmcScopeTimebase.h"
+#include "inttypes.h"
+
+// Quiet scopes are executed at least every n:th cycle (staggered over scopes)
+#define ECMC_SCOPE_HOT_SERVICE_CYCLES 10
+// Max asyn request cells per scope
+#define ECMC_SCOPE_HOT_MAX_REQUESTS   8
+
+/** Per cycle hot state of all scopes (structure of arrays)
+ *  A scope is quiet when nothing can happen until one of its trigger
+ *  sources changes (waiting for trigger, single shot done or disabled).
+ *  Each cycle one tight loop compares the raw trigger values of the quiet
+ *  scopes and only tracks the timebase (NEXT_TIME) of the ones that did
+ *  not change. The full logic of a scope runs when a trigger source
+ *  changed, an asyn request cell differs from the value last applied by
+ *  the scope, a command was queued (wake) or once every
+ *  ECMC_SCOPE_HOT_SERVICE_CYCLES cycle (publishing).
+ *  This object can throw:
+ *    - bad_alloc
+ *    - out_of_range
+*/
+class ecmcScopeHot {
+ public:
+  explicit ecmcScopeHot(size_t scopes);
+  ~ecmcScopeHot();
+
+  // Registration (enter realtime)
+  void                  setNexttime(size_t index,
+                                    ecmcDataItemInfo *info,
+                                    ecmcScopeTimebase *timebase);
+  void                  addTrigg(size_t index, ecmcDataItemInfo *info);
+  // Asyn request cell: wake when *cell != *seen (seen owned by rt)
+  void                  addRequest(size_t index, const int *cell, const int *seen);
+  // Set to wake a quiet scope (queued commands)
+  uint8_t              *getWakeCell(size_t index);
+
+  // Once per cycle: decide which scopes need full execution
+  void                  scan();
+  bool                  getRun(size_t index);
+  // Full execution starts. Returns cycles skipped since last full execution.
+  uint32_t              startRun(size_t index);
+  // After full execution (trigger values are the reference when quiet)
+  void                  setQuiet(size_t index, bool quiet);
+
+ private:
+  bool                  triggChanged(size_t index);
+  bool                  requestChanged(size_t index);
+  static uint64_t       readRaw(const uint8_t *data, size_t bytes);
+
+  size_t                count_;
+  uint32_t              cycle_;
+  uint8_t              *quiet_;
+  uint8_t              *wake_;
+  uint8_t              *run_;
+  uint8_t              *direct_;          // All data pointers valid
+  uint32_t             *skipped_;
+  const uint8_t       **nexttimeData_;
+  size_t               *nexttimeBytes_;
+  ecmcScopeTimebase   **timebase_;
+
+  // Trigger sources of all scopes (scope i: triggFirst_[i] .. + triggCount_[i])
+  size_t               *triggFirst_;
+  size_t               *triggCount_;
+  const uint8_t       **triggData_;
+  size_t               *triggBytes_;
+  uint64_t             *triggLast_;
+  size_t                triggTotal_;
+
+  // Asyn request cells of all scopes (scope i: i * ECMC_SCOPE_HOT_MAX_REQUESTS + 0 .. reqCount_[i])
+  size_t               *reqCount_;
+  const int           **reqCell_;
+  const int           **reqSeen_;
+};
+
+#endif  /* ECMC_SCOPE_HOT_H_ */
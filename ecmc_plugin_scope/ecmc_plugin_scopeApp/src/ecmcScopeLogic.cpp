@@ -0,0 +1,205 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeLogic.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+*  Packing and unpacking loops handle one channel for all samples (shift and
+*  mask of a full row), so the inner loop has a fixed shift and mask and
+*  walks the samples with unit stride. With -O3 (Makefile) g++ vectorizes
+*  both loops, checked with -fopt-info-vec-optimized.
+*
+\*************************************************************************/
+
+// Needed to get headers in ecmc right...
+#define ECMC_IS_PLUGIN
+
+#include <string.h>
+#include "ecmcScopeLogic.h"
+
+template <typename T>
+static void packChannel(const uint8_t *raw,
+                        uint64_t      *words,
+                        size_t         samples,
+                        unsigned int   shift,
+                        uint64_t       mask) {
+  const T *data = (const T*)raw;
+  for(size_t i = 0; i < samples; ++i) {
+    words[i] |= ((uint64_t)data[i] & mask) << shift;
+  }
+}
+
+ecmcScopeLogic::ecmcScopeLogic() {
+  memset(items_,0,sizeof(items_));
+  memset(itemInfos_,0,sizeof(itemInfos_));
+  memset(shift_,0,sizeof(shift_));
+  memset(mask_,0,sizeof(mask_));
+  memset(&packedInfo_,0,sizeof(packedInfo_));
+  channelCount_    = 0;
+  bitCount_        = 0;
+  samplesPerCycle_ = 0;
+  raw_             = NULL;
+  rawBytes_        = 0;
+  packed_          = NULL;
+}
+
+ecmcScopeLogic::~ecmcScopeLogic() {
+  if(raw_) {
+    delete[] raw_;
+  }
+  if(packed_) {
+    delete[] packed_;
+  }
+}
+
+void ecmcScopeLogic::addChannel(ecmcDataItem *item) {
+  if(channelCount_ >= ECMC_SCOPE_LOGIC_MAX_CHANNELS) {
+    throw std::invalid_argument( "ERROR: Too many logic channels.");
+  }
+  if(!item) {
+    throw std::runtime_error( "ERROR: Logic channel dataitem NULL." );
+  }
+
+  ecmcDataItemInfo *info = item->getDataItemInfo();
+  if(!info) {
+    throw std::runtime_error( "ERROR: Logic channel dataitem info NULL." );
+  }
+
+  size_t bits = 0;
+  switch(info->dataType) {
+    case ECMC_EC_B1:
+      bits = 1;
+      break;
+    case ECMC_EC_B2:
+      bits = 2;
+      break;
+    case ECMC_EC_B3:
+      bits = 3;
+      break;
+    case ECMC_EC_B4:
+      bits = 4;
+      break;
+    case ECMC_EC_U8:
+    case ECMC_EC_S8:
+    case ECMC_EC_U16:
+    case ECMC_EC_S16:
+    case ECMC_EC_U32:
+    case ECMC_EC_S32:
+    case ECMC_EC_U64:
+    case ECMC_EC_S64:
+      bits = info->dataBitCount;
+      break;
+    default:
+      throw std::invalid_argument( "ERROR: Logic channel data type not supported.");
+  }
+
+  if(bits == 0 || bits > ECMC_SCOPE_LOGIC_MAX_CH_BITS) {
+    throw std::invalid_argument( "ERROR: Logic channel bit count out of range (1..8).");
+  }
+  if(bitCount_ + bits > ECMC_SCOPE_LOGIC_MAX_BITS) {
+    throw std::invalid_argument( "ERROR: Logic channels exceed 64 bits.");
+  }
+  if(info->dataElementSize != 1 && info->dataElementSize != 2 &&
+     info->dataElementSize != 4 && info->dataElementSize != 8) {
+    throw std::invalid_argument( "ERROR: Logic channel element size not supported.");
+  }
+
+  size_t samples = info->dataSize / info->dataElementSize;
+  if(channelCount_ > 0 && samples != samplesPerCycle_) {
+    throw std::invalid_argument( "ERROR: Logic channels must have the same number of samples per cycle.");
+  }
+
+  samplesPerCycle_        = samples;
+  items_[channelCount_]     = item;
+  itemInfos_[channelCount_] = info;
+  shift_[channelCount_]     = bitCount_;
+  mask_[channelCount_]      = (((uint64_t)1) << bits) - 1;
+  bitCount_              += bits;
+  if(info->dataSize > rawBytes_) {
+    rawBytes_ = info->dataSize;
+  }
+  channelCount_++;
+}
+
+void ecmcScopeLogic::init() {
+  if(channelCount_ == 0 || samplesPerCycle_ == 0) {
+    throw std::invalid_argument( "ERROR: No logic channels defined.");
+  }
+
+  raw_    = new uint8_t[rawBytes_];
+  packed_ = new uint64_t[samplesPerCycle_];
+  memset(raw_,0,rawBytes_);
+  memset(packed_,0,samplesPerCycle_ * sizeof(uint64_t));
+
+  packedInfo_.name             = itemInfos_[0]->name;
+  packedInfo_.data             = (uint8_t*)packed_;
+  packedInfo_.dataSize         = samplesPerCycle_ * sizeof(uint64_t);
+  packedInfo_.dataElementSize  = sizeof(uint64_t);
+  packedInfo_.dataBitCount     = 64;
+  packedInfo_.dataType         = ECMC_EC_U64;
+  packedInfo_.dataUpdateRateMs = itemInfos_[0]->dataUpdateRateMs;
+  packedInfo_.dataPointerValid = true;
+}
+
+size_t ecmcScopeLogic::getChannelCount() {
+  return channelCount_;
+}
+
+ecmcDataItemInfo* ecmcScopeLogic::getPackedInfo() {
+  return &packedInfo_;
+}
+
+void ecmcScopeLogic::pack() {
+  memset(packed_,0,samplesPerCycle_ * sizeof(uint64_t));
+
+  for(size_t ch = 0; ch < channelCount_; ++ch) {
+    if(items_[ch]->read(raw_, itemInfos_[ch]->dataSize)) {
+      throw std::runtime_error( "ERROR: Failed read logic channel." );
+    }
+    switch(itemInfos_[ch]->dataElementSize) {
+      case 1:
+        packChannel<uint8_t>(raw_, packed_, samplesPerCycle_, shift_[ch], mask_[ch]);
+        break;
+      case 2:
+        packChannel<uint16_t>(raw_, packed_, samplesPerCycle_, shift_[ch], mask_[ch]);
+        break;
+      case 4:
+        packChannel<uint32_t>(raw_, packed_, samplesPerCycle_, shift_[ch], mask_[ch]);
+        break;
+      case 8:
+        packChannel<uint64_t>(raw_, packed_, samplesPerCycle_, shift_[ch], mask_[ch]);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+void ecmcScopeLogic::unpack(const uint64_t *words, size_t samples, uint8_t *dst) {
+  for(size_t ch = 0; ch < channelCount_; ++ch) {
+    uint8_t      *row   = &dst[ch * samples];
+    unsigned int  shift = shift_[ch];
+    uint64_t      mask  = mask_[ch];
+    for(size_t i = 0; i < samples; ++i) {
+      row[i] = (uint8_t)((words[i] >> shift) & mask);
+    }
+  }
+}
+
+size_t ecmcScopeLogic::transitions(const uint64_t *words, size_t samples, int32_t *dst) {
+  size_t count = 0;
+  for(size_t i = 0; i < samples; ++i) {
+    if(i > 0 && words[i] == words[i - 1]) {
+      continue;
+    }
+    dst[count * ECMC_SCOPE_LOGIC_TRANS_WORDS]     = (int32_t)i;
+    dst[count * ECMC_SCOPE_LOGIC_TRANS_WORDS + 1] = (int32_t)(uint32_t)words[i];
+    dst[count * ECMC_SCOPE_LOGIC_TRANS_WORDS + 2] = (int32_t)(uint32_t)(words[i] >> 32);
+    count++;
+  }
+  return count;
+}
@@ -0,0 +1,66 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeLogic.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_LOGIC_H_
+#define ECMC_SCOPE_LOGIC_H_
+
+#include <stdexcept>
+#include "ecmcDataItem.h"
+#include "inttypes.h"
+
+#define ECMC_SCOPE_LOGIC_MAX_CHANNELS  64
+#define ECMC_SCOPE_LOGIC_MAX_BITS      64  // Total bits of all channels (one packed word)
+#define ECMC_SCOPE_LOGIC_MAX_CH_BITS   8   // Bits of one channel (unpacked to one byte)
+#define ECMC_SCOPE_LOGIC_TRANS_WORDS   3   // Transition: sample index, value low, value high
+
+/** Logic analyzer channels
+ *  Digital items (B1..B4 or small integers, scalars or oversampled arrays)
+ *  are packed into one 64 bit word per sample (channel 0 in lowest bits).
+ *  All channels must have the same number of samples per cycle.
+ *  The packed words of the current cycle are presented as a data item of
+ *  type ECMC_EC_U64 (getPackedInfo()) so the normal capture code can be used.
+ *  This object can throw:
+ *    - bad_alloc
+ *    - invalid_argument
+ *    - runtime_error
+*/
+class ecmcScopeLogic {
+ public:
+  ecmcScopeLogic();
+  ~ecmcScopeLogic();
+
+  void                  addChannel(ecmcDataItem *item);
+  // Allocate packed buffer (call after all channels are added)
+  void                  init();
+  size_t                getChannelCount();
+  ecmcDataItemInfo*     getPackedInfo();
+  // Read all channels and pack current cycle
+  void                  pack();
+  // Unpack words to one byte per sample, channel major (dst[channel * samples + sample])
+  void                  unpack(const uint64_t *words, size_t samples, uint8_t *dst);
+  // Transition list (first sample and each change). Returns number of transitions.
+  size_t                transitions(const uint64_t *words, size_t samples, int32_t *dst);
+
+ private:
+  ecmcDataItem         *items_[ECMC_SCOPE_LOGIC_MAX_CHANNELS];
+  ecmcDataItemInfo     *itemInfos_[ECMC_SCOPE_LOGIC_MAX_CHANNELS];
+  unsigned int          shift_[ECMC_SCOPE_LOGIC_MAX_CHANNELS];
+  uint64_t              mask_[ECMC_SCOPE_LOGIC_MAX_CHANNELS];
+  size_t                channelCount_;
+  unsigned int          bitCount_;
+  size_t                samplesPerCycle_;
+  uint8_t              *raw_;       // Raw data of one channel
+  size_t                rawBytes_;
+  uint64_t             *packed_;    // Packed words of current cycle
+  ecmcDataItemInfo      packedInfo_;
+};
+
+#endif  /* ECMC_SCOPE_LOGIC_H_ */
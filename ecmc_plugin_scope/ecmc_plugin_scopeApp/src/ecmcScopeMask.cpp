@@ -0,0 +1,308 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeMask.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+*  Passing captures (the normal case) cost one branch free counting pass
+*  over data and envelope, the element by element search with early exit
+*  only runs for failing captures. The counting pass is written with SSE2
+*  intrinsics (x86-64 baseline) since g++ does not vectorize the mixed
+*  compare and count loop, other targets use the scalar loop.
+*
+\*************************************************************************/
+
+// Needed to get headers in ecmc right...
+#define ECMC_IS_PLUGIN
+
+#include <string.h>
+#include <stdio.h>
+#include <limits>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "ecmcScopeMask.h"
+
+#define ECMC_SCOPE_MASK_BLOCK 64
+
+static size_t countBlock(const double *data,
+                         const double *upper,
+                         const double *lower,
+                         size_t        elements) {
+  size_t violations = 0;
+  size_t i          = 0;
+#if defined(__SSE2__)
+  __m128i count = _mm_setzero_si128();
+  for(; i + 2 <= elements; i += 2) {
+    __m128d value   = _mm_loadu_pd(&data[i]);
+    __m128d outside = _mm_or_pd(_mm_cmpgt_pd(value, _mm_loadu_pd(&upper[i])),
+                                _mm_cmplt_pd(value, _mm_loadu_pd(&lower[i])));
+    // Outside lanes are all ones (-1)
+    count = _mm_sub_epi64(count, _mm_castpd_si128(outside));
+  }
+  int64_t lanes[2];
+  _mm_storeu_si128((__m128i*)lanes, count);
+  violations = (size_t)(lanes[0] + lanes[1]);
+#endif
+  for(; i < elements; ++i) {
+    violations += (data[i] > upper[i]) | (data[i] < lower[i]);
+  }
+  return violations;
+}
+
+// Converted to double in blocks (stack buffer) and counted by countBlock()
+template <typename T>
+static size_t countViolations(const uint8_t *src,
+                              const double  *upper,
+                              const double  *lower,
+                              size_t         elements) {
+  const T *data = (const T*)src;
+  double  block[ECMC_SCOPE_MASK_BLOCK];
+  size_t  violations = 0;
+  for(size_t start = 0; start < elements; start += ECMC_SCOPE_MASK_BLOCK) {
+    size_t count = elements - start;
+    if(count > ECMC_SCOPE_MASK_BLOCK) {
+      count = ECMC_SCOPE_MASK_BLOCK;
+    }
+    for(size_t i = 0; i < count; ++i) {
+      block[i] = (double)data[start + i];
+    }
+    violations += countBlock(block, &upper[start], &lower[start], count);
+  }
+  return violations;
+}
+
+template <>
+size_t countViolations<double>(const uint8_t *src,
+                               const double  *upper,
+                               const double  *lower,
+                               size_t         elements) {
+  return countBlock((const double*)src, upper, lower, elements);
+}
+
+template <typename T>
+static int64_t findViolation(const uint8_t *src,
+                             const double  *upper,
+                             const double  *lower,
+                             size_t         elements) {
+  const T *data = (const T*)src;
+  for(size_t i = 0; i < elements; ++i) {
+    double value = (double)data[i];
+    if(value > upper[i] || value < lower[i]) {
+      return (int64_t)i;
+    }
+  }
+  return -1;
+}
+
+template <typename T>
+static size_t testData(const uint8_t *src,
+                       const double  *upper,
+                       const double  *lower,
+                       size_t         elements,
+                       int64_t       *first) {
+  size_t violations = countViolations<T>(src, upper, lower, elements);
+  *first = violations ? findViolation<T>(src, upper, lower, elements) : -1;
+  return violations;
+}
+
+ecmcScopeMask::ecmcScopeMask(size_t         elements,
+                             ecmcEcDataType dt,
+                             int            objId) {
+  if(elements == 0) {
+    throw std::invalid_argument( "ERROR: Invalid mask test elements.");
+  }
+  switch(dt) {
+    case ECMC_EC_U8:
+    case ECMC_EC_S8:
+    case ECMC_EC_U16:
+    case ECMC_EC_S16:
+    case ECMC_EC_U32:
+    case ECMC_EC_S32:
+    case ECMC_EC_U64:
+    case ECMC_EC_S64:
+    case ECMC_EC_F32:
+    case ECMC_EC_F64:
+      break;
+    default:
+      throw std::invalid_argument( "ERROR: Data type not supported for mask test.");
+  }
+
+  elements_       = elements;
+  dt_             = dt;
+  firstViolation_ = -1;
+  asynPort_       = NULL;
+  envState_       = ECMC_SCOPE_MASK_ENV_IDLE;
+  stop_           = 0;
+  workEvent_      = NULL;
+  exitEvent_      = NULL;
+  upper_          = NULL;
+  lower_          = NULL;
+  upperStandby_   = NULL;
+  lowerStandby_   = NULL;
+  upperReq_       = NULL;
+  lowerReq_       = NULL;
+  upper_          = new double[elements_];
+  lower_          = new double[elements_];
+  upperStandby_   = new double[elements_];
+  lowerStandby_   = new double[elements_];
+  upperReq_       = new double[elements_];
+  lowerReq_       = new double[elements_];
+  for(size_t i = 0; i < elements_; ++i) {
+    upper_[i] = std::numeric_limits<double>::infinity();
+    lower_[i] = -std::numeric_limits<double>::infinity();
+  }
+  memcpy(upperReq_, upper_, sizeof(double) * elements_);
+  memcpy(lowerReq_, lower_, sizeof(double) * elements_);
+
+  workEvent_ = epicsEventCreate(epicsEventEmpty);
+  exitEvent_ = epicsEventCreate(epicsEventEmpty);
+  if(!workEvent_ || !exitEvent_) {
+    release();
+    throw std::runtime_error( "ERROR: Failed create mask events.");
+  }
+
+  char threadName[64];
+  snprintf(threadName, sizeof(threadName), "ecmcScopeMask%d", objId);
+  if(!epicsThreadCreate(threadName,
+                        epicsThreadPriorityLow,
+                        epicsThreadGetStackSize(epicsThreadStackSmall),
+                        workerThread,
+                        this)) {
+    release();
+    throw std::runtime_error( "ERROR: Failed create mask thread.");
+  }
+}
+
+ecmcScopeMask::~ecmcScopeMask() {
+  // Stop worker
+  __atomic_store_n(&stop_, 1, __ATOMIC_RELEASE);
+  epicsEventSignal(workEvent_);
+  epicsEventWait(exitEvent_);
+  release();
+}
+
+// Free buffers and events (worker not running)
+void ecmcScopeMask::release() {
+  if(workEvent_) {
+    epicsEventDestroy(workEvent_);
+    workEvent_ = NULL;
+  }
+  if(exitEvent_) {
+    epicsEventDestroy(exitEvent_);
+    exitEvent_ = NULL;
+  }
+  delete[] upper_;
+  delete[] lower_;
+  delete[] upperStandby_;
+  delete[] lowerStandby_;
+  delete[] upperReq_;
+  delete[] lowerReq_;
+  upper_        = NULL;
+  lower_        = NULL;
+  upperStandby_ = NULL;
+  lowerStandby_ = NULL;
+  upperReq_     = NULL;
+  lowerReq_     = NULL;
+}
+
+double *ecmcScopeMask::getUpperReq() {
+  return upperReq_;
+}
+
+double *ecmcScopeMask::getLowerReq() {
+  return lowerReq_;
+}
+
+int64_t ecmcScopeMask::getFirstViolation() {
+  return firstViolation_;
+}
+
+void ecmcScopeMask::setAsynPort(ecmcAsynPortDriver *port) {
+  asynPort_ = port;
+}
+
+bool ecmcScopeMask::requestEnvelope() {
+  if(__atomic_load_n(&envState_, __ATOMIC_ACQUIRE) != ECMC_SCOPE_MASK_ENV_IDLE) {
+    return false;
+  }
+  __atomic_store_n(&envState_, ECMC_SCOPE_MASK_ENV_COPY, __ATOMIC_RELEASE);
+  epicsEventSignal(workEvent_);
+  return true;
+}
+
+// The envelope in use is swapped (never rewritten)
+bool ecmcScopeMask::applyEnvelope() {
+  if(__atomic_load_n(&envState_, __ATOMIC_ACQUIRE) != ECMC_SCOPE_MASK_ENV_READY) {
+    return false;
+  }
+  double *upper = upper_;
+  double *lower = lower_;
+  upper_        = upperStandby_;
+  lower_        = lowerStandby_;
+  upperStandby_ = upper;
+  lowerStandby_ = lower;
+  __atomic_store_n(&envState_, ECMC_SCOPE_MASK_ENV_IDLE, __ATOMIC_RELEASE);
+  return true;
+}
+
+bool ecmcScopeMask::envelopeBusy() {
+  return __atomic_load_n(&envState_, __ATOMIC_ACQUIRE) != ECMC_SCOPE_MASK_ENV_IDLE;
+}
+
+void ecmcScopeMask::workerThread(void *obj) {
+  ((ecmcScopeMask*)obj)->work();
+}
+
+void ecmcScopeMask::work() {
+  while(!__atomic_load_n(&stop_, __ATOMIC_ACQUIRE)) {
+    epicsEventWait(workEvent_);
+    if(__atomic_load_n(&envState_, __ATOMIC_ACQUIRE) != ECMC_SCOPE_MASK_ENV_COPY) {
+      continue;
+    }
+    // Standby is not used by rt in state COPY
+    if(asynPort_) {
+      asynPort_->lock();
+    }
+    memcpy(upperStandby_, upperReq_, sizeof(double) * elements_);
+    memcpy(lowerStandby_, lowerReq_, sizeof(double) * elements_);
+    if(asynPort_) {
+      asynPort_->unlock();
+    }
+    __atomic_store_n(&envState_, ECMC_SCOPE_MASK_ENV_READY, __ATOMIC_RELEASE);
+  }
+  epicsEventSignal(exitEvent_);
+}
+
+size_t ecmcScopeMask::test(const uint8_t *data) {
+  switch(dt_) {
+    case ECMC_EC_U8:
+      return testData<uint8_t>(data, upper_, lower_, elements_, &firstViolation_);
+    case ECMC_EC_S8:
+      return testData<int8_t>(data, upper_, lower_, elements_, &firstViolation_);
+    case ECMC_EC_U16:
+      return testData<uint16_t>(data, upper_, lower_, elements_, &firstViolation_);
+    case ECMC_EC_S16:
+      return testData<int16_t>(data, upper_, lower_, elements_, &firstViolation_);
+    case ECMC_EC_U32:
+      return testData<uint32_t>(data, upper_, lower_, elements_, &firstViolation_);
+    case ECMC_EC_S32:
+      return testData<int32_t>(data, upper_, lower_, elements_, &firstViolation_);
+    case ECMC_EC_U64:
+      return testData<uint64_t>(data, upper_, lower_, elements_, &firstViolation_);
+    case ECMC_EC_S64:
+      return testData<int64_t>(data, upper_, lower_, elements_, &firstViolation_);
+    case ECMC_EC_F32:
+      return testData<float>(data, upper_, lower_, elements_, &firstViolation_);
+    case ECMC_EC_F64:
+      return testData<double>(data, upper_, lower_, elements_, &firstViolation_);
+    default:
+      break;
+  }
+  firstViolation_ = -1;
+  return 0;
+}
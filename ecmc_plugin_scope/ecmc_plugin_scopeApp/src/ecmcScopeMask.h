@@ -0,0 +1,86 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeMask.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_MASK_H_
+#define ECMC_SCOPE_MASK_H_
+
+#include <stdexcept>
+#include "ecmcDataItem.h"
+#include "ecmcAsynPortDriver.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "inttypes.h"
+
+#define ECMC_SCOPE_MASK_ENV_IDLE  0  // Envelope copy states
+#define ECMC_SCOPE_MASK_ENV_COPY  1  // Worker copies request to standby
+#define ECMC_SCOPE_MASK_ENV_READY 2  // Standby ready to be swapped in (rt)
+
+/** Mask test
+ *  Each capture is compared sample by sample against an upper and a lower
+ *  envelope (one float64 per element). A sample violates the mask if it is
+ *  above upper or below lower. The violations are counted branch free over
+ *  contiguous arrays, the first violation is only searched in failing
+ *  captures.
+ *  The envelope is written (asyn) to request buffers. On an apply request
+ *  (rt) a worker thread copies the request to the standby envelope while
+ *  holding the asyn port lock (asyn writes hold the same lock, so the copy
+ *  is never torn). rt then swaps the standby envelope in, so rt never reads
+ *  the request buffers. Until applied the envelope is +/- infinity (all
+ *  captures pass).
+ *  This object can throw:
+ *    - bad_alloc
+ *    - invalid_argument
+ *    - runtime_error
+*/
+class ecmcScopeMask {
+ public:
+  ecmcScopeMask(size_t         elements,
+                ecmcEcDataType dt,
+                int            objId);
+  ~ecmcScopeMask();
+
+  // Request buffers (elements float64, written over asyn)
+  double               *getUpperReq();
+  double               *getLowerReq();
+  // Test capture (elements of dt). Returns violation count (0 = pass).
+  size_t                test(const uint8_t *data);
+  // First violating element of last test (-1 if passed)
+  int64_t               getFirstViolation();
+  // Asyn port of request buffers (locked by worker while copying)
+  void                  setAsynPort(ecmcAsynPortDriver *port);
+  // rt: start copy of request buffers (false if a copy is in progress)
+  bool                  requestEnvelope();
+  // rt: swap in copied envelope if ready, returns true if swapped
+  bool                  applyEnvelope();
+  bool                  envelopeBusy();
+
+ private:
+  static void           workerThread(void *obj);
+  void                  work();
+  void                  release();
+
+  size_t                elements_;
+  ecmcEcDataType        dt_;
+  double               *upper_;     // Envelope used by test
+  double               *lower_;
+  double               *upperStandby_; // Envelope swapped in by applyEnvelope()
+  double               *lowerStandby_;
+  double               *upperReq_;  // Envelope written over asyn
+  double               *lowerReq_;
+  int64_t               firstViolation_;
+  ecmcAsynPortDriver   *asynPort_;
+  int                   envState_;  // ECMC_SCOPE_MASK_ENV_*
+  int                   stop_;
+  epicsEventId          workEvent_;
+  epicsEventId          exitEvent_;
+};
+
+#endif  /* ECMC_SCOPE_MASK_H_ */
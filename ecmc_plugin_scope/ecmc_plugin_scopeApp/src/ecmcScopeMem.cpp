@@ -0,0 +1,50 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeMem.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+#include <new>
+#include <sys/mman.h>
+#include "ecmcScopeMem.h"
+
+uint8_t *ecmcScopeMemAlloc(size_t bytes, size_t *mappedBytes, int *hugePages) {
+  // Explicit huge pages (size rounded up to huge page)
+  size_t hugeBytes = (bytes + ECMC_SCOPE_MEM_HUGE_PAGE_BYTES - 1) &
+                     ~((size_t)ECMC_SCOPE_MEM_HUGE_PAGE_BYTES - 1);
+  void *data = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  data = mmap(NULL, hugeBytes, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+#endif
+  if(data != MAP_FAILED) {
+    *mappedBytes = hugeBytes;
+    *hugePages   = 1;
+    return (uint8_t*)data;
+  }
+
+  // Fallback normal pages
+  data = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+  if(data == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+#ifdef MADV_HUGEPAGE
+  madvise(data, bytes, MADV_HUGEPAGE);
+#endif
+  *mappedBytes = bytes;
+  *hugePages   = 0;
+  return (uint8_t*)data;
+}
+
+void ecmcScopeMemFree(uint8_t *data, size_t mappedBytes) {
+  if(data) {
+    munmap(data, mappedBytes);
+  }
+}
@@ -0,0 +1,31 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeMem.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_MEM_H_
+#define ECMC_SCOPE_MEM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ECMC_SCOPE_MEM_HUGE_PAGE_BYTES (2 * 1024 * 1024)
+
+/** Large buffer (mmap). Huge pages are tried first, then normal pages
+ *  (transparent huge pages advised). The memory is prefaulted and zeroed so
+ *  rt never takes a page fault in it.
+ *  mappedBytes: bytes to pass to ecmcScopeMemFree()
+ *  hugePages: 1 if explicit huge pages are used
+ *  Throws bad_alloc if the mapping fails.
+*/
+uint8_t *ecmcScopeMemAlloc(size_t bytes, size_t *mappedBytes, int *hugePages);
+
+void     ecmcScopeMemFree(uint8_t *data, size_t mappedBytes);
+
+#endif  /* ECMC_SCOPE_MEM_H_ */
@@ -0,0 +1,288 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopePersist.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+*  Folding is split in two passes: bin index of all samples (contiguous
+*  arithmetic only) and then the increments (scatter), so the histogram
+*  writes are kept out of the index calculation.
+*
+\*************************************************************************/
+
+// Needed to get headers in ecmc right...
+#define ECMC_IS_PLUGIN
+
+#include <string.h>
+#include <stdio.h>
+#include "epicsTime.h"
+#include "ecmcScopePersist.h"
+
+#define ECMC_SCOPE_PERSIST_SLOT_MASK (ECMC_SCOPE_PERSIST_SLOTS - 1)
+
+template <typename T>
+static void quantize(const uint8_t *src,
+                     int32_t       *binIndex,
+                     size_t         elements,
+                     double         min,
+                     double         scale,
+                     int            bins) {
+  const T *data = (const T*)src;
+  for(size_t i = 0; i < elements; ++i) {
+    double bin  = ((double)data[i] - min) * scale;
+    binIndex[i] = (bin >= 0 && bin < bins) ? (int32_t)bin : -1;  // -1 out of range
+  }
+}
+
+ecmcScopePersist::ecmcScopePersist(size_t         elements,
+                                   int            bins,
+                                   double         min,
+                                   double         max,
+                                   double         decay,
+                                   double         publishPeriodS,
+                                   ecmcEcDataType dt,
+                                   int            objId) {
+  if(elements == 0 || bins < 1 || max <= min) {
+    throw std::invalid_argument( "ERROR: Invalid persistence elements, bins or range.");
+  }
+  if(decay <= 0 || decay > 1 || publishPeriodS <= 0) {
+    throw std::invalid_argument( "ERROR: Invalid persistence decay or publish period.");
+  }
+  switch(dt) {
+    case ECMC_EC_U8:
+    case ECMC_EC_S8:
+    case ECMC_EC_U16:
+    case ECMC_EC_S16:
+    case ECMC_EC_U32:
+    case ECMC_EC_S32:
+    case ECMC_EC_U64:
+    case ECMC_EC_S64:
+    case ECMC_EC_F32:
+    case ECMC_EC_F64:
+      break;
+    default:
+      throw std::invalid_argument( "ERROR: Data type not supported for persistence.");
+  }
+
+  elements_       = elements;
+  bins_           = bins;
+  min_            = min;
+  binScale_       = bins / (max - min);
+  decay_          = decay;
+  publishPeriodS_ = publishPeriodS;
+  dt_             = dt;
+  slotHead_       = 0;
+  slotTail_       = 0;
+  imageReady_     = 0;
+  foldCount_      = 0;
+  dropCount_      = 0;
+  stop_           = 0;
+  workEvent_      = NULL;
+  exitEvent_      = NULL;
+  hist_           = NULL;
+  image_          = NULL;
+  binIndex_       = NULL;
+  slots_          = NULL;
+
+  switch(dt_) {
+    case ECMC_EC_U8:
+    case ECMC_EC_S8:
+      captureBytes_ = elements_;
+      break;
+    case ECMC_EC_U16:
+    case ECMC_EC_S16:
+      captureBytes_ = elements_ * 2;
+      break;
+    case ECMC_EC_U32:
+    case ECMC_EC_S32:
+    case ECMC_EC_F32:
+      captureBytes_ = elements_ * 4;
+      break;
+    default:
+      captureBytes_ = elements_ * 8;
+      break;
+  }
+
+  hist_     = new double[elements_ * bins_];
+  image_    = new double[elements_ * bins_];
+  binIndex_ = new int32_t[elements_];
+  slots_    = new uint8_t[captureBytes_ * ECMC_SCOPE_PERSIST_SLOTS];
+  memset(hist_, 0, sizeof(double) * elements_ * bins_);
+  memset(image_, 0, sizeof(double) * elements_ * bins_);
+  memset(binIndex_, 0, sizeof(int32_t) * elements_);
+  memset(slots_, 0, captureBytes_ * ECMC_SCOPE_PERSIST_SLOTS);
+
+  workEvent_ = epicsEventCreate(epicsEventEmpty);
+  exitEvent_ = epicsEventCreate(epicsEventEmpty);
+  if(!workEvent_ || !exitEvent_) {
+    release();
+    throw std::runtime_error( "ERROR: Failed create persistence events.");
+  }
+
+  char threadName[64];
+  snprintf(threadName, sizeof(threadName), "ecmcScopePersist%d", objId);
+  if(!epicsThreadCreate(threadName,
+                        epicsThreadPriorityLow,
+                        epicsThreadGetStackSize(epicsThreadStackMedium),
+                        workerThread,
+                        this)) {
+    release();
+    throw std::runtime_error( "ERROR: Failed create persistence thread.");
+  }
+}
+
+ecmcScopePersist::~ecmcScopePersist() {
+  // Stop worker
+  __atomic_store_n(&stop_, 1, __ATOMIC_RELEASE);
+  epicsEventSignal(workEvent_);
+  epicsEventWait(exitEvent_);
+  release();
+}
+
+// Free buffers and events (worker not running)
+void ecmcScopePersist::release() {
+  if(workEvent_) {
+    epicsEventDestroy(workEvent_);
+    workEvent_ = NULL;
+  }
+  if(exitEvent_) {
+    epicsEventDestroy(exitEvent_);
+    exitEvent_ = NULL;
+  }
+  delete[] hist_;
+  delete[] image_;
+  delete[] binIndex_;
+  delete[] slots_;
+  hist_     = NULL;
+  image_    = NULL;
+  binIndex_ = NULL;
+  slots_    = NULL;
+}
+
+bool ecmcScopePersist::add(const uint8_t *data) {
+  size_t head = __atomic_load_n(&slotHead_, __ATOMIC_RELAXED);
+  size_t tail = __atomic_load_n(&slotTail_, __ATOMIC_ACQUIRE);
+  if(head - tail >= ECMC_SCOPE_PERSIST_SLOTS) {
+    dropCount_++;
+    return false;
+  }
+  memcpy(&slots_[(head & ECMC_SCOPE_PERSIST_SLOT_MASK) * captureBytes_], data, captureBytes_);
+  __atomic_store_n(&slotHead_, head + 1, __ATOMIC_RELEASE);
+  epicsEventSignal(workEvent_);
+  return true;
+}
+
+bool ecmcScopePersist::imageReady() {
+  return __atomic_load_n(&imageReady_, __ATOMIC_ACQUIRE) != 0;
+}
+
+void ecmcScopePersist::imageDone() {
+  __atomic_store_n(&imageReady_, 0, __ATOMIC_RELEASE);
+}
+
+double *ecmcScopePersist::getImage() {
+  return image_;
+}
+
+size_t ecmcScopePersist::getImageBytes() {
+  return sizeof(double) * elements_ * bins_;
+}
+
+int ecmcScopePersist::getFoldCount() {
+  return __atomic_load_n(&foldCount_, __ATOMIC_RELAXED);
+}
+
+int ecmcScopePersist::getDropCount() {
+  return dropCount_;
+}
+
+void ecmcScopePersist::workerThread(void *obj) {
+  ((ecmcScopePersist*)obj)->work();
+}
+
+void ecmcScopePersist::work() {
+  epicsTimeStamp lastPublish;
+  epicsTimeStamp now;
+  epicsTimeGetCurrent(&lastPublish);
+
+  while(!__atomic_load_n(&stop_, __ATOMIC_ACQUIRE)) {
+    epicsEventWaitWithTimeout(workEvent_, publishPeriodS_);
+
+    // Fold queued captures
+    size_t tail = __atomic_load_n(&slotTail_, __ATOMIC_RELAXED);
+    size_t head = __atomic_load_n(&slotHead_, __ATOMIC_ACQUIRE);
+    while(tail != head) {
+      fold(&slots_[(tail & ECMC_SCOPE_PERSIST_SLOT_MASK) * captureBytes_]);
+      tail++;
+      __atomic_store_n(&slotTail_, tail, __ATOMIC_RELEASE);
+    }
+
+    // Periodic image (only if last image is published)
+    epicsTimeGetCurrent(&now);
+    if(epicsTimeDiffInSeconds(&now, &lastPublish) >= publishPeriodS_ && !imageReady()) {
+      buildImage();
+      __atomic_store_n(&imageReady_, 1, __ATOMIC_RELEASE);
+      lastPublish = now;
+    }
+  }
+  epicsEventSignal(exitEvent_);
+}
+
+void ecmcScopePersist::fold(const uint8_t *data) {
+  switch(dt_) {
+    case ECMC_EC_U8:
+      quantize<uint8_t>(data, binIndex_, elements_, min_, binScale_, bins_);
+      break;
+    case ECMC_EC_S8:
+      quantize<int8_t>(data, binIndex_, elements_, min_, binScale_, bins_);
+      break;
+    case ECMC_EC_U16:
+      quantize<uint16_t>(data, binIndex_, elements_, min_, binScale_, bins_);
+      break;
+    case ECMC_EC_S16:
+      quantize<int16_t>(data, binIndex_, elements_, min_, binScale_, bins_);
+      break;
+    case ECMC_EC_U32:
+      quantize<uint32_t>(data, binIndex_, elements_, min_, binScale_, bins_);
+      break;
+    case ECMC_EC_S32:
+      quantize<int32_t>(data, binIndex_, elements_, min_, binScale_, bins_);
+      break;
+    case ECMC_EC_U64:
+      quantize<uint64_t>(data, binIndex_, elements_, min_, binScale_, bins_);
+      break;
+    case ECMC_EC_S64:
+      quantize<int64_t>(data, binIndex_, elements_, min_, binScale_, bins_);
+      break;
+    case ECMC_EC_F32:
+      quantize<float>(data, binIndex_, elements_, min_, binScale_, bins_);
+      break;
+    case ECMC_EC_F64:
+      quantize<double>(data, binIndex_, elements_, min_, binScale_, bins_);
+      break;
+    default:
+      return;
+  }
+
+  for(size_t i = 0; i < elements_; ++i) {
+    if(binIndex_[i] >= 0) {
+      hist_[binIndex_[i] * elements_ + i] += 1.0;
+    }
+  }
+  __atomic_store_n(&foldCount_, foldCount_ + 1, __ATOMIC_RELAXED);
+}
+
+// Copy histogram to image, then decay histogram
+void ecmcScopePersist::buildImage() {
+  size_t count = elements_ * bins_;
+  memcpy(image_, hist_, sizeof(double) * count);
+  if(decay_ < 1) {
+    for(size_t i = 0; i < count; ++i) {
+      hist_[i] *= decay_;
+    }
+  }
+}
@@ -0,0 +1,88 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopePersist.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_PERSIST_H_
+#define ECMC_SCOPE_PERSIST_H_
+
+#include <stdexcept>
+#include "ecmcDataItem.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "inttypes.h"
+
+#define ECMC_SCOPE_PERSIST_SLOTS 4  // Captures queued for worker (must be 2^n)
+
+/** Persistence (density) image
+ *  Each capture is quantized into a 2D histogram (amplitude bin, sample
+ *  index). The histogram is built in a worker thread: rt only copies the
+ *  capture to a free slot (dropped if no slot is free). Periodically the
+ *  histogram is decayed and copied to an image (row major, one row of
+ *  "elements" per amplitude bin, first row = min) that rt publishes. The
+ *  worker only builds a new image when the last one is published.
+ *  This object can throw:
+ *    - bad_alloc
+ *    - invalid_argument
+ *    - runtime_error
+*/
+class ecmcScopePersist {
+ public:
+  ecmcScopePersist(size_t         elements,
+                   int            bins,
+                   double         min,
+                   double         max,
+                   double         decay,
+                   double         publishPeriodS,
+                   ecmcEcDataType dt,
+                   int            objId);
+  ~ecmcScopePersist();
+
+  // rt: queue capture (elements of dt). Returns false if dropped.
+  bool                  add(const uint8_t *data);
+  // rt: new image available
+  bool                  imageReady();
+  // rt: image published (worker may build next)
+  void                  imageDone();
+  double               *getImage();
+  size_t                getImageBytes();
+  // Captures folded and dropped (for diagnostics)
+  int                   getFoldCount();
+  int                   getDropCount();
+
+ private:
+  static void           workerThread(void *obj);
+  void                  work();
+  void                  fold(const uint8_t *data);
+  void                  buildImage();
+  void                  release();
+
+  size_t                elements_;
+  int                   bins_;
+  double                min_;
+  double                binScale_;       // bins per amplitude unit
+  double                decay_;
+  double                publishPeriodS_;
+  ecmcEcDataType        dt_;
+  size_t                captureBytes_;
+  double               *hist_;           // Worker only
+  double               *image_;          // Worker writes if !imageReady_, rt reads if imageReady_
+  int32_t              *binIndex_;       // Worker scratch (bin of each sample)
+  uint8_t              *slots_;          // ECMC_SCOPE_PERSIST_SLOTS captures
+  size_t                slotHead_;       // Written by rt
+  size_t                slotTail_;       // Written by worker
+  int                   imageReady_;
+  int                   foldCount_;
+  int                   dropCount_;
+  int                   stop_;
+  epicsEventId          workEvent_;
+  epicsEventId          exitEvent_;
+};
+
+#endif  /* ECMC_SCOPE_PERSIST_H_ */
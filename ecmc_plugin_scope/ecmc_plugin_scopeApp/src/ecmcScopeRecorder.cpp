@@ -0,0 +1,256 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeRecorder.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "ecmcScopeRecorder.h"
+
+ecmcScopeRecorder::ecmcScopeRecorder(size_t frameBytes,
+                                     int    captures,
+                                     size_t scanBytes,
+                                     int    historyScans,
+                                     int    objId) {
+  if(frameBytes == 0 || captures < 1 || historyScans < 0) {
+    throw std::invalid_argument( "ERROR: Invalid recorder frame size, captures or history.");
+  }
+  frameBytes_    = frameBytes;
+  captures_      = captures;
+  captureHead_   = 0;
+  captureCount_  = 0;
+  scanBytes_     = scanBytes;
+  historyScans_  = historyScans;
+  historyHead_   = 0;
+  historyCount_  = 0;
+  frozen_        = 0;
+  captureSeq_    = 0;
+  pubState_      = ECMC_SCOPE_RECORDER_PUB_IDLE;
+  pubIndex_      = 0;
+  pubHistory_    = 0;
+  pubCaptureValid_ = 0;
+  pubHistoryBytes_ = 0;
+  stop_          = 0;
+  workEvent_     = NULL;
+  exitEvent_     = NULL;
+  captureBuffer_ = NULL;
+  historyBuffer_ = NULL;
+  captureOut_    = NULL;
+  historyOut_    = NULL;
+
+  captureBuffer_ = new uint8_t[frameBytes_ * captures_];
+  captureOut_    = new uint8_t[frameBytes_];
+  memset(captureBuffer_, 0, frameBytes_ * captures_);
+  memset(captureOut_, 0, frameBytes_);
+  if(historyScans_) {
+    historyBuffer_ = new uint8_t[scanBytes_ * historyScans_];
+    historyOut_    = new uint8_t[scanBytes_ * historyScans_];
+    memset(historyBuffer_, 0, scanBytes_ * historyScans_);
+    memset(historyOut_, 0, scanBytes_ * historyScans_);
+  }
+
+  workEvent_ = epicsEventCreate(epicsEventEmpty);
+  exitEvent_ = epicsEventCreate(epicsEventEmpty);
+  if(!workEvent_ || !exitEvent_) {
+    release();
+    throw std::runtime_error( "ERROR: Failed create recorder events.");
+  }
+
+  char threadName[64];
+  snprintf(threadName, sizeof(threadName), "ecmcScopeRec%d", objId);
+  if(!epicsThreadCreate(threadName,
+                        epicsThreadPriorityLow,
+                        epicsThreadGetStackSize(epicsThreadStackSmall),
+                        workerThread,
+                        this)) {
+    release();
+    throw std::runtime_error( "ERROR: Failed create recorder thread.");
+  }
+}
+
+ecmcScopeRecorder::~ecmcScopeRecorder() {
+  // Stop worker
+  __atomic_store_n(&stop_, 1, __ATOMIC_RELEASE);
+  epicsEventSignal(workEvent_);
+  epicsEventWait(exitEvent_);
+  release();
+}
+
+// Free buffers and events (worker not running)
+void ecmcScopeRecorder::release() {
+  if(workEvent_) {
+    epicsEventDestroy(workEvent_);
+    workEvent_ = NULL;
+  }
+  if(exitEvent_) {
+    epicsEventDestroy(exitEvent_);
+    exitEvent_ = NULL;
+  }
+  delete[] captureBuffer_;
+  delete[] historyBuffer_;
+  delete[] captureOut_;
+  delete[] historyOut_;
+  captureBuffer_ = NULL;
+  historyBuffer_ = NULL;
+  captureOut_    = NULL;
+  historyOut_    = NULL;
+}
+
+// Sequence counter is odd while the slot, head and count are updated
+void ecmcScopeRecorder::addCapture(const uint8_t *frame) {
+  if(frozen_) {
+    return;
+  }
+  __atomic_store_n(&captureSeq_, captureSeq_ + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(&captureBuffer_[captureHead_ * frameBytes_], frame, frameBytes_);
+  __atomic_store_n(&captureHead_, (captureHead_ + 1) % captures_, __ATOMIC_RELAXED);
+  if(captureCount_ < captures_) {
+    __atomic_store_n(&captureCount_, captureCount_ + 1, __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&captureSeq_, captureSeq_ + 1, __ATOMIC_RELEASE);
+}
+
+uint8_t *ecmcScopeRecorder::getScanSlot() {
+  if(frozen_ || !historyScans_) {
+    return NULL;
+  }
+  return &historyBuffer_[historyHead_ * scanBytes_];
+}
+
+void ecmcScopeRecorder::commitScan() {
+  historyHead_ = (historyHead_ + 1) % historyScans_;
+  if(historyCount_ < historyScans_) {
+    historyCount_++;
+  }
+}
+
+void ecmcScopeRecorder::freeze() {
+  frozen_ = 1;
+}
+
+void ecmcScopeRecorder::unfreeze() {
+  frozen_ = 0;
+}
+
+int ecmcScopeRecorder::isFrozen() {
+  return frozen_;
+}
+
+int ecmcScopeRecorder::getCaptureCount() {
+  return captureCount_;
+}
+
+size_t ecmcScopeRecorder::getFrameBytes() {
+  return frameBytes_;
+}
+
+bool ecmcScopeRecorder::requestPublish(int index, bool history) {
+  if(__atomic_load_n(&pubState_, __ATOMIC_ACQUIRE) != ECMC_SCOPE_RECORDER_PUB_IDLE) {
+    return false;
+  }
+  pubIndex_   = index;
+  pubHistory_ = history && frozen_ && historyScans_;
+  __atomic_store_n(&pubState_, ECMC_SCOPE_RECORDER_PUB_COPY, __ATOMIC_RELEASE);
+  epicsEventSignal(workEvent_);
+  return true;
+}
+
+bool ecmcScopeRecorder::publishReady() {
+  return __atomic_load_n(&pubState_, __ATOMIC_ACQUIRE) == ECMC_SCOPE_RECORDER_PUB_READY;
+}
+
+void ecmcScopeRecorder::publishDone() {
+  __atomic_store_n(&pubState_, ECMC_SCOPE_RECORDER_PUB_IDLE, __ATOMIC_RELEASE);
+}
+
+bool ecmcScopeRecorder::publishBusy() {
+  return __atomic_load_n(&pubState_, __ATOMIC_ACQUIRE) != ECMC_SCOPE_RECORDER_PUB_IDLE;
+}
+
+const uint8_t *ecmcScopeRecorder::getPublishedCapture() {
+  return pubCaptureValid_ ? captureOut_ : NULL;
+}
+
+const uint8_t *ecmcScopeRecorder::getPublishedHistory() {
+  return pubHistory_ ? historyOut_ : NULL;
+}
+
+size_t ecmcScopeRecorder::getPublishedHistoryBytes() {
+  return pubHistoryBytes_;
+}
+
+uint8_t *ecmcScopeRecorder::getCaptureOut() {
+  return captureOut_;
+}
+
+uint8_t *ecmcScopeRecorder::getHistoryOut() {
+  return historyOut_;
+}
+
+void ecmcScopeRecorder::workerThread(void *obj) {
+  ((ecmcScopeRecorder*)obj)->work();
+}
+
+void ecmcScopeRecorder::work() {
+  while(!__atomic_load_n(&stop_, __ATOMIC_ACQUIRE)) {
+    epicsEventWait(workEvent_);
+    if(__atomic_load_n(&pubState_, __ATOMIC_ACQUIRE) != ECMC_SCOPE_RECORDER_PUB_COPY) {
+      continue;
+    }
+    // Output buffers are not used by rt in state COPY
+    pubCaptureValid_ = copyCapture(pubIndex_);
+    pubHistoryBytes_ = pubHistory_ ? copyHistory() : 0;
+    __atomic_store_n(&pubState_, ECMC_SCOPE_RECORDER_PUB_READY, __ATOMIC_RELEASE);
+  }
+  epicsEventSignal(exitEvent_);
+}
+
+// Worker: copy capture by age, retried if rt added a capture meanwhile
+bool ecmcScopeRecorder::copyCapture(int index) {
+  for(;;) {
+    int seq = __atomic_load_n(&captureSeq_, __ATOMIC_ACQUIRE);
+    if(seq & 1) {
+      epicsThreadSleep(0.001);
+      continue;
+    }
+    int head  = __atomic_load_n(&captureHead_, __ATOMIC_RELAXED);
+    int count = __atomic_load_n(&captureCount_, __ATOMIC_RELAXED);
+    if(index < 0 || index >= count) {
+      return false;
+    }
+    int slot = (head - 1 - index + captures_) % captures_;
+    memcpy(captureOut_, &captureBuffer_[slot * frameBytes_], frameBytes_);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if(__atomic_load_n(&captureSeq_, __ATOMIC_RELAXED) == seq) {
+      return true;
+    }
+  }
+}
+
+// Worker: unroll frozen history (oldest scan first), returns bytes
+size_t ecmcScopeRecorder::copyHistory() {
+  uint8_t *dst = historyOut_;
+  if(!historyCount_) {
+    return 0;
+  }
+  int first = (historyHead_ - historyCount_ + historyScans_) % historyScans_;
+  int scansFirst = historyScans_ - first;
+  if(scansFirst > historyCount_) {
+    scansFirst = historyCount_;
+  }
+  memcpy(dst, &historyBuffer_[first * scanBytes_], scansFirst * scanBytes_);
+  memcpy(dst + scansFirst * scanBytes_, historyBuffer_, (historyCount_ - scansFirst) * scanBytes_);
+  return historyCount_ * scanBytes_;
+}
+
+size_t ecmcScopeRecorder::getHistoryBytes() {
+  return scanBytes_ * historyScans_;
+}
@@ -0,0 +1,106 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeRecorder.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_RECORDER_H_
+#define ECMC_SCOPE_RECORDER_H_
+
+#include <stdexcept>
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "inttypes.h"
+
+#define ECMC_SCOPE_RECORDER_PUB_IDLE  0  // Publish copy states
+#define ECMC_SCOPE_RECORDER_PUB_COPY  1  // Worker copies capture (and history)
+#define ECMC_SCOPE_RECORDER_PUB_READY 2  // Copies ready to be published (rt)
+
+/** Flight recorder
+ *  Keeps the last "captures" completed frames (frame header + data) and
+ *  optionally a continuous history of the last "historyScans" source scans
+ *  in preallocated rings. Freeze only stops the recording (O(1)), the
+ *  frozen content stays until unfreeze (re-arm).
+ *  The content is copied out of the rings by a worker thread (rt only
+ *  requests and publishes). The history is only copied while frozen and
+ *  rt must not unfreeze while a copy is in progress (publishBusy()). A
+ *  capture may be copied while recording, addCapture() is guarded by a
+ *  sequence counter and the worker retries if a capture was added during
+ *  the copy.
+ *  This object can throw:
+ *    - bad_alloc
+ *    - invalid_argument
+ *    - runtime_error
+*/
+class ecmcScopeRecorder {
+ public:
+  ecmcScopeRecorder(size_t frameBytes,
+                    int    captures,
+                    size_t scanBytes,
+                    int    historyScans,
+                    int    objId);
+  ~ecmcScopeRecorder();
+
+  void                  addCapture(const uint8_t *frame);
+  // Slot for next history scan (NULL if frozen or no history), then commitScan()
+  uint8_t              *getScanSlot();
+  void                  commitScan();
+  void                  freeze();
+  void                  unfreeze();
+  int                   isFrozen();
+  int                   getCaptureCount();
+  size_t                getFrameBytes();
+  size_t                getHistoryBytes();
+  // rt: start copy of capture by age (and history if frozen), false if busy
+  bool                  requestPublish(int index, bool history);
+  // rt: copies ready, publish then call publishDone()
+  bool                  publishReady();
+  void                  publishDone();
+  // rt: copy requested or ready (rings must not be unfrozen)
+  bool                  publishBusy();
+  // Copied capture (NULL if index was out of range)
+  const uint8_t        *getPublishedCapture();
+  // Copied history (oldest scan first), NULL if not requested
+  const uint8_t        *getPublishedHistory();
+  size_t                getPublishedHistoryBytes();
+  // Buffers of published copies (asyn params)
+  uint8_t              *getCaptureOut();
+  uint8_t              *getHistoryOut();
+
+ private:
+  static void           workerThread(void *obj);
+  void                  work();
+  void                  release();
+  bool                  copyCapture(int index);
+  size_t                copyHistory();
+
+  size_t                frameBytes_;
+  int                   captures_;
+  uint8_t              *captureBuffer_;
+  int                   captureHead_;    // Next slot
+  int                   captureCount_;
+  size_t                scanBytes_;
+  int                   historyScans_;
+  uint8_t              *historyBuffer_;
+  int                   historyHead_;    // Next slot
+  int                   historyCount_;
+  int                   frozen_;
+  int                   captureSeq_;     // Odd while rt writes a capture
+  uint8_t              *captureOut_;     // Worker writes in state COPY
+  uint8_t              *historyOut_;
+  int                   pubState_;       // ECMC_SCOPE_RECORDER_PUB_*
+  int                   pubIndex_;
+  int                   pubHistory_;
+  int                   pubCaptureValid_;
+  size_t                pubHistoryBytes_;
+  int                   stop_;
+  epicsEventId          workEvent_;
+  epicsEventId          exitEvent_;
+};
+
+#endif  /* ECMC_SCOPE_RECORDER_H_ */
@@ -0,0 +1,166 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeReplay.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+// Needed to get headers in ecmc right...
+#define ECMC_IS_PLUGIN
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include "ecmcScopeReplay.h"
+
+// Bytes of recorded data types (0 = not supported in replay, bit types)
+static size_t replayTypeBytes(uint8_t dt) {
+  switch((ecmcEcDataType)dt) {
+    case ECMC_EC_U8:
+    case ECMC_EC_S8:
+      return 1;
+    case ECMC_EC_U16:
+    case ECMC_EC_S16:
+      return 2;
+    case ECMC_EC_U32:
+    case ECMC_EC_S32:
+    case ECMC_EC_F32:
+      return 4;
+    case ECMC_EC_U64:
+    case ECMC_EC_S64:
+    case ECMC_EC_F64:
+      return 8;
+    default:
+      break;
+  }
+  return 0;
+}
+
+ecmcScopeReplay::ecmcScopeReplay(const char *fileName) {
+  map_      = NULL;
+  mapBytes_ = 0;
+
+  int fd = open(fileName, O_RDONLY);
+  if(fd < 0) {
+    throw std::runtime_error( std::string("ERROR: Failed open replay file: ") + fileName);
+  }
+  struct stat st;
+  if(fstat(fd, &st) || (size_t)st.st_size < sizeof(ecmcScopeReplayHeader)) {
+    close(fd);
+    throw std::invalid_argument( std::string("ERROR: Replay file too small: ") + fileName);
+  }
+  mapBytes_ = (size_t)st.st_size;
+  void *data = mmap(NULL, mapBytes_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(data == MAP_FAILED) {
+    throw std::runtime_error( std::string("ERROR: Failed map replay file: ") + fileName);
+  }
+  map_ = (uint8_t*)data;
+#ifdef MADV_SEQUENTIAL
+  madvise(map_, mapBytes_, MADV_SEQUENTIAL);
+#endif
+
+  header_ = (const ecmcScopeReplayHeader*)map_;
+  if(header_->magic != ECMC_SCOPE_REPLAY_MAGIC ||
+     header_->version != ECMC_SCOPE_REPLAY_VERSION ||
+     header_->headerBytes < sizeof(ecmcScopeReplayHeader) ||
+     header_->headerBytes % sizeof(uint64_t) ||
+     header_->elementSize == 0 || header_->elementSize > 8 ||
+     replayTypeBytes(header_->dataType) != header_->elementSize ||
+     header_->scanBytes == 0 || header_->scanBytes % header_->elementSize ||
+     header_->cycleNs == 0 ||
+     (header_->nexttimeBits != 32 && header_->nexttimeBits != 64) ||
+     (header_->triggBits != 32 && header_->triggBits != 64) ||
+     replayTypeBytes(header_->triggDataType) != (size_t)header_->triggBits / 8 ||
+     header_->triggCount < 1 || header_->triggCount > ECMC_SCOPE_REPLAY_MAX_TRIGG) {
+    munmap(map_, mapBytes_);
+    throw std::invalid_argument( std::string("ERROR: Invalid replay file header: ") + fileName);
+  }
+
+  recordBytes_ = sizeof(uint64_t) * (1 + header_->triggCount) +
+                 ((header_->scanBytes + 7) & ~(size_t)7);
+  if(header_->records == 0 ||
+     (mapBytes_ - header_->headerBytes) / recordBytes_ < header_->records) {
+    munmap(map_, mapBytes_);
+    throw std::invalid_argument( std::string("ERROR: Replay file records missing: ") + fileName);
+  }
+
+  // Recorded streams (values are read from records, no data pointers)
+  memset(&sourceInfo_, 0, sizeof(sourceInfo_));
+  sourceInfo_.name             = (char*)"replay.source";
+  sourceInfo_.dataSize         = header_->scanBytes;
+  sourceInfo_.dataElementSize  = header_->elementSize;
+  sourceInfo_.dataBitCount     = header_->elementSize * 8;
+  sourceInfo_.dataType         = (ecmcEcDataType)header_->dataType;
+  sourceInfo_.dataUpdateRateMs = header_->cycleNs / 1E6;
+
+  memset(&nexttimeInfo_, 0, sizeof(nexttimeInfo_));
+  nexttimeInfo_.name            = (char*)"replay.nexttime";
+  nexttimeInfo_.dataSize        = header_->nexttimeBits / 8;
+  nexttimeInfo_.dataElementSize = header_->nexttimeBits / 8;
+  nexttimeInfo_.dataBitCount    = header_->nexttimeBits;
+  nexttimeInfo_.dataType        = header_->nexttimeBits == 32 ? ECMC_EC_U32 : ECMC_EC_U64;
+
+  memset(&triggInfo_, 0, sizeof(triggInfo_));
+  triggInfo_.name            = (char*)"replay.trigg";
+  triggInfo_.dataSize        = header_->triggBits / 8;
+  triggInfo_.dataElementSize = header_->triggBits / 8;
+  triggInfo_.dataBitCount    = header_->triggBits;
+  triggInfo_.dataType        = (ecmcEcDataType)header_->triggDataType;
+}
+
+ecmcScopeReplay::~ecmcScopeReplay() {
+  if(map_) {
+    munmap(map_, mapBytes_);
+  }
+}
+
+uint64_t ecmcScopeReplay::getRecordCount() {
+  return header_->records;
+}
+
+uint64_t ecmcScopeReplay::getCycleNs() {
+  return header_->cycleNs;
+}
+
+const uint8_t *ecmcScopeReplay::getRecord(uint64_t record) {
+  return map_ + header_->headerBytes + record * recordBytes_;
+}
+
+uint64_t ecmcScopeReplay::getNexttime(uint64_t record) {
+  uint64_t nexttime;
+  memcpy(&nexttime, getRecord(record), sizeof(nexttime));
+  return nexttime;
+}
+
+const uint64_t *ecmcScopeReplay::getTrigg(uint64_t record) {
+  return (const uint64_t*)(getRecord(record) + sizeof(uint64_t));
+}
+
+const uint8_t *ecmcScopeReplay::getScan(uint64_t record) {
+  return getRecord(record) + sizeof(uint64_t) * (1 + header_->triggCount);
+}
+
+ecmcDataItemInfo *ecmcScopeReplay::getSourceInfo() {
+  return &sourceInfo_;
+}
+
+ecmcDataItemInfo *ecmcScopeReplay::getNexttimeInfo() {
+  return &nexttimeInfo_;
+}
+
+int ecmcScopeReplay::getTriggCount() {
+  return header_->triggCount;
+}
+
+ecmcDataItemInfo *ecmcScopeReplay::getTriggInfo() {
+  return &triggInfo_;
+}
@@ -0,0 +1,56 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeReplay.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_REPLAY_H_
+#define ECMC_SCOPE_REPLAY_H_
+
+#include <stdexcept>
+#include "ecmcDataItem.h"
+#include "ecmcScopeFrame.h"
+#include "inttypes.h"
+
+/** Replay file (recorded source, NEXT_TIME and trigger values per cycle)
+ *  The file is memory mapped read only (sequential access). The data item
+ *  infos describe the recorded streams (no data pointers, values are taken
+ *  from the records).
+ *  This object can throw:
+ *    - runtime_error
+ *    - invalid_argument
+*/
+class ecmcScopeReplay {
+ public:
+  explicit ecmcScopeReplay(const char *fileName);
+  ~ecmcScopeReplay();
+
+  uint64_t              getRecordCount();
+  uint64_t              getCycleNs();
+  uint64_t              getNexttime(uint64_t record);
+  const uint64_t       *getTrigg(uint64_t record);
+  const uint8_t        *getScan(uint64_t record);
+  ecmcDataItemInfo     *getSourceInfo();
+  ecmcDataItemInfo     *getNexttimeInfo();
+  int                   getTriggCount();
+  // Same for all trigger values
+  ecmcDataItemInfo     *getTriggInfo();
+
+ private:
+  const uint8_t        *getRecord(uint64_t record);
+
+  uint8_t              *map_;
+  size_t                mapBytes_;
+  const ecmcScopeReplayHeader *header_;
+  size_t                recordBytes_;
+  ecmcDataItemInfo      sourceInfo_;
+  ecmcDataItemInfo      nexttimeInfo_;
+  ecmcDataItemInfo      triggInfo_;
+};
+
+#endif  /* ECMC_SCOPE_REPLAY_H_ */
@@ -0,0 +1,118 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeSource.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+// Needed to get headers in ecmc right...
+#define ECMC_IS_PLUGIN
+
+#include <string.h>
+#include "ecmcScopeSource.h"
+#include "ecmcPluginClient.h"
+
+ecmcScopeSource::ecmcScopeSource(ecmcDataItem *item) {
+  if(!item) {
+    throw std::runtime_error( "ERROR: Source dataitem NULL." );
+  }
+  info_ = item->getDataItemInfo();
+  if(!info_) {
+    throw std::runtime_error( "ERROR: Source dataitem info NULL." );
+  }
+  item_         = item;
+  direct_       = info_->data && info_->dataPointerValid;
+  currentRead_  = 0;
+  historyUsers_ = 0;
+  buffer_       = new uint8_t[info_->dataSize * 2];
+  memset(buffer_, 0, info_->dataSize * 2);
+}
+
+ecmcScopeSource::~ecmcScopeSource() {
+  delete[] buffer_;
+}
+
+ecmcDataItem *ecmcScopeSource::getItem() {
+  return item_;
+}
+
+void ecmcScopeSource::update() {
+  currentRead_ = 0;
+}
+
+void ecmcScopeSource::commit() {
+  if(historyUsers_ > 0) {
+    memcpy(getLast(), getCurrent(), info_->dataSize);
+  }
+}
+
+void ecmcScopeSource::addHistoryUser(int users) {
+  historyUsers_ += users;
+}
+
+uint8_t *ecmcScopeSource::getCurrent() {
+  if(direct_) {
+    return info_->data;
+  }
+  if(!currentRead_) {
+    if(item_->read(buffer_, info_->dataSize)) {
+      throw std::runtime_error( "ERROR: Failed read data source." );
+    }
+    currentRead_ = 1;
+  }
+  return buffer_;
+}
+
+uint8_t *ecmcScopeSource::getLast() {
+  return &buffer_[info_->dataSize];
+}
+
+ecmcScopeSourceRegistry::ecmcScopeSourceRegistry() {
+}
+
+ecmcScopeSourceRegistry::~ecmcScopeSourceRegistry() {
+  for(size_t i = 0; i < sources_.size(); ++i) {
+    delete sources_[i];
+  }
+}
+
+ecmcScopeSource *ecmcScopeSourceRegistry::get(ecmcDataItem *item) {
+  for(size_t i = 0; i < sources_.size(); ++i) {
+    if(sources_[i]->getItem() == item) {
+      return sources_[i];
+    }
+  }
+  ecmcScopeSource *source = new ecmcScopeSource(item);
+  sources_.push_back(source);
+  return source;
+}
+
+ecmcDataItem *ecmcScopeSourceRegistry::getItem(const char *name) {
+  std::map<std::string, ecmcDataItem*>::iterator it = items_.find(name);
+  if(it != items_.end()) {
+    return it->second;
+  }
+  ecmcDataItem *item = (ecmcDataItem*) getEcmcDataItem((char*)name);
+  // Only cache found items (NULL is handled by caller)
+  if(item) {
+    items_[name] = item;
+  }
+  return item;
+}
+
+void ecmcScopeSourceRegistry::update() {
+  for(size_t i = 0; i < sources_.size(); ++i) {
+    sources_[i]->update();
+  }
+}
+
+void ecmcScopeSourceRegistry::commit() {
+  for(size_t i = 0; i < sources_.size(); ++i) {
+    sources_[i]->commit();
+  }
+}
@@ -0,0 +1,83 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeSource.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_SOURCE_H_
+#define ECMC_SCOPE_SOURCE_H_
+
+#include <stdexcept>
+#include <vector>
+#include <map>
+#include <string>
+#include "ecmcDataItem.h"
+#include "inttypes.h"
+
+/** Shared source data history
+ *  One object per unique source data item. The current scan is read in
+ *  place from the process image (copied at first request in the cycle if
+ *  the data pointer is not valid). The previous scan is only copied (after
+ *  the scopes are executed) if a scope on the source needs it, that is
+ *  waiting for a trigger that may refer to the previous cycle. Idle
+ *  sources copy nothing.
+ *  This object can throw:
+ *    - bad_alloc
+ *    - runtime_error
+*/
+class ecmcScopeSource {
+ public:
+  explicit ecmcScopeSource(ecmcDataItem *item);
+  ~ecmcScopeSource();
+
+  ecmcDataItem         *getItem();
+  // New cycle (before scopes are executed)
+  void                  update();
+  // Keep current scan as previous scan if needed (after scopes are executed)
+  void                  commit();
+  // Scopes needing the previous scan next cycle (+1 / -1)
+  void                  addHistoryUser(int users);
+  // Scan data of current cycle
+  uint8_t              *getCurrent();
+  // Scan data of previous cycle (valid if a history user in previous cycle)
+  uint8_t              *getLast();
+
+ private:
+  ecmcDataItem         *item_;
+  ecmcDataItemInfo     *info_;
+  uint8_t              *buffer_;       // Current scan (if not in place) and previous scan
+  int                   direct_;       // Current scan in place (process image)
+  int                   currentRead_;  // Current scan copied this cycle (not in place)
+  int                   historyUsers_;
+};
+
+/** Registry of shared sources (one per unique data item)
+ *  This object can throw:
+ *    - bad_alloc
+ *    - runtime_error
+*/
+class ecmcScopeSourceRegistry {
+ public:
+  ecmcScopeSourceRegistry();
+  ~ecmcScopeSourceRegistry();
+
+  // Source of item (created at first request)
+  ecmcScopeSource      *get(ecmcDataItem *item);
+  // Data item by name (resolved once, shared by all scopes)
+  ecmcDataItem         *getItem(const char *name);
+  // New cycle of all sources (before scopes are executed)
+  void                  update();
+  // Previous scan of all sources (after scopes are executed)
+  void                  commit();
+
+ private:
+  std::vector<ecmcScopeSource*> sources_;
+  std::map<std::string, ecmcDataItem*> items_;
+};
+
+#endif  /* ECMC_SCOPE_SOURCE_H_ */
@@ -0,0 +1,75 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeTimebase.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+#include "ecmcScopeTimebase.h"
+
+ecmcScopeTimebase::ecmcScopeTimebase(uint64_t cycleNs,
+                                     int64_t  samplesPerCycle,
+                                     size_t   bitCount) {
+  if(cycleNs == 0) {
+    throw std::out_of_range( "ERROR: Timebase cycle time must be > 0ns." );
+  }
+  nominalCycleNs_  = cycleNs;
+  samplesPerCycle_ = samplesPerCycle > 0 ? samplesPerCycle : 1;
+  bitCount_        = bitCount;
+  nexttime_        = 0;
+  cycleNs_         = (double)cycleNs;
+  valid_           = 0;
+}
+
+ecmcScopeTimebase::~ecmcScopeTimebase() {
+}
+
+void ecmcScopeTimebase::reset() {
+  valid_ = 0;
+}
+
+// Signed diff a - b of raw timestamps (handles 32bit wrap)
+int64_t ecmcScopeTimebase::rawDiff(uint64_t a, uint64_t b) {
+  if(bitCount_ < 64) {
+    return (int64_t)(int32_t)((uint32_t)a - (uint32_t)b);
+  }
+  return (int64_t)(a - b);
+}
+
+uint64_t ecmcScopeTimebase::update(uint64_t nexttime) {
+  if(!valid_) {
+    nexttime_ = bitCount_ < 64 ? (uint32_t)nexttime : nexttime;
+    valid_    = 1;
+    return nexttime_;
+  }
+
+  int64_t delta = rawDiff(nexttime, nexttime_);
+  nexttime_ += delta;
+
+  // Track cycle time (only normal cycles)
+  if(delta > (int64_t)nominalCycleNs_ / 2 && delta < (int64_t)(nominalCycleNs_ * 3 / 2)) {
+    cycleNs_ += ECMC_SCOPE_TIMEBASE_FILTER_GAIN * ((double)delta - cycleNs_);
+  }
+  return nexttime_;
+}
+
+uint64_t ecmcScopeTimebase::unwrap(uint64_t time) {
+  return nexttime_ + rawDiff(time, nexttime_);
+}
+
+uint64_t ecmcScopeTimebase::getNexttime() {
+  return nexttime_;
+}
+
+double ecmcScopeTimebase::getCycleNs() {
+  return cycleNs_;
+}
+
+double ecmcScopeTimebase::getSamplePeriodNs() {
+  return cycleNs_ / samplesPerCycle_;
+}
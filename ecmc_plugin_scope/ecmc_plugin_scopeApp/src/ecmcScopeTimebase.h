@@ -0,0 +1,58 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeTimebase.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_TIMEBASE_H_
+#define ECMC_SCOPE_TIMEBASE_H_
+
+#include <stddef.h>
+#include <stdexcept>
+#include "inttypes.h"
+
+// Gain of cycle time tracking filter (first order)
+#define ECMC_SCOPE_TIMEBASE_FILTER_GAIN 0.01
+
+/** Dc timebase of a source
+ *  Unwraps NEXT_TIME (32 or 64 bit) into a continuous 64 bit timeline and
+ *  tracks the true cycle time from consecutive NEXT_TIME deltas. Timestamps
+ *  (latch values) are unwrapped relative to the current NEXT_TIME, so 32 bit
+ *  timestamps must be within +-2^31ns (approx 2s) of NEXT_TIME.
+ *  Deltas that are not close to the nominal cycle time (lost frames, bus
+ *  restart) are not used for tracking.
+*/
+class ecmcScopeTimebase {
+ public:
+  ecmcScopeTimebase(uint64_t cycleNs,
+                    int64_t  samplesPerCycle,
+                    size_t   bitCount);
+  ~ecmcScopeTimebase();
+
+  // Start over (next update() defines the timeline)
+  void                  reset();
+  // New NEXT_TIME (once per cycle). Returns unwrapped NEXT_TIME.
+  uint64_t              update(uint64_t nexttime);
+  // Unwrap timestamp to timeline
+  uint64_t              unwrap(uint64_t time);
+  uint64_t              getNexttime();
+  double                getCycleNs();
+  double                getSamplePeriodNs();
+
+ private:
+  int64_t               rawDiff(uint64_t a, uint64_t b);
+
+  uint64_t              nominalCycleNs_;
+  int64_t               samplesPerCycle_;
+  size_t                bitCount_;
+  uint64_t              nexttime_;
+  double                cycleNs_;
+  int                   valid_;
+};
+
+#endif  /* ECMC_SCOPE_TIMEBASE_H_ */
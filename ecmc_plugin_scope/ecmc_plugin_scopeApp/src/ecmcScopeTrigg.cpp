@@ -0,0 +1,426 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeTrigg.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+// Needed to get headers in ecmc right...
+#define ECMC_IS_PLUGIN
+
+#include <string.h>
+#include "ecmcScopeTrigg.h"
+
+ecmcScopeTrigg::ecmcScopeTrigg() {
+  memset(items_,0,sizeof(items_));
+  memset(itemInfos_,0,sizeof(itemInfos_));
+  memset(lastValue_,0,sizeof(lastValue_));
+  memset(pending_,0,sizeof(pending_));
+  memset(pendingTime_,0,sizeof(pendingTime_));
+  memset(eventSource_,0,sizeof(eventSource_));
+  memset(eventTime_,0,sizeof(eventTime_));
+  for(int i = 0; i < ECMC_SCOPE_TRIGG_MAX_SOURCES; ++i) {
+    firstEvent_[i] = 1;  // Avoid first trigger (0 timestamp..)
+  }
+  memset(above_,0,sizeof(above_));
+  eventCount_      = 0;
+  sourceCount_     = 0;
+  type_            = ECMC_SCOPE_TRIGG_TYPE_LATCH;
+  level_           = 0;
+  nexttimeItem_    = NULL;
+  nexttimeInfo_    = NULL;
+  cycleNs_         = 0;
+  recorded_         = NULL;
+  recordedNexttime_ = 0;
+  bitCount_        = 64;
+  logic_           = ECMC_SCOPE_TRIGG_LOGIC_OR;
+  windowNs_        = 0;
+  seqTimeoutNs_    = 0;
+  holdoffNs_       = 0;
+  prescale_        = 1;
+  prescaleCounter_ = 0;
+  seqStage_        = 0;
+  seqStageTime_    = 0;
+  lastTriggTime_   = 0;
+  lastTriggValid_  = 0;
+
+  evalFuncs_[ECMC_SCOPE_TRIGG_LOGIC_OR]  = &ecmcScopeTrigg::evalOr;
+  evalFuncs_[ECMC_SCOPE_TRIGG_LOGIC_AND] = &ecmcScopeTrigg::evalAnd;
+  evalFuncs_[ECMC_SCOPE_TRIGG_LOGIC_SEQ] = &ecmcScopeTrigg::evalSeq;
+}
+
+ecmcScopeTrigg::~ecmcScopeTrigg() {
+}
+
+void ecmcScopeTrigg::setType(int type, double level) {
+  if(type < 0 || type >= ECMC_SCOPE_TRIGG_TYPE_COUNT) {
+    throw std::invalid_argument( "ERROR: Invalid trigger type.");
+  }
+  if(sourceCount_ > 0) {
+    throw std::invalid_argument( "ERROR: Trigger type must be set before sources are added.");
+  }
+  type_  = type;
+  level_ = level;
+  // Values are valid from start (no 0 timestamp)
+  for(int i = 0; i < ECMC_SCOPE_TRIGG_MAX_SOURCES; ++i) {
+    firstEvent_[i] = type_ == ECMC_SCOPE_TRIGG_TYPE_LATCH;
+  }
+}
+
+void ecmcScopeTrigg::setCycleSource(ecmcDataItem *nexttime, uint64_t cycleNs) {
+  if(!nexttime || !nexttime->getDataItemInfo()) {
+    throw std::runtime_error( "ERROR: Trigg nexttime dataitem NULL." );
+  }
+  if(cycleNs == 0) {
+    throw std::out_of_range( "ERROR: Trigg cycle time must be > 0ns." );
+  }
+  nexttimeItem_ = nexttime;
+  nexttimeInfo_ = nexttime->getDataItemInfo();
+  cycleNs_      = cycleNs;
+  // Event times in NEXT_TIME format
+  if(type_ != ECMC_SCOPE_TRIGG_TYPE_LATCH && nexttimeInfo_->dataBitCount < bitCount_) {
+    bitCount_ = nexttimeInfo_->dataBitCount < 32 ? 32 : nexttimeInfo_->dataBitCount;
+  }
+}
+
+bool ecmcScopeTrigg::isCycleAligned() {
+  return type_ != ECMC_SCOPE_TRIGG_TYPE_LATCH;
+}
+
+void ecmcScopeTrigg::addSource(ecmcDataItem *item) {
+  if(sourceCount_ >= ECMC_SCOPE_TRIGG_MAX_SOURCES) {
+    throw std::invalid_argument( "ERROR: Too many trigger sources.");
+  }
+  if(!item) {
+    throw std::runtime_error( "ERROR: Trigg dataitem NULL." );
+  }
+
+  ecmcDataItemInfo *info = item->getDataItemInfo();
+  if(!info) {
+    throw std::runtime_error( "ERROR: Trigg dataitem info NULL." );
+  }
+
+  if(type_ != ECMC_SCOPE_TRIGG_TYPE_LATCH && !nexttimeItem_) {
+    throw std::runtime_error( "ERROR: Trigg nexttime dataitem NULL." );
+  }
+
+  addSourceInfo(item, info);
+  reset();
+}
+
+void ecmcScopeTrigg::addRecordedSource(ecmcDataItemInfo *info) {
+  if(sourceCount_ >= ECMC_SCOPE_TRIGG_MAX_SOURCES) {
+    throw std::invalid_argument( "ERROR: Too many trigger sources.");
+  }
+  if(!info) {
+    throw std::runtime_error( "ERROR: Trigg dataitem info NULL." );
+  }
+  addSourceInfo(NULL, info);
+}
+
+void ecmcScopeTrigg::addSourceInfo(ecmcDataItem *item, ecmcDataItemInfo *info) {
+  if(type_ == ECMC_SCOPE_TRIGG_TYPE_LATCH && info->dataBitCount < bitCount_) {
+    bitCount_ = info->dataBitCount < 32 ? 32 : info->dataBitCount;
+  }
+  items_[sourceCount_]     = item;
+  itemInfos_[sourceCount_] = info;
+  sourceCount_++;
+}
+
+void ecmcScopeTrigg::setRecordedCycle(uint64_t cycleNs, size_t nexttimeBits) {
+  cycleNs_ = cycleNs;
+  if(type_ != ECMC_SCOPE_TRIGG_TYPE_LATCH && nexttimeBits < bitCount_) {
+    bitCount_ = nexttimeBits < 32 ? 32 : nexttimeBits;
+  }
+}
+
+void ecmcScopeTrigg::resetRecorded(const uint64_t *values) {
+  recorded_ = values;
+  reset();
+  recorded_ = NULL;
+}
+
+int ecmcScopeTrigg::evaluateRecorded(const uint64_t *values,
+                                     uint64_t nexttime,
+                                     uint64_t *triggTime) {
+  recorded_         = values;
+  recordedNexttime_ = nexttime;
+  int eval = evaluate(triggTime);
+  recorded_         = NULL;
+  return eval;
+}
+
+void ecmcScopeTrigg::readSources(uint64_t *values) {
+  for(int i = 0; i < sourceCount_; ++i) {
+    values[i] = readSource(i);
+  }
+}
+
+void ecmcScopeTrigg::setLogic(int logic,
+                              int64_t windowNs,
+                              int64_t seqTimeoutNs,
+                              int64_t holdoffNs,
+                              int prescale) {
+  if(logic < 0 || logic >= ECMC_SCOPE_TRIGG_LOGIC_COUNT) {
+    throw std::invalid_argument( "ERROR: Invalid trigger logic.");
+  }
+  if(windowNs < 0 || seqTimeoutNs < 0 || holdoffNs < 0 || prescale < 1) {
+    throw std::invalid_argument( "ERROR: Invalid trigger window, timeout, holdoff or prescale.");
+  }
+  logic_        = logic;
+  windowNs_     = windowNs;
+  seqTimeoutNs_ = seqTimeoutNs;
+  holdoffNs_    = holdoffNs;
+  prescale_     = prescale;
+}
+
+size_t ecmcScopeTrigg::getBitCount() {
+  return bitCount_;
+}
+
+int ecmcScopeTrigg::getSourceCount() {
+  return sourceCount_;
+}
+
+ecmcDataItemInfo *ecmcScopeTrigg::getSourceInfo(int index) {
+  return itemInfos_[index];
+}
+
+// Raw value (first element, max 8 bytes). Read in place if possible.
+uint64_t ecmcScopeTrigg::readSource(int index) {
+  // Replay: recorded values
+  if(recorded_) {
+    return recorded_[index];
+  }
+  uint64_t value = 0;
+  size_t bytes = itemInfos_[index]->dataElementSize;
+  if(bytes > sizeof(value)) {
+    bytes = sizeof(value);
+  }
+  if(itemInfos_[index]->data && itemInfos_[index]->dataPointerValid) {
+    memcpy(&value, itemInfos_[index]->data, bytes);
+    return value;
+  }
+  if(items_[index]->read((uint8_t*)&value,bytes)) {
+    throw std::runtime_error( "ERROR: Failed read trigg source." );
+  }
+  return value;
+}
+
+double ecmcScopeTrigg::rawToDouble(uint64_t raw, ecmcEcDataType dt) {
+  switch(dt) {
+    case ECMC_EC_S8:
+      return (double)(int8_t)raw;
+    case ECMC_EC_S16:
+      return (double)(int16_t)raw;
+    case ECMC_EC_S32:
+      return (double)(int32_t)raw;
+    case ECMC_EC_S64:
+      return (double)(int64_t)raw;
+    case ECMC_EC_U8:
+      return (double)(uint8_t)raw;
+    case ECMC_EC_U16:
+      return (double)(uint16_t)raw;
+    case ECMC_EC_U32:
+      return (double)(uint32_t)raw;
+    case ECMC_EC_F32: {
+      float value;
+      uint32_t raw32 = (uint32_t)raw;
+      memcpy(&value, &raw32, sizeof(value));
+      return (double)value;
+    }
+    case ECMC_EC_F64: {
+      double value;
+      memcpy(&value, &raw, sizeof(value));
+      return value;
+    }
+    case ECMC_EC_B1:
+      return (double)(raw & 0x1);
+    case ECMC_EC_B2:
+      return (double)(raw & 0x3);
+    case ECMC_EC_B3:
+      return (double)(raw & 0x7);
+    case ECMC_EC_B4:
+      return (double)(raw & 0xF);
+    default:
+      return (double)raw;
+  }
+}
+
+/** Value trigger types: one compare per cycle (raw value for CHANGE,
+ *  level for RISING/FALLING/CROSS).
+*/
+bool ecmcScopeTrigg::valueEvent(int index) {
+  uint64_t value = readSource(index);
+  if(value == lastValue_[index]) {
+    return false;
+  }
+  lastValue_[index] = value;
+  if(type_ == ECMC_SCOPE_TRIGG_TYPE_CHANGE) {
+    return true;
+  }
+  int above = rawToDouble(value, itemInfos_[index]->dataType) > level_;
+  if(above == above_[index]) {
+    return false;
+  }
+  above_[index] = above;
+  return type_ == ECMC_SCOPE_TRIGG_TYPE_CROSS ||
+         (type_ == ECMC_SCOPE_TRIGG_TYPE_RISING && above) ||
+         (type_ == ECMC_SCOPE_TRIGG_TYPE_FALLING && !above);
+}
+
+void ecmcScopeTrigg::reset() {
+  for(int i = 0; i < sourceCount_; ++i) {
+    lastValue_[i] = readSource(i);
+    above_[i]     = rawToDouble(lastValue_[i], itemInfos_[i]->dataType) > level_;
+    pending_[i]   = 0;
+  }
+  seqStage_   = 0;
+  eventCount_ = 0;
+}
+
+int64_t ecmcScopeTrigg::timeDiff(uint64_t a, uint64_t b) {
+  if(bitCount_ < 64) {
+    return (int64_t)(int32_t)((uint32_t)a - (uint32_t)b);
+  }
+  return (int64_t)(a - b);
+}
+
+int ecmcScopeTrigg::evaluate(uint64_t *triggTime) {
+
+  // Collect events of this cycle (changed timestamps)
+  eventCount_ = 0;
+  uint64_t cycleTime = 0;
+  bool     cycleTimeRead = false;
+  for(int i = 0; i < sourceCount_; ++i) {
+    uint64_t value = 0;
+    if(type_ == ECMC_SCOPE_TRIGG_TYPE_LATCH) {
+      value = readSource(i);
+      if(value == lastValue_[i]) {
+        continue;
+      }
+      lastValue_[i] = value;
+    }
+    else {
+      if(!valueEvent(i)) {
+        continue;
+      }
+      // Event time: first sample of current scan (NEXT_TIME - one cycle)
+      if(!cycleTimeRead) {
+        if(recorded_) {
+          cycleTime = recordedNexttime_;
+        }
+        else if(nexttimeItem_->read((uint8_t*)&cycleTime, nexttimeInfo_->dataElementSize)) {
+          throw std::runtime_error( "ERROR: Failed read trigg nexttime." );
+        }
+        cycleTime    -= cycleNs_;
+        cycleTimeRead = true;
+      }
+      value = cycleTime;
+    }
+    if(firstEvent_[i]) {
+      firstEvent_[i] = 0;
+      continue;
+    }
+
+    // Insert sorted on time (max ECMC_SCOPE_TRIGG_MAX_SOURCES)
+    int pos = eventCount_;
+    while(pos > 0 && timeDiff(eventTime_[pos - 1], value) > 0) {
+      eventSource_[pos] = eventSource_[pos - 1];
+      eventTime_[pos]   = eventTime_[pos - 1];
+      pos--;
+    }
+    eventSource_[pos] = i;
+    eventTime_[pos]   = value;
+    eventCount_++;
+  }
+
+  if(eventCount_ == 0) {
+    return ECMC_SCOPE_TRIGG_EVAL_NONE;
+  }
+
+  uint64_t time = 0;
+  if(!(this->*evalFuncs_[logic_])(&time)) {
+    return ECMC_SCOPE_TRIGG_EVAL_NONE;
+  }
+  *triggTime = time;
+
+  // Holdoff
+  if(lastTriggValid_ && timeDiff(time, lastTriggTime_) < holdoffNs_) {
+    return ECMC_SCOPE_TRIGG_EVAL_HOLDOFF;
+  }
+  lastTriggTime_  = time;
+  lastTriggValid_ = 1;
+
+  // Prescale (every n:th trigger)
+  prescaleCounter_++;
+  if(prescaleCounter_ < prescale_) {
+    return ECMC_SCOPE_TRIGG_EVAL_PRESCALE;
+  }
+  prescaleCounter_ = 0;
+
+  return ECMC_SCOPE_TRIGG_EVAL_NEW;
+}
+
+// Earliest event of this cycle
+bool ecmcScopeTrigg::evalOr(uint64_t *triggTime) {
+  *triggTime = eventTime_[0];
+  return true;
+}
+
+// All sources within window (trigger time = time of last event)
+bool ecmcScopeTrigg::evalAnd(uint64_t *triggTime) {
+  for(int e = 0; e < eventCount_; ++e) {
+    uint64_t time = eventTime_[e];
+    pending_[eventSource_[e]]     = 1;
+    pendingTime_[eventSource_[e]] = time;
+
+    int all = 1;
+    for(int i = 0; i < sourceCount_; ++i) {
+      if(pending_[i] && timeDiff(time, pendingTime_[i]) > windowNs_) {
+        pending_[i] = 0;  // expired
+      }
+      all &= pending_[i];
+    }
+
+    if(all) {
+      memset(pending_,0,sizeof(pending_));
+      *triggTime = time;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Sources in configured order, each within timeout from previous
+bool ecmcScopeTrigg::evalSeq(uint64_t *triggTime) {
+  for(int e = 0; e < eventCount_; ++e) {
+    int      source = eventSource_[e];
+    uint64_t time   = eventTime_[e];
+
+    if(seqStage_ > 0 && timeDiff(time, seqStageTime_) > seqTimeoutNs_) {
+      seqStage_ = 0;  // timeout, start over
+    }
+
+    if(source == seqStage_) {
+      seqStage_++;
+      seqStageTime_ = time;
+    }
+    else if(source == 0) {
+      seqStage_     = 1;  // restart sequence
+      seqStageTime_ = time;
+    }
+
+    if(seqStage_ >= sourceCount_) {
+      seqStage_  = 0;
+      *triggTime = time;
+      return true;
+    }
+  }
+  return false;
+}
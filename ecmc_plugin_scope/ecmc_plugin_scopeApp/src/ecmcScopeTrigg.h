@@ -0,0 +1,137 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeTrigg.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_TRIGG_H_
+#define ECMC_SCOPE_TRIGG_H_
+
+#include <stdexcept>
+#include "ecmcDataItem.h"
+#include "inttypes.h"
+
+#define ECMC_SCOPE_TRIGG_MAX_SOURCES 8
+
+typedef enum {
+    ECMC_SCOPE_TRIGG_LOGIC_OR,    /**Any source. */
+    ECMC_SCOPE_TRIGG_LOGIC_AND,   /**All sources within window. */
+    ECMC_SCOPE_TRIGG_LOGIC_SEQ,   /**Sources in configured order within timeout. */
+    ECMC_SCOPE_TRIGG_LOGIC_COUNT,
+} ecmcScopeTriggLogic;
+
+typedef enum {
+    ECMC_SCOPE_TRIGG_TYPE_LATCH,    /**Timestamp change (trigger time = timestamp). */
+    ECMC_SCOPE_TRIGG_TYPE_CHANGE,   /**Value change. */
+    ECMC_SCOPE_TRIGG_TYPE_RISING,   /**Value passes level upwards. */
+    ECMC_SCOPE_TRIGG_TYPE_FALLING,  /**Value passes level downwards. */
+    ECMC_SCOPE_TRIGG_TYPE_CROSS,    /**Value passes level (any direction). */
+    ECMC_SCOPE_TRIGG_TYPE_COUNT,
+} ecmcScopeTriggType;
+
+typedef enum {
+    ECMC_SCOPE_TRIGG_EVAL_NONE,      /**No trigger this cycle. */
+    ECMC_SCOPE_TRIGG_EVAL_NEW,       /**New trigger. */
+    ECMC_SCOPE_TRIGG_EVAL_HOLDOFF,   /**Trigger disregarded (within holdoff). */
+    ECMC_SCOPE_TRIGG_EVAL_PRESCALE,  /**Trigger disregarded (prescaling). */
+} ecmcScopeTriggEval;
+
+/** Trigger engine
+ *  Combines several trigger timestamp sources (latch values). A source
+ *  event is a change of the timestamp value. The events of one cycle are
+ *  evaluated once per cycle by the function of the configured logic
+ *  (table lookup), then holdoff and prescaling are applied.
+ *  Value trigger types (any data item, first element) have no timestamp of
+ *  their own. An event is a value change or a pass of the level and the
+ *  event time is NEXT_TIME - one cycle (first sample of current scan).
+ *  This object can throw:
+ *    - invalid_argument
+ *    - runtime_error
+*/
+class ecmcScopeTrigg {
+ public:
+  ecmcScopeTrigg();
+  ~ecmcScopeTrigg();
+
+  // Type and cycle source must be set before sources are added
+  void                  setType(int type, double level);
+  void                  setCycleSource(ecmcDataItem *nexttime, uint64_t cycleNs);
+  // Trigger time is NEXT_TIME - one cycle (value trigger types)
+  bool                  isCycleAligned();
+  void                  addSource(ecmcDataItem *item);
+  // Replay: sources are recorded values (raw, one uint64 per source)
+  void                  addRecordedSource(ecmcDataItemInfo *info);
+  void                  setRecordedCycle(uint64_t cycleNs, size_t nexttimeBits);
+  void                  resetRecorded(const uint64_t *values);
+  int                   evaluateRecorded(const uint64_t *values,
+                                         uint64_t nexttime,
+                                         uint64_t *triggTime);
+  // Sub rate: read sources (raw, one uint64 per source) for evaluateRecorded()
+  void                  readSources(uint64_t *values);
+  void                  setLogic(int logic,
+                                 int64_t windowNs,
+                                 int64_t seqTimeoutNs,
+                                 int64_t holdoffNs,
+                                 int prescale);
+  // Bits valid in trigger time (32 or 64)
+  size_t                getBitCount();
+  int                   getSourceCount();
+  ecmcDataItemInfo     *getSourceInfo(int index);
+  // Current values used as reference (no trigger)
+  void                  reset();
+  // Read sources. Returns ecmcScopeTriggEval (trigger time in triggTime).
+  int                   evaluate(uint64_t *triggTime);
+  // Signed diff a - b (handles 32bit wrap)
+  int64_t               timeDiff(uint64_t a, uint64_t b);
+
+ private:
+  typedef bool (ecmcScopeTrigg::*evalFunc)(uint64_t *triggTime);
+  bool                  evalOr(uint64_t *triggTime);
+  bool                  evalAnd(uint64_t *triggTime);
+  bool                  evalSeq(uint64_t *triggTime);
+  uint64_t              readSource(int index);
+  void                  addSourceInfo(ecmcDataItem *item, ecmcDataItemInfo *info);
+  bool                  valueEvent(int index);
+  static double         rawToDouble(uint64_t raw, ecmcEcDataType dt);
+
+  ecmcDataItem         *items_[ECMC_SCOPE_TRIGG_MAX_SOURCES];
+  ecmcDataItemInfo     *itemInfos_[ECMC_SCOPE_TRIGG_MAX_SOURCES];
+  uint64_t              lastValue_[ECMC_SCOPE_TRIGG_MAX_SOURCES];
+  int                   firstEvent_[ECMC_SCOPE_TRIGG_MAX_SOURCES];
+  int                   pending_[ECMC_SCOPE_TRIGG_MAX_SOURCES];
+  uint64_t              pendingTime_[ECMC_SCOPE_TRIGG_MAX_SOURCES];
+
+  // Events of current cycle (sorted on time)
+  int                   eventSource_[ECMC_SCOPE_TRIGG_MAX_SOURCES];
+  uint64_t              eventTime_[ECMC_SCOPE_TRIGG_MAX_SOURCES];
+  int                   eventCount_;
+
+  int                   sourceCount_;
+  int                   type_;
+  double                level_;
+  int                   above_[ECMC_SCOPE_TRIGG_MAX_SOURCES];  // Value above level (last cycle)
+  ecmcDataItem         *nexttimeItem_;
+  ecmcDataItemInfo     *nexttimeInfo_;
+  uint64_t              cycleNs_;
+  const uint64_t       *recorded_;          // Replay values of current evaluation
+  uint64_t              recordedNexttime_;
+  size_t                bitCount_;
+  int                   logic_;
+  evalFunc              evalFuncs_[ECMC_SCOPE_TRIGG_LOGIC_COUNT];
+  int64_t               windowNs_;
+  int64_t               seqTimeoutNs_;
+  int64_t               holdoffNs_;
+  int                   prescale_;
+  int                   prescaleCounter_;
+  int                   seqStage_;
+  uint64_t              seqStageTime_;
+  uint64_t              lastTriggTime_;
+  int                   lastTriggValid_;
+};
+
+#endif  /* ECMC_SCOPE_TRIGG_H_ */
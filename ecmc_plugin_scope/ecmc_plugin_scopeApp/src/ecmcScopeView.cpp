@@ -0,0 +1,332 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeView.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+*  Captures are handed over in a triple buffer: rt writes the back buffer
+*  and swaps it with the middle buffer, the worker swaps the middle buffer
+*  with its front buffer when a new capture is flagged.
+*
+\*************************************************************************/
+
+// Needed to get headers in ecmc right...
+#define ECMC_IS_PLUGIN
+
+#include <string.h>
+#include <stdio.h>
+#include "ecmcScopeView.h"
+
+#define ECMC_SCOPE_VIEW_FRESH 4   // Flag in middle index: not yet seen by worker
+
+template <typename T>
+static void decimate(const uint8_t *src,
+                     double        *dst,
+                     size_t         length,
+                     size_t         points) {
+  const T *data = (const T*)src;
+  for(size_t i = 0; i < points; ++i) {
+    dst[i] = (double)data[i * length / points];
+  }
+}
+
+template <typename T>
+static void minMax(const uint8_t *src,
+                   double        *dst,
+                   size_t         length,
+                   size_t         points) {
+  const T *data = (const T*)src;
+  for(size_t i = 0; i < points; ++i) {
+    size_t first = i * length / points;
+    size_t last  = (i + 1) * length / points;
+    T min = data[first];
+    T max = data[first];
+    for(size_t j = first + 1; j < last; ++j) {
+      min = data[j] < min ? data[j] : min;
+      max = data[j] > max ? data[j] : max;
+    }
+    dst[2 * i]     = (double)min;
+    dst[2 * i + 1] = (double)max;
+  }
+}
+
+ecmcScopeView::ecmcScopeView(size_t         elements,
+                             int            maxPoints,
+                             ecmcEcDataType dt,
+                             int            objId) {
+  if(elements == 0 || maxPoints < 1) {
+    throw std::invalid_argument( "ERROR: Invalid view elements or points.");
+  }
+  elements_     = elements;
+  maxPoints_    = maxPoints;
+  dt_           = dt;
+  backIndex_    = 0;
+  middleIndex_  = 1;
+  frontIndex_   = 2;
+  frontValid_   = 0;
+  viewBytes_    = 0;
+  viewReady_    = 0;
+  startReq_     = 0;
+  lengthReq_    = (int32_t)elements;
+  pointsReq_    = maxPoints;
+  modeReq_      = ECMC_SCOPE_VIEW_MINMAX;
+  stop_         = 0;
+  workEvent_    = NULL;
+  exitEvent_    = NULL;
+  buffers_      = NULL;
+  view_         = NULL;
+
+  switch(dt_) {
+    case ECMC_EC_U8:
+    case ECMC_EC_S8:
+      captureBytes_ = elements_;
+      break;
+    case ECMC_EC_U16:
+    case ECMC_EC_S16:
+      captureBytes_ = elements_ * 2;
+      break;
+    case ECMC_EC_U32:
+    case ECMC_EC_S32:
+    case ECMC_EC_F32:
+      captureBytes_ = elements_ * 4;
+      break;
+    case ECMC_EC_U64:
+    case ECMC_EC_S64:
+    case ECMC_EC_F64:
+      captureBytes_ = elements_ * 8;
+      break;
+    default:
+      throw std::invalid_argument( "ERROR: Data type not supported for view.");
+  }
+
+  buffers_ = new uint8_t[captureBytes_ * 3];
+  view_    = new double[maxPoints_ * 2];
+  memset(buffers_, 0, captureBytes_ * 3);
+  memset(view_, 0, sizeof(double) * maxPoints_ * 2);
+
+  workEvent_ = epicsEventCreate(epicsEventEmpty);
+  exitEvent_ = epicsEventCreate(epicsEventEmpty);
+  if(!workEvent_ || !exitEvent_) {
+    release();
+    throw std::runtime_error( "ERROR: Failed create view events.");
+  }
+
+  char threadName[64];
+  snprintf(threadName, sizeof(threadName), "ecmcScopeView%d", objId);
+  if(!epicsThreadCreate(threadName,
+                        epicsThreadPriorityLow,
+                        epicsThreadGetStackSize(epicsThreadStackMedium),
+                        workerThread,
+                        this)) {
+    release();
+    throw std::runtime_error( "ERROR: Failed create view thread.");
+  }
+}
+
+ecmcScopeView::~ecmcScopeView() {
+  // Stop worker
+  __atomic_store_n(&stop_, 1, __ATOMIC_RELEASE);
+  epicsEventSignal(workEvent_);
+  epicsEventWait(exitEvent_);
+  release();
+}
+
+// Free buffers and events (worker not running)
+void ecmcScopeView::release() {
+  if(workEvent_) {
+    epicsEventDestroy(workEvent_);
+    workEvent_ = NULL;
+  }
+  if(exitEvent_) {
+    epicsEventDestroy(exitEvent_);
+    exitEvent_ = NULL;
+  }
+  delete[] buffers_;
+  delete[] view_;
+  buffers_ = NULL;
+  view_    = NULL;
+}
+
+void ecmcScopeView::add(const uint8_t *data) {
+  memcpy(&buffers_[backIndex_ * captureBytes_], data, captureBytes_);
+  backIndex_ = __atomic_exchange_n(&middleIndex_, backIndex_ | ECMC_SCOPE_VIEW_FRESH,
+                                   __ATOMIC_ACQ_REL) & ~ECMC_SCOPE_VIEW_FRESH;
+  epicsEventSignal(workEvent_);
+}
+
+bool ecmcScopeView::viewReady() {
+  return __atomic_load_n(&viewReady_, __ATOMIC_ACQUIRE) != 0;
+}
+
+void ecmcScopeView::viewDone() {
+  __atomic_store_n(&viewReady_, 0, __ATOMIC_RELEASE);
+}
+
+double *ecmcScopeView::getView() {
+  return view_;
+}
+
+size_t ecmcScopeView::getViewBytes() {
+  return viewBytes_;
+}
+
+size_t ecmcScopeView::getViewMaxBytes() {
+  return sizeof(double) * maxPoints_ * 2;
+}
+
+int32_t *ecmcScopeView::getStartReq() {
+  return &startReq_;
+}
+
+int32_t *ecmcScopeView::getLengthReq() {
+  return &lengthReq_;
+}
+
+int32_t *ecmcScopeView::getPointsReq() {
+  return &pointsReq_;
+}
+
+int32_t *ecmcScopeView::getModeReq() {
+  return &modeReq_;
+}
+
+void ecmcScopeView::workerThread(void *obj) {
+  ((ecmcScopeView*)obj)->work();
+}
+
+void ecmcScopeView::work() {
+  int32_t lastReq[4] = {-1, -1, -1, -1};
+  int     pending    = 0;
+
+  while(!__atomic_load_n(&stop_, __ATOMIC_ACQUIRE)) {
+    epicsEventWaitWithTimeout(workEvent_, ECMC_SCOPE_VIEW_POLL_S);
+
+    // New capture
+    if(__atomic_load_n(&middleIndex_, __ATOMIC_ACQUIRE) & ECMC_SCOPE_VIEW_FRESH) {
+      frontIndex_ = __atomic_exchange_n(&middleIndex_, frontIndex_, __ATOMIC_ACQ_REL) &
+                    ~ECMC_SCOPE_VIEW_FRESH;
+      frontValid_ = 1;
+      pending     = 1;
+    }
+
+    // New request
+    int32_t req[4];
+    req[0] = __atomic_load_n(&startReq_, __ATOMIC_ACQUIRE);
+    req[1] = __atomic_load_n(&lengthReq_, __ATOMIC_ACQUIRE);
+    req[2] = __atomic_load_n(&pointsReq_, __ATOMIC_ACQUIRE);
+    req[3] = __atomic_load_n(&modeReq_, __ATOMIC_ACQUIRE);
+    if(memcmp(req, lastReq, sizeof(req))) {
+      memcpy(lastReq, req, sizeof(req));
+      pending = 1;
+    }
+
+    // Build (only if last view is published)
+    if(!pending || !frontValid_ || viewReady()) {
+      continue;
+    }
+    pending = 0;
+
+    // Clamp window to capture
+    size_t start  = req[0] > 0 ? (size_t)req[0] : 0;
+    if(start >= elements_) {
+      start = elements_ - 1;
+    }
+    size_t length = req[1] > 0 ? (size_t)req[1] : elements_;
+    if(length > elements_ - start) {
+      length = elements_ - start;
+    }
+    size_t points = req[2] > 0 ? (size_t)req[2] : (size_t)maxPoints_;
+    if(points > (size_t)maxPoints_) {
+      points = maxPoints_;
+    }
+    if(points > length) {
+      points = length;
+    }
+
+    buildView(&buffers_[frontIndex_ * captureBytes_ + start * (captureBytes_ / elements_)],
+              length, points, req[3]);
+    __atomic_store_n(&viewReady_, 1, __ATOMIC_RELEASE);
+  }
+  epicsEventSignal(exitEvent_);
+}
+
+// Reduce length elements of data to points values (or min/max pairs)
+void ecmcScopeView::buildView(const uint8_t *data,
+                              size_t length,
+                              size_t points,
+                              int mode) {
+  if(mode == ECMC_SCOPE_VIEW_DECIMATE) {
+    switch(dt_) {
+      case ECMC_EC_U8:
+        decimate<uint8_t>(data, view_, length, points);
+        break;
+      case ECMC_EC_S8:
+        decimate<int8_t>(data, view_, length, points);
+        break;
+      case ECMC_EC_U16:
+        decimate<uint16_t>(data, view_, length, points);
+        break;
+      case ECMC_EC_S16:
+        decimate<int16_t>(data, view_, length, points);
+        break;
+      case ECMC_EC_U32:
+        decimate<uint32_t>(data, view_, length, points);
+        break;
+      case ECMC_EC_S32:
+        decimate<int32_t>(data, view_, length, points);
+        break;
+      case ECMC_EC_U64:
+        decimate<uint64_t>(data, view_, length, points);
+        break;
+      case ECMC_EC_S64:
+        decimate<int64_t>(data, view_, length, points);
+        break;
+      case ECMC_EC_F32:
+        decimate<float>(data, view_, length, points);
+        break;
+      default:
+        decimate<double>(data, view_, length, points);
+        break;
+    }
+    viewBytes_ = sizeof(double) * points;
+    return;
+  }
+
+  switch(dt_) {
+    case ECMC_EC_U8:
+      minMax<uint8_t>(data, view_, length, points);
+      break;
+    case ECMC_EC_S8:
+      minMax<int8_t>(data, view_, length, points);
+      break;
+    case ECMC_EC_U16:
+      minMax<uint16_t>(data, view_, length, points);
+      break;
+    case ECMC_EC_S16:
+      minMax<int16_t>(data, view_, length, points);
+      break;
+    case ECMC_EC_U32:
+      minMax<uint32_t>(data, view_, length, points);
+      break;
+    case ECMC_EC_S32:
+      minMax<int32_t>(data, view_, length, points);
+      break;
+    case ECMC_EC_U64:
+      minMax<uint64_t>(data, view_, length, points);
+      break;
+    case ECMC_EC_S64:
+      minMax<int64_t>(data, view_, length, points);
+      break;
+    case ECMC_EC_F32:
+      minMax<float>(data, view_, length, points);
+      break;
+    default:
+      minMax<double>(data, view_, length, points);
+      break;
+  }
+  viewBytes_ = sizeof(double) * points * 2;
+}
@@ -0,0 +1,93 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeView.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_VIEW_H_
+#define ECMC_SCOPE_VIEW_H_
+
+#include <stdexcept>
+#include "ecmcDataItem.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "inttypes.h"
+
+#define ECMC_SCOPE_VIEW_POLL_S 0.1   // Worker poll of view request
+
+typedef enum {
+    ECMC_SCOPE_VIEW_DECIMATE,     /**One sample per point. */
+    ECMC_SCOPE_VIEW_MINMAX,       /**Min and max per point (pairs). */
+} ecmcScopeViewMode;
+
+/** Windowed readout of last capture
+ *  A window (start, length in elements) of the last capture is reduced to
+ *  at most "points" values (decimation) or min/max pairs in a worker
+ *  thread. The request cells are written directly over asyn and polled by
+ *  the worker. rt only hands over captures (triple buffer, never waits) and
+ *  publishes the view when ready.
+ *  This object can throw:
+ *    - bad_alloc
+ *    - invalid_argument
+ *    - runtime_error
+*/
+class ecmcScopeView {
+ public:
+  ecmcScopeView(size_t         elements,
+                int            maxPoints,
+                ecmcEcDataType dt,
+                int            objId);
+  ~ecmcScopeView();
+
+  // rt: hand over capture (elements of dt)
+  void                  add(const uint8_t *data);
+  // rt: new view available
+  bool                  viewReady();
+  // rt: view published (worker may build next)
+  void                  viewDone();
+  double               *getView();
+  // Bytes of current view (valid while viewReady())
+  size_t                getViewBytes();
+  size_t                getViewMaxBytes();
+  // Request cells (asyn)
+  int32_t              *getStartReq();
+  int32_t              *getLengthReq();
+  int32_t              *getPointsReq();
+  int32_t              *getModeReq();
+
+ private:
+  static void           workerThread(void *obj);
+  void                  work();
+  void                  release();
+  void                  buildView(const uint8_t *data,
+                                  size_t length,
+                                  size_t points,
+                                  int mode);
+
+  size_t                elements_;
+  int                   maxPoints_;
+  ecmcEcDataType        dt_;
+  size_t                captureBytes_;
+  uint8_t              *buffers_;        // Triple buffer of captures
+  int                   backIndex_;      // rt only
+  int                   middleIndex_;    // Shared (ECMC_SCOPE_VIEW_FRESH if new capture)
+  int                   frontIndex_;     // Worker only
+  int                   frontValid_;     // Worker only
+  double               *view_;           // Worker writes if !viewReady_, rt reads if viewReady_
+  size_t                viewBytes_;
+  int                   viewReady_;
+  int32_t               startReq_;
+  int32_t               lengthReq_;
+  int32_t               pointsReq_;
+  int32_t               modeReq_;
+  int                   stop_;
+  epicsEventId          workEvent_;
+  epicsEventId          exitEvent_;
+};
+
+#endif  /* ECMC_SCOPE_VIEW_H_ */
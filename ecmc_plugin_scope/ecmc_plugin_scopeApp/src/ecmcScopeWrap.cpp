@@ -17,17 +17,21 @@
 #include <vector>
 #include <stdexcept>
 #include <string>
+#include <fstream>
+#include <string.h>
 #include "ecmcScopeWrap.h"
+#include "ecmcPluginClient.h"
 #include "ecmcScope.h"
 #include "ecmcScopeDefs.h"
 
 #define ECMC_PLUGIN_PORTNAME_PREFIX "PLUGIN.SCOPE"
-#define ECMC_PLUGIN_SCOPE_ERROR_CODE 1
 
 static std::vector<ecmcScope*>  scopes;
 static int                    scopeObjCounter = 0;
+static ecmcScopeSourceRegistry *sourceRegistry = NULL;
+static ecmcScopeHot            *hotState = NULL;
 
-int createScope(char* configStr) {
+static int createScopeObject(char* configStr) {
 
   // create new ecmcFFT object
   ecmcScope* scope = NULL;
@@ -49,19 +53,104 @@ int createScope(char* configStr) {
   return 0;
 }
 
+/** Remove ECMC_PLUGIN_CONFIG_FILE_OPTION_CMD from configStr (the rest is
+ *  shared defaults). Returns file name or empty string if not defined.
+*/
+static std::string takeConfigFile(char* configStr, std::string *defaults) {
+  std::string fileName;
+  char *pOptions = strdup(configStr);
+  char *pThisOption = pOptions;
+  char *pNextOption = pOptions;
+
+  while((pNextOption = strchr(pNextOption, ';')) != NULL) {
+    *pNextOption = '\0';
+    pNextOption++;
+    if(!strncmp(pThisOption, ECMC_PLUGIN_CONFIG_FILE_OPTION_CMD, strlen(ECMC_PLUGIN_CONFIG_FILE_OPTION_CMD))) {
+      fileName = pThisOption + strlen(ECMC_PLUGIN_CONFIG_FILE_OPTION_CMD);
+    }
+    else if(strlen(pThisOption) > 0) {
+      *defaults += pThisOption;
+      *defaults += ";";
+    }
+    pThisOption = pNextOption;
+  }
+  // Last option (no trailing ';')
+  if(!strncmp(pThisOption, ECMC_PLUGIN_CONFIG_FILE_OPTION_CMD, strlen(ECMC_PLUGIN_CONFIG_FILE_OPTION_CMD))) {
+    fileName = pThisOption + strlen(ECMC_PLUGIN_CONFIG_FILE_OPTION_CMD);
+  }
+  else if(strlen(pThisOption) > 0) {
+    *defaults += pThisOption;
+    *defaults += ";";
+  }
+  free(pOptions);
+  return fileName;
+}
+
+int createScope(char* configStr) {
+  std::string defaults;
+  std::string fileName = takeConfigFile(configStr, &defaults);
+
+  if(fileName.empty()) {
+    return createScopeObject(configStr);
+  }
+
+  // One scope per line: shared defaults first, options of line override
+  std::ifstream file(fileName.c_str());
+  if(!file.is_open()) {
+    printf("Error: Failed open scope config file %s. Plugin will unload.\n",fileName.c_str());
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }
+
+  std::string line;
+  int lineNumber = 0;
+  int created = 0;
+  while(std::getline(file, line)) {
+    lineNumber++;
+    size_t first = line.find_first_not_of(" \t\r");
+    if(first == std::string::npos || line[first] == '#') {
+      continue;
+    }
+    size_t last = line.find_last_not_of(" \t\r");
+    std::string scopeConfig = defaults + line.substr(first, last - first + 1);
+    if(createScopeObject((char*)scopeConfig.c_str())) {
+      printf("Error: Scope config file %s, line %d.\n",fileName.c_str(), lineNumber);
+      return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+    }
+    created++;
+  }
+
+  if(created == 0) {
+    printf("Error: No scopes defined in config file %s. Plugin will unload.\n",fileName.c_str());
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }
+  return 0;
+}
+
 void deleteAllScopes() {
   for(std::vector<ecmcScope*>::iterator pscope = scopes.begin(); pscope != scopes.end(); ++pscope) {
     if(*pscope) {
       delete (*pscope);
     }
   }
+  if(sourceRegistry) {
+    delete sourceRegistry;
+    sourceRegistry = NULL;
+  }
+  if(hotState) {
+    delete hotState;
+    hotState = NULL;
+  }
 }
 
 int  linkDataToScopes() {
+  // One source data history per unique source (shared by all scopes)
+  if(!sourceRegistry) {
+    sourceRegistry = new ecmcScopeSourceRegistry();
+  }
   for(std::vector<ecmcScope*>::iterator pscope = scopes.begin(); pscope != scopes.end(); ++pscope) {
     if(*pscope) {
       try {
-        (*pscope)->connectToDataSources();
+        (*pscope)->connectToDataSources(sourceRegistry);
       }
       catch(std::exception& e) {
         printf("Exception: %s. Plugin will unload.\n",e.what());
@@ -69,6 +158,26 @@ int  linkDataToScopes() {
       }
     }
   }
+
+  // Per cycle hot state of all scopes (contiguous)
+  if(!hotState) {
+    try {
+      hotState = new ecmcScopeHot(scopes.size());
+      for(size_t i = 0; i < scopes.size(); ++i) {
+        scopes[i]->bindHot(hotState, i);
+      }
+    }
+    catch(std::exception& e) {
+      printf("Exception: %s. Plugin will unload.\n",e.what());
+      return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+    }
+  }
+
+  // Asyn params of all scopes are registered, update records once
+  ecmcAsynPortDriver *ecmcAsynPort = (ecmcAsynPortDriver *)getEcmcAsynPortDriver();
+  if(ecmcAsynPort) {
+    ecmcAsynPort->callParamCallbacks(ECMC_ASYN_DEFAULT_LIST, ECMC_ASYN_DEFAULT_ADDR);
+  }
   return 0;
 }
 
@@ -105,13 +214,112 @@ int triggScope(int scopeIndex) {
   return 0;
 }
 
-int executeScopes() {
+int armScope(int scopeIndex, int singleShot) {
+  try {
+    scopes.at(scopeIndex)->armScope(singleShot);
+  }
+  catch(std::exception& e) {
+    printf("Exception: %s. Scope index out of range.\n",e.what());
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }  
+  return 0;
+}
+
+int setScopeMode(int scopeIndex, int mode) {
+  try {
+    scopes.at(scopeIndex)->setMode(mode);
+  }
+  catch(std::exception& e) {
+    printf("Exception: %s. Scope index out of range.\n",e.what());
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }  
+  return 0;
+}
+
+int getScopeStatus(int scopeIndex, int *status) {
+  try {
+    *status = scopes.at(scopeIndex)->getStatus();
+  }
+  catch(std::exception& e) {
+    printf("Exception: %s. Scope index out of range.\n",e.what());
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }  
+  return 0;
+}
+
+int getScopeTriggerCount(int scopeIndex, int *count) {
+  try {
+    *count = scopes.at(scopeIndex)->getTriggerCount();
+  }
+  catch(std::exception& e) {
+    printf("Exception: %s. Scope index out of range.\n",e.what());
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }  
+  return 0;
+}
+
+int getScopeStatistic(int scopeIndex, int stat, double *value) {
+  try {
+    *value = scopes.at(scopeIndex)->getStatistic(stat);
+  }
+  catch(std::exception& e) {
+    printf("Exception: %s.\n",e.what());
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }  
+  return 0;
+}
+
+int getScopeResultElement(int scopeIndex, int element, double *value) {
+  try {
+    if(element < 0) {
+      throw std::out_of_range("ERROR: Result element index out of range.");
+    }
+    *value = scopes.at(scopeIndex)->getResultElement((size_t)element);
+  }
+  catch(std::exception& e) {
+    printf("Exception: %s.\n",e.what());
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }  
+  return 0;
+}
+
+int freezeScope(int scopeIndex) {
+  try {
+    scopes.at(scopeIndex)->freezeRecorder();
+  }
+  catch(std::exception& e) {
+    printf("Exception: %s.\n",e.what());
+    return ECMC_PLUGIN_SCOPE_ERROR_CODE;
+  }  
+  return 0;
+}
+
+int executeScopes(int ecmcError) {
   try {
-    for(std::vector<ecmcScope*>::iterator pscope = scopes.begin(); pscope != scopes.end(); ++pscope) {
-      if(*pscope) {
-        (*pscope)->execute();
+    // New cycle for shared sources (current scan read in place)
+    if(sourceRegistry) {
+      sourceRegistry->update();
+    }
+    // Quiet scopes with unchanged trigger sources only track timebase
+    if(hotState) {
+      hotState->scan();
+    }
+    for(size_t i = 0; i < scopes.size(); ++i) {
+      if(!hotState) {
+        scopes[i]->execute(ecmcError);
+        continue;
       }
-     }
+      if(!hotState->getRun(i)) {
+        continue;
+      }
+      scopes[i]->resume(hotState->startRun(i));
+      scopes[i]->execute(ecmcError);
+      hotState->setQuiet(i, scopes[i]->isQuiet());
+    }
+    // Keep previous scan only of sources with scopes waiting for trigger
+    if(sourceRegistry) {
+      sourceRegistry->commit();
+    }
   }
   catch(std::exception& e) {
     printf("Exception: %s.\n",e.what());
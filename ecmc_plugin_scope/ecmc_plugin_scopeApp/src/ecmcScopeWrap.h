@@ -25,8 +25,23 @@ int         enableScope(int scopeIndex, int enable);
 
 int         triggScope(int scopeIndex);
 
+int         armScope(int scopeIndex, int singleShot);
 
-int         executeScopes();
+int         setScopeMode(int scopeIndex, int mode);
+
+int         getScopeStatus(int scopeIndex, int *status);
+
+int         getScopeTriggerCount(int scopeIndex, int *count);
+
+int         getScopeStatistic(int scopeIndex, int stat, double *value);
+
+int         getScopeResultElement(int scopeIndex, int element, double *value);
+
+
+int         freezeScope(int scopeIndex);
+
+
+int         executeScopes(int ecmcError);
 
 /** \brief Link data to _all_ scope objects
  *
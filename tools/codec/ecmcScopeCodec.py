@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+#
+#  Copyright (c) 2019    European Spallation Source ERIC
+#
+#  Decoder for "plugin.scope<index>.resultcompressed" (pure python, no
+#  dependencies). The format is defined by the encoder in ecmcScopeCodec.h.
+#
+#  Usage as module:
+#    import ecmcScopeCodec
+#    values = ecmcScopeCodec.decode(data)   # data: bytes of the int8 array
+#
+#  Usage as round trip check of files written by ecmcScopeCodecCheck:
+#    python3 ecmcScopeCodec.py <name>.enc <name>.raw [...]
+#
+
+import struct
+import sys
+
+MAGIC = 0x43444353  # "SCDC"
+VERSION = 1
+BLOCK_SIZE = 64
+HEADER = struct.Struct('<IBBBBII')
+
+RAW = 0
+DELTA = 1
+DELTA2 = 2
+
+_FORMATS = {(1, 0): 'B', (1, 1): 'b', (2, 0): 'H', (2, 1): 'h',
+            (4, 0): 'I', (4, 1): 'i', (8, 0): 'Q', (8, 1): 'q'}
+
+
+def decode_header(data):
+    """Returns (codec, elementSize, isSigned, elements, payloadBytes)."""
+    if len(data) < HEADER.size:
+        raise ValueError('Encoded data shorter than header')
+    magic, version, codec, size, signed, elements, payload = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError('Invalid magic or version')
+    if payload > len(data) - HEADER.size or (size, signed) not in _FORMATS:
+        raise ValueError('Invalid payload bytes or element size')
+    return codec, size, signed, elements, payload
+
+
+def decode(data):
+    """Decode encoded bytes. Returns a list of integers."""
+    data = bytes(data)
+    codec, size, signed, elements, payload = decode_header(data)
+    fmt = _FORMATS[(size, signed)]
+    body = data[HEADER.size:HEADER.size + payload]
+
+    if codec == RAW:
+        if payload != elements * size:
+            raise ValueError('Raw payload size mismatch')
+        return list(struct.unpack('<%d%s' % (elements, fmt), body))
+    if codec not in (DELTA, DELTA2):
+        raise ValueError('Unknown codec %d' % codec)
+
+    bits = size * 8
+    out_mask = (1 << bits) - 1
+    sign_bit = 1 << (bits - 1)
+    full = (1 << 64) - 1
+    values = []
+    prev1 = 0
+    prev2 = 0
+    pos = 0
+    for block in range(0, elements, BLOCK_SIZE):
+        count = min(BLOCK_SIZE, elements - block)
+        if pos >= len(body):
+            raise ValueError('Payload ends early')
+        width = body[pos]
+        pos += 1
+        nbytes = (count * width + 7) // 8
+        if width > 64 or len(body) - pos < nbytes:
+            raise ValueError('Invalid block width')
+        packed = int.from_bytes(body[pos:pos + nbytes], 'little')
+        mask = (1 << width) - 1
+        for i in range(count):
+            value = (packed >> (i * width)) & mask
+            residual = (value >> 1) ^ (-(value & 1) & full)  # zigzag
+            if codec == DELTA:
+                prev1 = (prev1 + residual) & full
+            else:
+                current = (2 * prev1 - prev2 + residual) & full
+                prev2 = prev1
+                prev1 = current
+            value = prev1 & out_mask
+            if signed and value & sign_bit:
+                value -= 1 << bits
+            values.append(value)
+        pos += nbytes
+    return values
+
+
+def _check(enc_file, raw_file):
+    with open(enc_file, 'rb') as f:
+        data = f.read()
+    with open(raw_file, 'rb') as f:
+        raw = f.read()
+    codec, size, signed, elements, payload = decode_header(data)
+    expected = list(struct.unpack('<%d%s' % (elements, _FORMATS[(size, signed)]), raw))
+    ok = decode(data) == expected
+    print('%s: %s (codec %d, %d elements, ratio %.2f)' %
+          (enc_file, 'OK' if ok else 'MISMATCH', codec, elements,
+           len(raw) / float(len(data))))
+    return ok
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 3 or len(sys.argv) % 2 != 1:
+        print('Usage: ecmcScopeCodec.py <name>.enc <name>.raw [...]')
+        sys.exit(2)
+    results = [_check(sys.argv[i], sys.argv[i + 1]) for i in range(1, len(sys.argv), 2)]
+    sys.exit(0 if all(results) else 1)
@@ -0,0 +1,189 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeCodecCheck.cpp
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+*  Round trip, ratio and speed check of the scope codec (encoder of the
+*  plugin, decoder of the plugin and the standalone ecmcScopeDecoder.h).
+*  Build and run (from this directory):
+*    g++ -O3 -I../../ecmc_plugin_scope/ecmc_plugin_scopeApp/src \
+*        ecmcScopeCodecCheck.cpp \
+*        ../../ecmc_plugin_scope/ecmc_plugin_scopeApp/src/ecmcScopeCodec.cpp \
+*        -o ecmcScopeCodecCheck
+*    ./ecmcScopeCodecCheck [output dir]
+*  If an output dir is given the encoded and raw data of each case is
+*  written (<case>_<codec>.enc/.raw) for the python decoder check:
+*    python3 ecmcScopeCodec.py <dir>/adc16_delta2.enc <dir>/adc16_delta2.raw ...
+*  Returns 0 if all checks passed, 1 if a round trip failed and 2 if only
+*  the targets of the "adc16" case (ratio >= 3, decode < 1ms) were missed.
+*  The targets are reported, they depend on the signal and the machine.
+*
+\*************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include "ecmcScopeCodec.h"
+#include "ecmcScopeDecoder.h"
+
+static_assert(ECMC_SCOPE_DECODER_MAGIC == ECMC_SCOPE_CODEC_MAGIC, "Codec magic differs");
+static_assert(ECMC_SCOPE_DECODER_VERSION == ECMC_SCOPE_CODEC_VERSION, "Codec version differs");
+static_assert(ECMC_SCOPE_DECODER_BLOCK_SIZE == ECMC_SCOPE_CODEC_BLOCK_SIZE, "Codec block size differs");
+static_assert(ECMC_SCOPE_DECODER_HEADER_BYTES == sizeof(ecmcScopeCodecHeader), "Codec header differs");
+
+#define CHECK_ELEMENTS     100000
+#define CHECK_REPEATS      50
+#define CHECK_DECODE_MS    1.0   // Decode of CHECK_ELEMENTS
+#define CHECK_MIN_RATIO    3.0   // Oversampled adc data (second order delta)
+
+typedef struct {
+  const char *name;
+  size_t      elementSize;
+  int         isSigned;
+  bool        checkTargets;  // Ratio and decode time targets apply
+} checkCase;
+
+static uint32_t prngState = 0x12345678;
+
+// Deterministic noise (xorshift32)
+static uint32_t prng() {
+  prngState ^= prngState << 13;
+  prngState ^= prngState >> 17;
+  prngState ^= prngState << 5;
+  return prngState;
+}
+
+static double nowMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1E3 + ts.tv_nsec / 1E6;
+}
+
+/** Test signals (100kHz sampling):
+ *  adc16      : 16 bit adc, 50Hz full scale sine + 1.3kHz sine, +-4 LSB noise
+ *  adc16quiet : same with +-1 LSB noise
+ *  random16   : full scale random (not compressible, stored raw)
+ *  ramp32     : 32 bit ramp (position like)
+ *  slow8      : 8 bit slow signal
+*/
+static void makeSignal(const checkCase *c, std::vector<uint8_t> &data) {
+  data.resize(CHECK_ELEMENTS * c->elementSize);
+  for(size_t i = 0; i < CHECK_ELEMENTS; ++i) {
+    double t = i / 100E3;
+    int64_t value = 0;
+    if(!strcmp(c->name, "adc16") || !strcmp(c->name, "adc16quiet")) {
+      int noise = !strcmp(c->name, "adc16") ? 4 : 1;
+      value = (int64_t)lround(20000 * sin(2 * M_PI * 50 * t) + 2000 * sin(2 * M_PI * 1300 * t)) +
+              (int64_t)(prng() % (2 * noise + 1)) - noise;
+    }
+    else if(!strcmp(c->name, "random16")) {
+      value = (int16_t)prng();
+    }
+    else if(!strcmp(c->name, "ramp32")) {
+      value = (int64_t)i * 37 - 1000000;
+    }
+    else {
+      value = (int64_t)lround(127 + 100 * sin(2 * M_PI * 10 * t));
+    }
+    memcpy(&data[i * c->elementSize], &value, c->elementSize);  // little endian
+  }
+}
+
+static bool writeFile(const std::string &name, const uint8_t *data, size_t bytes) {
+  FILE *f = fopen(name.c_str(), "wb");
+  if(!f) {
+    return false;
+  }
+  bool ok = fwrite(data, 1, bytes, f) == bytes;
+  fclose(f);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  const checkCase cases[] = {
+    {"adc16",      2, 1, true},
+    {"adc16quiet", 2, 1, false},
+    {"random16",   2, 1, false},
+    {"ramp32",     4, 1, false},
+    {"slow8",      1, 0, false},
+  };
+  const char *outDir = argc > 1 ? argv[1] : NULL;
+  int failed = 0;
+  int missed = 0;
+
+  printf("%-11s %-6s %8s %8s %11s %11s %11s  %s\n", "case", "codec", "bytes", "ratio",
+         "encode[ms]", "decode[ms]", "header[ms]", "result");
+
+  for(size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+    std::vector<uint8_t> data;
+    makeSignal(&cases[c], data);
+    size_t maxBytes = ecmcScopeCodecMaxBytes(CHECK_ELEMENTS, cases[c].elementSize);
+    std::vector<uint8_t> encoded(maxBytes);
+    std::vector<uint8_t> decoded(data.size());
+    std::vector<uint8_t> decodedHeader(data.size());
+
+    for(int codec = ECMC_SCOPE_CODEC_DELTA; codec <= ECMC_SCOPE_CODEC_DELTA2; ++codec) {
+      size_t bytes = 0;
+      double encodeMs = 1E9, decodeMs = 1E9, headerMs = 1E9;
+      bool   ok = true;
+
+      // Best of CHECK_REPEATS (cold caches not included)
+      for(int r = 0; r < CHECK_REPEATS; ++r) {
+        double start = nowMs();
+        bytes = ecmcScopeCodecEncode(&data[0], CHECK_ELEMENTS, cases[c].elementSize,
+                                     cases[c].isSigned, codec, &encoded[0], maxBytes);
+        double mid = nowMs();
+        size_t elements = 0;
+        ok &= ecmcScopeCodecDecode(&encoded[0], bytes, &decoded[0], decoded.size(), &elements) == 0;
+        double end = nowMs();
+        ok &= ecmcScopeDecode(&encoded[0], bytes, &decodedHeader[0], decodedHeader.size(), &elements) == 0;
+        double endHeader = nowMs();
+        ok &= elements == CHECK_ELEMENTS;
+        encodeMs = fmin(encodeMs, mid - start);
+        decodeMs = fmin(decodeMs, end - mid);
+        headerMs = fmin(headerMs, endHeader - end);
+      }
+      ok &= bytes > 0 && decoded == data && decodedHeader == data;
+
+      double ratio = bytes ? (double)data.size() / bytes : 0;
+      std::string result = ok ? "OK" : "ROUND TRIP FAILED";
+      failed += !ok;
+      if(ok && cases[c].checkTargets && codec == ECMC_SCOPE_CODEC_DELTA2) {
+        if(ratio < CHECK_MIN_RATIO) {
+          missed++;
+          result = "OK, RATIO TARGET MISSED";
+        }
+        else if(decodeMs >= CHECK_DECODE_MS || headerMs >= CHECK_DECODE_MS) {
+          missed++;
+          result = "OK, DECODE TIME TARGET MISSED";
+        }
+        else {
+          result = "OK, TARGETS MET";
+        }
+      }
+      printf("%-11s %-6s %8zu %8.2f %11.3f %11.3f %11.3f  %s\n", cases[c].name,
+             codec == ECMC_SCOPE_CODEC_DELTA ? "delta" : "delta2", bytes, ratio,
+             encodeMs, decodeMs, headerMs, result.c_str());
+
+      if(outDir && bytes) {
+        std::string name = std::string(outDir) + "/" + cases[c].name +
+                           (codec == ECMC_SCOPE_CODEC_DELTA ? "_delta" : "_delta2");
+        if(!writeFile(name + ".enc", &encoded[0], bytes) ||
+           !writeFile(name + ".raw", &data[0], data.size())) {
+          printf("Failed write %s.enc/.raw\n", name.c_str());
+          failed++;
+        }
+      }
+    }
+  }
+  printf("%s\n", failed ? "FAILED" : missed ? "PASSED (TARGETS MISSED)" : "PASSED");
+  return failed ? 1 : missed ? 2 : 0;
+}
@@ -0,0 +1,200 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcScopeDecoder.h
+*
+*  Created on: Oct 19, 2026
+*      Author: anderssandstrom
+*
+*  Standalone decoder for "plugin.scope<index>.resultcompressed" (header
+*  only, C99 or C++, no dependencies to ecmc, EPICS or the plugin sources).
+*  Copy this file to the client and call ecmcScopeDecode().
+*  The format is defined by the encoder in ecmcScopeCodec.h/.cpp, the
+*  constants below must match it (checked by ecmcScopeCodecCheck.cpp).
+*
+\*************************************************************************/
+#ifndef ECMC_SCOPE_DECODER_H_
+#define ECMC_SCOPE_DECODER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define ECMC_SCOPE_DECODER_MAGIC        0x43444353  /* "SCDC" */
+#define ECMC_SCOPE_DECODER_VERSION      1
+#define ECMC_SCOPE_DECODER_BLOCK_SIZE   64
+#define ECMC_SCOPE_DECODER_HEADER_BYTES 16
+
+#define ECMC_SCOPE_DECODER_RAW    0
+#define ECMC_SCOPE_DECODER_DELTA  1
+#define ECMC_SCOPE_DECODER_DELTA2 2
+
+/** Header in front of all encoded data (little endian, 16 bytes)*/
+typedef struct {
+  uint32_t magic;
+  uint8_t  version;
+  uint8_t  codec;
+  uint8_t  elementSize;
+  uint8_t  isSigned;
+  uint32_t elements;
+  uint32_t payloadBytes;
+} ecmcScopeDecoderHeader;
+
+static inline uint32_t ecmcScopeDecoderLoad32(const uint8_t *src) {
+  return (uint32_t)src[0] | ((uint32_t)src[1] << 8) |
+         ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+// Load up to 8 bytes (zero padded at end of buffer)
+static inline uint64_t ecmcScopeDecoderLoad64(const uint8_t *src, const uint8_t *end) {
+  uint64_t value = 0;
+  size_t   bytes = (size_t)(end - src) < 8 ? (size_t)(end - src) : 8;
+  size_t   i;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if(bytes == 8) {
+    memcpy(&value, src, 8);
+    return value;
+  }
+#endif
+  for(i = 0; i < bytes; ++i) {
+    value |= ((uint64_t)src[i]) << (8 * i);
+  }
+  return value;
+}
+
+static inline void ecmcScopeDecoderStore(uint8_t *dst, uint64_t value, size_t bytes) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  memcpy(dst, &value, bytes);
+#else
+  size_t i;
+  for(i = 0; i < bytes; ++i) {
+    dst[i] = (uint8_t)(value >> (8 * i));
+  }
+#endif
+}
+
+/** \brief Read header of encoded data\n
+ *
+ *  \return 0 if valid header or otherwise an error code.\n
+ */
+static inline int ecmcScopeDecodeHeader(const uint8_t          *src,
+                                        size_t                  srcBytes,
+                                        ecmcScopeDecoderHeader *header) {
+  if(!src || !header || srcBytes < ECMC_SCOPE_DECODER_HEADER_BYTES) {
+    return 1;
+  }
+  header->magic        = ecmcScopeDecoderLoad32(src);
+  header->version      = src[4];
+  header->codec        = src[5];
+  header->elementSize  = src[6];
+  header->isSigned     = src[7];
+  header->elements     = ecmcScopeDecoderLoad32(src + 8);
+  header->payloadBytes = ecmcScopeDecoderLoad32(src + 12);
+  if(header->magic != ECMC_SCOPE_DECODER_MAGIC ||
+     header->version != ECMC_SCOPE_DECODER_VERSION ||
+     header->payloadBytes > srcBytes - ECMC_SCOPE_DECODER_HEADER_BYTES) {
+    return 1;
+  }
+  if(header->elementSize != 1 && header->elementSize != 2 &&
+     header->elementSize != 4 && header->elementSize != 8) {
+    return 1;
+  }
+  return 0;
+}
+
+/** \brief Decode data\n
+ *
+ *  Output is little endian elements of header element size.\n
+ *
+ *  \param[in] src Encoded data (including header).\n
+ *  \param[in] srcBytes Bytes of encoded data.\n
+ *  \param[out] dst Destination buffer.\n
+ *  \param[in] dstBytes Size of destination buffer.\n
+ *  \param[out] elements Decoded element count (may be NULL).\n
+ *  \return 0 if success or otherwise an error code.\n
+ */
+static inline int ecmcScopeDecode(const uint8_t *src,
+                                  size_t         srcBytes,
+                                  uint8_t       *dst,
+                                  size_t         dstBytes,
+                                  size_t        *elements) {
+  ecmcScopeDecoderHeader header;
+  const uint8_t *pos;
+  const uint8_t *end;
+  uint64_t       prev1 = 0;
+  uint64_t       prev2 = 0;
+  size_t         block;
+
+  if(!dst || ecmcScopeDecodeHeader(src, srcBytes, &header) ||
+     (size_t)header.elements * header.elementSize > dstBytes) {
+    return 1;
+  }
+  pos = src + ECMC_SCOPE_DECODER_HEADER_BYTES;
+  end = pos + header.payloadBytes;
+
+  if(header.codec == ECMC_SCOPE_DECODER_RAW) {
+    if(header.payloadBytes != (size_t)header.elements * header.elementSize) {
+      return 1;
+    }
+    memcpy(dst, pos, header.payloadBytes);
+  }
+  else if(header.codec == ECMC_SCOPE_DECODER_DELTA ||
+          header.codec == ECMC_SCOPE_DECODER_DELTA2) {
+    for(block = 0; block < header.elements; block += ECMC_SCOPE_DECODER_BLOCK_SIZE) {
+      size_t       count = header.elements - block;
+      size_t       bitPos = 0;
+      size_t       bytes;
+      size_t       i;
+      unsigned int width;
+      uint64_t     mask;
+      if(count > ECMC_SCOPE_DECODER_BLOCK_SIZE) {
+        count = ECMC_SCOPE_DECODER_BLOCK_SIZE;
+      }
+      if(pos >= end) {
+        return 1;
+      }
+      width = *pos++;
+      bytes = (count * width + 7) / 8;
+      if(width > 64 || (size_t)(end - pos) < bytes) {
+        return 1;
+      }
+      mask = width == 64 ? ~(uint64_t)0 : (((uint64_t)1) << width) - 1;
+      for(i = 0; i < count; ++i) {
+        uint64_t residual = 0;
+        if(width) {
+          const uint8_t *p     = pos + (bitPos >> 3);
+          unsigned int   shift = bitPos & 7;
+          uint64_t       value = ecmcScopeDecoderLoad64(p, end) >> shift;
+          if(shift + width > 64) {
+            value |= ecmcScopeDecoderLoad64(p + 8, end) << (64 - shift);
+          }
+          value   &= mask;
+          residual = (value >> 1) ^ (~(value & 1) + 1);  // zigzag
+          bitPos  += width;
+        }
+        if(header.codec == ECMC_SCOPE_DECODER_DELTA) {
+          prev1 += residual;
+        }
+        else {
+          uint64_t current = 2 * prev1 - prev2 + residual;
+          prev2 = prev1;
+          prev1 = current;
+        }
+        ecmcScopeDecoderStore(&dst[(block + i) * header.elementSize], prev1, header.elementSize);
+      }
+      pos += bytes;
+    }
+  }
+  else {
+    return 1;
+  }
+
+  if(elements) {
+    *elements = header.elements;
+  }
+  return 0;
+}
+
+#endif  /* ECMC_SCOPE_DECODER_H_ */